@@ -128,6 +128,46 @@ int16_t sensirion_uart_rx(uint16_t max_data_len, uint8_t* data) {
     return i;
 }
 
+/**
+ * sensirion_uart_rx_timeout() - receive data over UART, waiting for it
+ *                               NOT NEEDED WITH SENSIRION_SHDLC_FIXED_RX_DELAY
+ *
+ * Block until at least one byte arrived or the timeout expired, whichever
+ * happens first, then receive the bytes available without waiting any further.
+ * Must never block longer than the timeout, e.g. when the sensor stopped
+ * responding.
+ *
+ * @max_data_len: max number of bytes to receive
+ * @data:       Memory where received data is stored
+ * @timeout_us: max time to wait for the first byte in microseconds
+ * Return:      Number of bytes received, 0 on timeout or a negative error code
+ */
+int16_t sensirion_uart_rx_timeout(uint16_t max_data_len, uint8_t* data,
+                                  uint32_t timeout_us) {
+    uint32_t start = micros();
+
+    while (Serial2.available() <= 0) {
+        if (micros() - start >= timeout_us)
+            return 0;
+    }
+    return sensirion_uart_rx(max_data_len, data);
+}
+
+/**
+ * sensirion_uart_wait_device() - wait for the device of the selected port
+ *                                MAY RETURN 0 AT ONCE ON SETUPS WITHOUT
+ *                                HOT-PLUGGED UARTS
+ *
+ * Block until the UART device is present, e.g. after a USB serial adapter
+ * was plugged in, or the timeout expired.
+ *
+ * @timeout_us: max time to wait in microseconds
+ * Return:      0 when the device is present, a negative error code otherwise
+ */
+int16_t sensirion_uart_wait_device(uint32_t timeout_us) {
+    return 0;
+}
+
 /**
  * Sleep for a given number of microseconds. The function should delay the
  * execution for at least the given time, but may also sleep longer.
@@ -139,6 +179,19 @@ int16_t sensirion_uart_rx(uint16_t max_data_len, uint8_t* data) {
 void sensirion_sleep_usec(uint32_t useconds) {
     delay((useconds / 1000) + 1);
 }
+/**
+ * sensirion_time_usec() - read a monotonic clock
+ *                         NOT NEEDED WITH SENSIRION_SHDLC_FIXED_RX_DELAY
+ *
+ * The clock may start at any value and wraps around. The time limits of SHDLC
+ * responses are measured with it.
+ *
+ * Return:      Time in microseconds
+ */
+uint32_t sensirion_time_usec(void) {
+    return micros();
+}
+
 
 #ifdef __cplusplus
 }  // extern "C"
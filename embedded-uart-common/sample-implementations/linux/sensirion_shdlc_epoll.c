@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sensirion_shdlc_epoll.h"
+#include "sensirion_arch_config.h"
+#include "sensirion_shdlc.h"
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <time.h>
+#include <unistd.h>
+
+/** Readiness events handled per epoll_wait() call */
+#define SHDLC_EPOLL_MAX_EVENTS 32
+
+static uint64_t sensirion_shdlc_epoll_now_us(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+int16_t sensirion_shdlc_epoll_init(struct sensirion_shdlc_epoll* loop) {
+    loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    return loop->epoll_fd < 0 ? -1 : 0;
+}
+
+void sensirion_shdlc_epoll_close(struct sensirion_shdlc_epoll* loop) {
+    if (loop->epoll_fd >= 0)
+        close(loop->epoll_fd);
+    loop->epoll_fd = -1;
+}
+
+int16_t sensirion_shdlc_epoll_add(struct sensirion_shdlc_epoll* loop,
+                                  struct sensirion_shdlc_epoll_port* port) {
+    struct epoll_event event;
+
+    port->status = 0;
+    event.events = EPOLLIN;
+    event.data.ptr = port;
+    return epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, port->fd, &event) ? -1 : 0;
+}
+
+int16_t sensirion_shdlc_epoll_remove(struct sensirion_shdlc_epoll* loop,
+                                     struct sensirion_shdlc_epoll_port* port) {
+    return epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, port->fd, NULL) ? -1 : 0;
+}
+
+/**
+ * Feed the bytes available on a readable port to its decoder.
+ * Return: 1 if the transaction of the port completed, 0 otherwise
+ */
+static uint8_t
+sensirion_shdlc_epoll_rx(struct sensirion_shdlc_epoll_port* port) {
+    uint8_t buf[256];
+    uint16_t consumed;
+    ssize_t len;
+    int16_t ret;
+
+    len = read(port->fd, buf, sizeof(buf));
+    if (len < 0 && (errno == EAGAIN || errno == EINTR))
+        return 0;
+    if (port->status != SENSIRION_SHDLC_RX_INCOMPLETE)
+        return 0; /* not part of the transaction, drop */
+    if (len <= 0) {
+        /* read error or hang-up */
+        port->status = -1;
+        return 1;
+    }
+
+    port->rx_len = (uint16_t)(port->rx_len + len);
+    ret = sensirion_shdlc_rx_decode(&port->decoder, (uint16_t)len, buf,
+                                    &consumed);
+    if (ret == SENSIRION_SHDLC_RX_INCOMPLETE)
+        return 0;
+    port->status = ret;
+    return 1;
+}
+
+int16_t sensirion_shdlc_epoll_xcv(struct sensirion_shdlc_epoll* loop,
+                                  uint16_t port_count,
+                                  struct sensirion_shdlc_epoll_port* ports,
+                                  uint32_t rx_timeout_us) {
+    struct epoll_event events[SHDLC_EPOLL_MAX_EVENTS];
+    struct sensirion_shdlc_epoll_port* port;
+    uint64_t deadline;
+    uint64_t now;
+    uint16_t pending = 0;
+    uint16_t i;
+    ssize_t len;
+    int n;
+
+    for (i = 0; i < port_count; ++i) {
+        port = &ports[i];
+        port->rx_len = 0;
+        sensirion_shdlc_rx_decoder_init(&port->decoder, port->max_rx_data_len,
+                                        &port->rx_header, port->rx_data);
+        len = write(port->fd, port->tx_frame, port->tx_frame_len);
+        if (len < 0) {
+            port->status = -1;
+        } else if (len != port->tx_frame_len) {
+            port->status = SENSIRION_SHDLC_ERR_TX_INCOMPLETE;
+        } else {
+            port->status = SENSIRION_SHDLC_RX_INCOMPLETE;
+            ++pending;
+        }
+    }
+
+    deadline = sensirion_shdlc_epoll_now_us() + rx_timeout_us;
+    while (pending) {
+        now = sensirion_shdlc_epoll_now_us();
+        if (now >= deadline)
+            break;
+
+        /* round up, epoll_wait() has a millisecond resolution */
+        n = epoll_wait(loop->epoll_fd, events, SHDLC_EPOLL_MAX_EVENTS,
+                       (int)((deadline - now + 999) / 1000));
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        while (n--) {
+            port = (struct sensirion_shdlc_epoll_port*)events[n].data.ptr;
+            pending -= sensirion_shdlc_epoll_rx(port);
+        }
+    }
+
+    for (i = 0; i < port_count; ++i) {
+        if (ports[i].status == SENSIRION_SHDLC_RX_INCOMPLETE)
+            ports[i].status = ports[i].rx_len
+                                  ? SENSIRION_SHDLC_ERR_MISSING_STOP
+                                  : SENSIRION_SHDLC_ERR_MISSING_START;
+    }
+    for (i = 0; i < port_count; ++i) {
+        if (ports[i].status != 0)
+            return ports[i].status;
+    }
+    return 0;
+}
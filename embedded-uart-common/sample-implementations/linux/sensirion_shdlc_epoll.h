@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SENSIRION_SHDLC_EPOLL_H
+#define SENSIRION_SHDLC_EPOLL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sensirion_arch_config.h"
+#include "sensirion_shdlc.h"
+
+/**
+ * Event loop running SHDLC transactions on many ports at once: all frames are
+ * transmitted first, then each response is decoded as its port becomes
+ * readable. Polling N sensors thus takes about one round trip instead of N.
+ */
+struct sensirion_shdlc_epoll {
+    int epoll_fd;
+};
+
+/**
+ * A port of the event loop and its current transaction. Set fd before
+ * sensirion_shdlc_epoll_add() and the transaction fields before each
+ * sensirion_shdlc_epoll_xcv(), the other fields are private.
+ *
+ * @fd:             file descriptor of the open serial port
+ * @tx_frame_len:   length of the encoded frame to send
+ * @tx_frame:       byte-stuffed frame including start and stop bytes, e.g. a
+ *                  precomputed frame or one from sensirion_shdlc_encode()
+ * @max_rx_data_len: max data length to receive
+ * @rx_data:        Memory where the received data is stored
+ * @rx_header:      Set to the header of the response
+ * @status:         Set to 0 when the response was received, an error code
+ *                  otherwise. rx_header and rx_data must be discarded on
+ *                  failure.
+ */
+struct sensirion_shdlc_epoll_port {
+    int fd;
+    uint16_t tx_frame_len;
+    const uint8_t* tx_frame;
+    uint8_t max_rx_data_len;
+    uint8_t* rx_data;
+    struct sensirion_shdlc_rx_header rx_header;
+    int16_t status;
+
+    struct sensirion_shdlc_rx_decoder decoder;
+    uint16_t rx_len;
+};
+
+/**
+ * sensirion_shdlc_epoll_init() - create an event loop
+ *
+ * Return:      0 on success, -1 otherwise
+ */
+int16_t sensirion_shdlc_epoll_init(struct sensirion_shdlc_epoll* loop);
+
+/**
+ * sensirion_shdlc_epoll_close() - close an event loop
+ *
+ * The ports' file descriptors are not closed.
+ */
+void sensirion_shdlc_epoll_close(struct sensirion_shdlc_epoll* loop);
+
+/**
+ * sensirion_shdlc_epoll_add() - register a port with the event loop
+ *
+ * The port must stay valid until it is removed or the loop is closed.
+ *
+ * Return:      0 on success, -1 otherwise
+ */
+int16_t sensirion_shdlc_epoll_add(struct sensirion_shdlc_epoll* loop,
+                                  struct sensirion_shdlc_epoll_port* port);
+
+/**
+ * sensirion_shdlc_epoll_remove() - unregister a port from the event loop
+ *
+ * Return:      0 on success, -1 otherwise
+ */
+int16_t sensirion_shdlc_epoll_remove(struct sensirion_shdlc_epoll* loop,
+                                     struct sensirion_shdlc_epoll_port* port);
+
+/**
+ * sensirion_shdlc_epoll_xcv() - transceive a frame on several ports at once
+ *
+ * Transmits the frame of each port, then receives the responses in whichever
+ * order they arrive until all of them are complete or the timeout expired.
+ * Bytes received beyond the end of a response and bytes arriving on registered
+ * ports which are not part of the call are dropped.
+ *
+ * @loop:           Event loop the ports are registered with
+ * @port_count:     number of ports
+ * @ports:          ports and their transactions, the result of each is stored
+ *                  in its status
+ * @rx_timeout_us:  Time to wait for all responses in microseconds
+ * Return:          0 when all responses were received, the first error code
+ *                  of the transactions otherwise
+ */
+int16_t sensirion_shdlc_epoll_xcv(struct sensirion_shdlc_epoll* loop,
+                                  uint16_t port_count,
+                                  struct sensirion_shdlc_epoll_port* ports,
+                                  uint32_t rx_timeout_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSIRION_SHDLC_EPOLL_H */
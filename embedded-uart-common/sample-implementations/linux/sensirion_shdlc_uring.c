@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sensirion_shdlc_uring.h"
+#include "sensirion_arch_config.h"
+#include "sensirion_shdlc.h"
+
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/* submission queue entries per port and round: write, poll, timeout, read */
+#define SHDLC_URING_SQES_PER_PORT 4
+
+enum sensirion_shdlc_uring_op {
+    SHDLC_URING_OP_WRITE,
+    SHDLC_URING_OP_POLL,
+    SHDLC_URING_OP_TIMEOUT,
+    SHDLC_URING_OP_READ,
+};
+
+static uint64_t sensirion_shdlc_uring_now_us(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void sensirion_shdlc_uring_unmap(struct sensirion_shdlc_uring* loop) {
+    if (loop->sqes)
+        munmap(loop->sqes, loop->sqes_size);
+    if (loop->cq_ring && loop->cq_ring != loop->sq_ring)
+        munmap(loop->cq_ring, loop->cq_ring_size);
+    if (loop->sq_ring)
+        munmap(loop->sq_ring, loop->sq_ring_size);
+    loop->sqes = NULL;
+    loop->cq_ring = NULL;
+    loop->sq_ring = NULL;
+}
+
+static void* sensirion_shdlc_uring_map(int fd, size_t size, off_t offset) {
+    void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, offset);
+
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+int16_t sensirion_shdlc_uring_init(struct sensirion_shdlc_uring* loop,
+                                   uint16_t max_ports) {
+    struct io_uring_params params;
+    uint8_t* sq;
+    uint8_t* cq;
+
+    memset(loop, 0, sizeof(*loop));
+    memset(&params, 0, sizeof(params));
+    loop->max_ports = max_ports;
+    loop->ring_fd = (int)syscall(
+        __NR_io_uring_setup,
+        (unsigned)max_ports * SHDLC_URING_SQES_PER_PORT, &params);
+    if (loop->ring_fd < 0)
+        return -1;
+
+    loop->sq_ring_size =
+        params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    loop->cq_ring_size =
+        params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (loop->cq_ring_size > loop->sq_ring_size)
+            loop->sq_ring_size = loop->cq_ring_size;
+        loop->cq_ring_size = loop->sq_ring_size;
+    }
+    loop->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+
+    loop->sq_ring = sensirion_shdlc_uring_map(loop->ring_fd, loop->sq_ring_size,
+                                              IORING_OFF_SQ_RING);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+        loop->cq_ring = loop->sq_ring;
+    else
+        loop->cq_ring = sensirion_shdlc_uring_map(
+            loop->ring_fd, loop->cq_ring_size, IORING_OFF_CQ_RING);
+    loop->sqes = sensirion_shdlc_uring_map(loop->ring_fd, loop->sqes_size,
+                                           IORING_OFF_SQES);
+    if (!loop->sq_ring || !loop->cq_ring || !loop->sqes) {
+        sensirion_shdlc_uring_close(loop);
+        return -1;
+    }
+
+    sq = (uint8_t*)loop->sq_ring;
+    cq = (uint8_t*)loop->cq_ring;
+    loop->sq_tail = (uint32_t*)(sq + params.sq_off.tail);
+    loop->sq_array = (uint32_t*)(sq + params.sq_off.array);
+    loop->sq_mask = *(uint32_t*)(sq + params.sq_off.ring_mask);
+    loop->cq_head = (uint32_t*)(cq + params.cq_off.head);
+    loop->cq_tail = (uint32_t*)(cq + params.cq_off.tail);
+    loop->cq_mask = *(uint32_t*)(cq + params.cq_off.ring_mask);
+    loop->cqes = cq + params.cq_off.cqes;
+    return 0;
+}
+
+void sensirion_shdlc_uring_close(struct sensirion_shdlc_uring* loop) {
+    sensirion_shdlc_uring_unmap(loop);
+    if (loop->ring_fd >= 0)
+        close(loop->ring_fd);
+    loop->ring_fd = -1;
+}
+
+/* queue an entry, the ring has room for all entries of a round */
+static struct io_uring_sqe*
+sensirion_shdlc_uring_sqe(struct sensirion_shdlc_uring* loop, uint32_t* tail,
+                          uint8_t opcode, int fd, uint16_t port, uint8_t op) {
+    uint32_t index = *tail & loop->sq_mask;
+    struct io_uring_sqe* sqe = &((struct io_uring_sqe*)loop->sqes)[index];
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->flags = IOSQE_IO_LINK;
+    sqe->user_data = (uint64_t)port * SHDLC_URING_SQES_PER_PORT + op;
+    loop->sq_array[index] = index;
+    ++*tail;
+    return sqe;
+}
+
+/* queue writing the frame of a port, linked to the chain of its first read */
+static void
+sensirion_shdlc_uring_queue_tx(struct sensirion_shdlc_uring* loop,
+                              uint32_t* tail,
+                              struct sensirion_shdlc_uring_port* port,
+                              uint16_t i) {
+    struct io_uring_sqe* sqe;
+
+    sqe = sensirion_shdlc_uring_sqe(loop, tail, IORING_OP_WRITE, port->fd, i,
+                                    SHDLC_URING_OP_WRITE);
+    sqe->addr = (uint64_t)(uintptr_t)port->tx_frame;
+    sqe->len = port->tx_frame_len;
+    sqe->off = (uint64_t)-1;
+}
+
+/* queue a poll for input with the linked timeout, followed by the read */
+static void
+sensirion_shdlc_uring_queue_rx(struct sensirion_shdlc_uring* loop,
+                              uint32_t* tail,
+                              struct sensirion_shdlc_uring_port* port,
+                              uint16_t i) {
+    struct io_uring_sqe* sqe;
+
+    sqe = sensirion_shdlc_uring_sqe(loop, tail, IORING_OP_POLL_ADD, port->fd,
+                                    i, SHDLC_URING_OP_POLL);
+    sqe->poll32_events = POLLIN;
+    sqe = sensirion_shdlc_uring_sqe(loop, tail, IORING_OP_LINK_TIMEOUT, -1, i,
+                                    SHDLC_URING_OP_TIMEOUT);
+    sqe->addr = (uint64_t)(uintptr_t)loop->timeout;
+    sqe->len = 1;
+    sqe = sensirion_shdlc_uring_sqe(loop, tail, IORING_OP_READ, port->fd, i,
+                                    SHDLC_URING_OP_READ);
+    sqe->addr = (uint64_t)(uintptr_t)port->rx_buf;
+    sqe->len = sizeof(port->rx_buf);
+    sqe->off = (uint64_t)-1;
+    sqe->flags = 0; /* ends the chain */
+}
+
+static void
+sensirion_shdlc_uring_set_timeout(struct sensirion_shdlc_uring* loop,
+                                  uint64_t deadline) {
+    uint64_t now = sensirion_shdlc_uring_now_us();
+    uint64_t timeout_us = now < deadline ? deadline - now : 0;
+
+    loop->timeout[0] = (int64_t)(timeout_us / 1000000);
+    loop->timeout[1] = (int64_t)(timeout_us % 1000000) * 1000;
+}
+
+/**
+ * Handle a completion.
+ * Return: 1 if the transaction of the port completed, 0 if not, -1 if the port
+ *         needs to read again
+ */
+static int8_t
+sensirion_shdlc_uring_complete(struct sensirion_shdlc_uring_port* port,
+                               uint8_t op, int32_t res) {
+    uint16_t consumed;
+    int16_t ret;
+
+    if (port->status != SENSIRION_SHDLC_RX_INCOMPLETE)
+        return 0;
+
+    switch (op) {
+        case SHDLC_URING_OP_WRITE:
+            if (res == port->tx_frame_len)
+                return 0;
+            port->status = res < 0 ? -1 : SENSIRION_SHDLC_ERR_TX_INCOMPLETE;
+            return 1;
+
+        case SHDLC_URING_OP_READ:
+            /* cancelled when the linked timeout expired */
+            if (res == -ECANCELED)
+                return 0;
+            if (res == 0 || res == -EINTR || res == -EAGAIN)
+                return -1;
+            if (res < 0) {
+                port->status = -1;
+                return 1;
+            }
+            port->rx_len = (uint16_t)(port->rx_len + res);
+            ret = sensirion_shdlc_rx_decode(&port->decoder, (uint16_t)res,
+                                            port->rx_buf, &consumed);
+            if (ret == SENSIRION_SHDLC_RX_INCOMPLETE)
+                return -1;
+            port->status = ret;
+            return 1;
+
+        default:
+            /* poll and timeout only gate the read */
+            return 0;
+    }
+}
+
+int16_t sensirion_shdlc_uring_xcv(struct sensirion_shdlc_uring* loop,
+                                  uint16_t port_count,
+                                  struct sensirion_shdlc_uring_port* ports,
+                                  uint32_t rx_timeout_us) {
+    const struct io_uring_cqe* cqes = (const struct io_uring_cqe*)loop->cqes;
+    const struct io_uring_cqe* cqe;
+    struct sensirion_shdlc_uring_port* port;
+    uint64_t deadline;
+    uint32_t tail;
+    uint32_t head;
+    uint32_t submit;
+    uint32_t in_flight = 0;
+    int16_t error = 0;
+    uint16_t i;
+    int8_t ret;
+    long n;
+
+    /* closed after a failure, see below */
+    if (loop->ring_fd < 0 || port_count > loop->max_ports)
+        return -1;
+
+    tail = *loop->sq_tail;
+
+    deadline = sensirion_shdlc_uring_now_us() + rx_timeout_us;
+    sensirion_shdlc_uring_set_timeout(loop, deadline);
+    for (i = 0; i < port_count; ++i) {
+        port = &ports[i];
+        port->rx_len = 0;
+        port->status = SENSIRION_SHDLC_RX_INCOMPLETE;
+        sensirion_shdlc_rx_decoder_init(&port->decoder, port->max_rx_data_len,
+                                        &port->rx_header, port->rx_data);
+        sensirion_shdlc_uring_queue_tx(loop, &tail, port, i);
+        sensirion_shdlc_uring_queue_rx(loop, &tail, port, i);
+    }
+    submit = (uint32_t)port_count * SHDLC_URING_SQES_PER_PORT;
+
+    /* every chain ends by the deadline, run until all of them completed */
+    while (submit || in_flight) {
+        __atomic_store_n(loop->sq_tail, tail, __ATOMIC_RELEASE);
+        in_flight += submit;
+        n = syscall(__NR_io_uring_enter, loop->ring_fd, submit, 1,
+                    IORING_ENTER_GETEVENTS, NULL, 0);
+        ++loop->enters;
+        if (n < 0 && errno != EINTR) {
+            in_flight -= submit;
+            /* the kernel took none of the entries, drop them */
+            tail -= submit;
+            __atomic_store_n(loop->sq_tail, tail, __ATOMIC_RELEASE);
+            submit = 0;
+            if (error) {
+                /* the chains in flight could still complete into the
+                 * ports, or into those of a later call, give up the ring */
+                sensirion_shdlc_uring_close(loop);
+                break;
+            }
+            /* wait for the chains in flight, they end by the deadline */
+            error = -1;
+        }
+        if (n > 0)
+            submit -= (uint32_t)n;
+        in_flight -= submit;
+
+        sensirion_shdlc_uring_set_timeout(loop, deadline);
+        head = *loop->cq_head;
+        while (head != __atomic_load_n(loop->cq_tail, __ATOMIC_ACQUIRE)) {
+            cqe = &cqes[head++ & loop->cq_mask];
+            --in_flight;
+            port = &ports[cqe->user_data / SHDLC_URING_SQES_PER_PORT];
+            ret = sensirion_shdlc_uring_complete(
+                port, (uint8_t)(cqe->user_data % SHDLC_URING_SQES_PER_PORT),
+                cqe->res);
+            /* read the rest of the frame while there is time left */
+            if (ret < 0 && !error &&
+                sensirion_shdlc_uring_now_us() < deadline) {
+                sensirion_shdlc_uring_queue_rx(
+                    loop, &tail, port,
+                    (uint16_t)(cqe->user_data / SHDLC_URING_SQES_PER_PORT));
+                submit += SHDLC_URING_SQES_PER_PORT - 1;
+            }
+        }
+        __atomic_store_n(loop->cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    for (i = 0; i < port_count; ++i) {
+        if (ports[i].status == SENSIRION_SHDLC_RX_INCOMPLETE)
+            ports[i].status = ports[i].rx_len
+                                  ? SENSIRION_SHDLC_ERR_MISSING_STOP
+                                  : SENSIRION_SHDLC_ERR_MISSING_START;
+    }
+    if (error)
+        return error;
+    for (i = 0; i < port_count; ++i) {
+        if (ports[i].status != 0)
+            return ports[i].status;
+    }
+    return 0;
+}
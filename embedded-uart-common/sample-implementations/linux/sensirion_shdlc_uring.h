@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SENSIRION_SHDLC_URING_H
+#define SENSIRION_SHDLC_URING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "sensirion_arch_config.h"
+#include "sensirion_shdlc.h"
+
+/**
+ * io_uring based alternative to sensirion_shdlc_epoll.h for many ports (Linux
+ * 5.6 or newer): the frames of all ports and the reads of the responses are
+ * submitted together, each read is preceded by a poll with a linked timeout.
+ * A sweep over N ports thus takes one io_uring_enter() call per chunk of the
+ * responses instead of at least 2N read/write calls.
+ *
+ * The fields are private except for the statistics
+ *
+ * @enters:     Number of io_uring_enter() calls since initialization
+ */
+struct sensirion_shdlc_uring {
+    int ring_fd;
+    uint32_t enters;
+
+    uint16_t max_ports;
+    void* sq_ring;
+    size_t sq_ring_size;
+    void* cq_ring;
+    size_t cq_ring_size;
+    void* sqes;
+    size_t sqes_size;
+    uint32_t* sq_tail;
+    uint32_t* sq_array;
+    uint32_t sq_mask;
+    uint32_t* cq_head;
+    uint32_t* cq_tail;
+    uint32_t cq_mask;
+    void* cqes;
+    int64_t timeout[2];
+};
+
+/**
+ * A port and its current transaction, see struct sensirion_shdlc_epoll_port.
+ * Set the transaction fields before each sensirion_shdlc_uring_xcv(), the
+ * other fields are private.
+ *
+ * @fd:             file descriptor of the open serial port
+ * @tx_frame_len:   length of the encoded frame to send
+ * @tx_frame:       byte-stuffed frame including start and stop bytes
+ * @max_rx_data_len: max data length to receive
+ * @rx_data:        Memory where the received data is stored
+ * @rx_header:      Set to the header of the response
+ * @status:         Set to 0 when the response was received, an error code
+ *                  otherwise. rx_header and rx_data must be discarded on
+ *                  failure.
+ */
+struct sensirion_shdlc_uring_port {
+    int fd;
+    uint16_t tx_frame_len;
+    const uint8_t* tx_frame;
+    uint8_t max_rx_data_len;
+    uint8_t* rx_data;
+    struct sensirion_shdlc_rx_header rx_header;
+    int16_t status;
+
+    struct sensirion_shdlc_rx_decoder decoder;
+    uint16_t rx_len;
+    uint8_t rx_buf[256];
+};
+
+/**
+ * sensirion_shdlc_uring_init() - set up an io_uring instance
+ *
+ * @loop:       io_uring instance to initialize
+ * @max_ports:  max number of ports per sensirion_shdlc_uring_xcv() call
+ * Return:      0 on success, -1 otherwise, e.g. when the kernel does not
+ *              support io_uring
+ */
+int16_t sensirion_shdlc_uring_init(struct sensirion_shdlc_uring* loop,
+                                   uint16_t max_ports);
+
+/**
+ * sensirion_shdlc_uring_close() - release an io_uring instance
+ *
+ * The ports' file descriptors are not closed.
+ */
+void sensirion_shdlc_uring_close(struct sensirion_shdlc_uring* loop);
+
+/**
+ * sensirion_shdlc_uring_xcv() - transceive a frame on several ports at once
+ *
+ * Same as sensirion_shdlc_epoll_xcv(), the ports need not be registered.
+ * Bytes received beyond the end of a response are dropped.
+ *
+ * @loop:           Initialized io_uring instance
+ * @port_count:     number of ports, at most max_ports
+ * @ports:          ports and their transactions, the result of each is stored
+ *                  in its status
+ * @rx_timeout_us:  Time to wait for all responses in microseconds
+ * Return:          0 when all responses were received, the first error code
+ *                  of the transactions otherwise. -1 if io_uring_enter()
+ *                  failed, after the transactions in flight ended. If that
+ *                  is not possible either, the instance is closed and all
+ *                  further calls return -1.
+ */
+int16_t sensirion_shdlc_uring_xcv(struct sensirion_shdlc_uring* loop,
+                                  uint16_t port_count,
+                                  struct sensirion_shdlc_uring_port* ports,
+                                  uint32_t rx_timeout_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSIRION_SHDLC_URING_H */
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SENSIRION_UART_CAPTURE_H
+#define SENSIRION_UART_CAPTURE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sensirion_arch_config.h"
+
+/**
+ * Capture file format, written by sensirion_uart_capture_start() and read by
+ * sensirion_uart_replay_open(): the magic followed by one record per buffer
+ * transmitted or received on any port. Each record is a header of
+ * SENSIRION_UART_CAPTURE_RECORD_SIZE bytes followed by the data:
+ *
+ *   offset 0   time_us, 8 bytes little-endian
+ *   offset 8   len, 2 bytes little-endian
+ *   offset 10  type
+ *   offset 11  port
+ */
+#define SENSIRION_UART_CAPTURE_MAGIC "SUARTCAP"
+#define SENSIRION_UART_CAPTURE_MAGIC_LEN 8
+#define SENSIRION_UART_CAPTURE_RECORD_SIZE 12
+
+#define SENSIRION_UART_CAPTURE_TX 1
+#define SENSIRION_UART_CAPTURE_RX 2
+
+/**
+ * Header of a record as decoded from the file, the data follows it there
+ *
+ * @time_us:    CLOCK_MONOTONIC time since the start of the capture
+ * @len:        number of bytes transmitted or received
+ * @type:       SENSIRION_UART_CAPTURE_TX or SENSIRION_UART_CAPTURE_RX
+ * @port:       Port index, see sensirion_uart_select_port()
+ */
+struct sensirion_uart_capture_record {
+    uint64_t time_us;
+    uint16_t len;
+    uint8_t type;
+    uint8_t port;
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSIRION_UART_CAPTURE_H */
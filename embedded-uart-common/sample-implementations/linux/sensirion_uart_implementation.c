@@ -31,9 +31,21 @@
 
 #include "sensirion_arch_config.h"
 #include "sensirion_uart.h"
+#include "sensirion_uart_capture.h"
+#include "sensirion_uart_linux.h"
+#include <errno.h>
 #include <fcntl.h>
+#include <limits.h>
+#include <linux/serial.h>
+#include <poll.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <termios.h>
+#include <time.h>
 #include <unistd.h>
 
 // Adapted from
@@ -43,20 +55,239 @@
 #define SENSIRION_UART_TTYDEV "/dev/ttyS5"
 #endif
 
-static int uart_fd = -1;
+static struct uart_port {
+    /* file descriptor + 1, i.e. 0 if the port is not open */
+    int fd_plus_one;
+    char path[SENSIRION_UART_MAX_PATH_LEN];
+    /* 1 or -1 if overridden by sensirion_uart_set_low_latency(), 0 for
+     * SENSIRION_UART_LOW_LATENCY */
+    int8_t low_latency;
+    struct sensirion_uart_linux_settings settings;
+} ports[SENSIRION_UART_MAX_PORTS];
+
+static uint8_t cur_port = 0;
+
+/* capture file or -1, see sensirion_uart_capture_start() */
+static int capture_fd = -1;
+static uint64_t capture_start_us;
+
+static const char* uart_path(uint8_t port) {
+    if (ports[port].path[0])
+        return ports[port].path;
+    return port == 0 ? SENSIRION_UART_TTYDEV : NULL;
+}
+
+int16_t sensirion_uart_set_port_path(uint8_t port, const char* path) {
+    size_t len;
+
+    if (port >= SENSIRION_UART_MAX_PORTS || !path)
+        return -1;
+
+    len = strlen(path);
+    if (len == 0 || len >= sizeof(ports[port].path))
+        return -1;
+
+    memcpy(ports[port].path, path, len + 1);
+    return 0;
+}
+
+int16_t sensirion_uart_set_low_latency(uint8_t port, uint8_t enable) {
+    if (port >= SENSIRION_UART_MAX_PORTS)
+        return -1;
+    ports[port].low_latency = enable ? 1 : -1;
+    return 0;
+}
+
+int16_t
+sensirion_uart_get_settings(uint8_t port,
+                            struct sensirion_uart_linux_settings* settings) {
+    if (port >= SENSIRION_UART_MAX_PORTS || !ports[port].fd_plus_one)
+        return -1;
+    *settings = ports[port].settings;
+    return 0;
+}
+
+int sensirion_uart_get_fd(void) {
+    return ports[cur_port].fd_plus_one - 1;
+}
+
+static uint64_t uart_now_us(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+}
+
+int16_t sensirion_uart_capture_start(const char* path) {
+    int fd;
+
+    sensirion_uart_capture_stop();
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+    if (fd == -1)
+        return -1;
+    if (write(fd, SENSIRION_UART_CAPTURE_MAGIC,
+              SENSIRION_UART_CAPTURE_MAGIC_LEN) !=
+        SENSIRION_UART_CAPTURE_MAGIC_LEN) {
+        close(fd);
+        return -1;
+    }
+    capture_start_us = uart_now_us();
+    capture_fd = fd;
+    return 0;
+}
+
+void sensirion_uart_capture_stop(void) {
+    if (capture_fd != -1)
+        close(capture_fd);
+    capture_fd = -1;
+}
+
+/* append a record of the first len bytes of iov, written at once so that
+ * records of concurrently used ports don't interleave */
+static void uart_capture(void* ctx, uint8_t type, int iovcnt,
+                         const struct iovec* iov, size_t len) {
+    uint8_t record[SENSIRION_UART_CAPTURE_RECORD_SIZE];
+    struct iovec vec[1 + SENSIRION_UART_MAX_IOV];
+    uint64_t time_us;
+    uint16_t record_len = 0;
+    int i;
+
+    if (capture_fd == -1 || len == 0)
+        return;
+
+    time_us = uart_now_us() - capture_start_us;
+    for (i = 0; i < 8; ++i)
+        record[i] = (uint8_t)(time_us >> (8 * i));
+    record[10] = type;
+    record[11] = (uint8_t)((struct uart_port*)ctx - ports);
+    vec[0].iov_base = record;
+    vec[0].iov_len = sizeof(record);
+    for (i = 0; i < iovcnt && len; ++i) {
+        vec[1 + i] = iov[i];
+        if (vec[1 + i].iov_len > len)
+            vec[1 + i].iov_len = len;
+        len -= vec[1 + i].iov_len;
+        record_len = (uint16_t)(record_len + vec[1 + i].iov_len);
+    }
+    record[8] = (uint8_t)record_len;
+    record[9] = (uint8_t)(record_len >> 8);
+    /* best effort, a failing capture must not break the communication */
+    (void)!writev(capture_fd, vec, 1 + i);
+}
+
+static void uart_capture_buf(void* ctx, uint8_t type, const uint8_t* data,
+                             int len) {
+    struct iovec vec;
+
+    if (len <= 0)
+        return;
+    vec.iov_base = (void*)data;
+    vec.iov_len = (size_t)len;
+    uart_capture(ctx, type, 1, &vec, vec.iov_len);
+}
+
+/* Latency timer of a USB serial adapter, lowered to
+ * SENSIRION_UART_LATENCY_TIMER_MS if lower is set and the timer is writable.
+ * Return: the effective timer in ms, 0 if the port has none */
+static uint8_t uart_latency_timer(const char* path, uint8_t lower) {
+    char tty[PATH_MAX];
+    char attr[PATH_MAX];
+    char value[8];
+    const char* name;
+    long ms = 0;
+    ssize_t len;
+    int fd;
+
+    /* resolve links like /dev/serial/by-id/... to the tty's name */
+    if (!realpath(path, tty))
+        return 0;
+    name = strrchr(tty, '/');
+    name = name ? name + 1 : tty;
+    if (snprintf(attr, sizeof(attr), "%s/%s/latency_timer",
+                 SENSIRION_UART_USB_SERIAL_SYSFS,
+                 name) >= (int)sizeof(attr))
+        return 0;
+
+    if (lower) {
+        fd = open(attr, O_WRONLY | O_CLOEXEC);
+        if (fd != -1) {
+            len = snprintf(value, sizeof(value), "%u\n",
+                           SENSIRION_UART_LATENCY_TIMER_MS);
+            (void)!write(fd, value, (size_t)len);
+            close(fd);
+        }
+    }
+
+    fd = open(attr, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return 0;
+    len = read(fd, value, sizeof(value) - 1);
+    close(fd);
+    if (len > 0) {
+        value[len] = '\0';
+        ms = strtol(value, NULL, 10);
+    }
+    return ms > 0 && ms <= 255 ? (uint8_t)ms : 0;
+}
+
+/* apply the low latency settings to an open port, if enabled */
+static void uart_tune_latency(struct uart_port* port, int fd,
+                              const char* path) {
+    struct serial_struct serial;
+    const int low_latency = (int)ASYNC_LOW_LATENCY;
+    uint8_t enable = port->low_latency ? port->low_latency > 0
+                                       : SENSIRION_UART_LOW_LATENCY;
+
+    memset(&port->settings, 0, sizeof(port->settings));
+    if (ioctl(fd, TIOCGSERIAL, &serial) == 0) {
+        if (enable && !(serial.flags & low_latency)) {
+            serial.flags |= low_latency;
+            if (ioctl(fd, TIOCSSERIAL, &serial) ||
+                ioctl(fd, TIOCGSERIAL, &serial))
+                serial.flags &= ~low_latency;
+        }
+        port->settings.low_latency = !!(serial.flags & low_latency);
+    }
+    port->settings.latency_timer_ms = uart_latency_timer(path, enable);
+    port->settings.tx_drain = enable;
+
+#ifdef DEBUG
+    fprintf(stderr, "UART %s: low latency %u, latency timer %ums, drain %u\n",
+            path, port->settings.low_latency, port->settings.latency_timer_ms,
+            port->settings.tx_drain);
+#endif
+}
 
 /**
  * sensirion_uart_select_port() - select the UART port index to use
  *                                THE IMPLEMENTATION IS OPTIONAL ON SINGLE-PORT
  *                                SETUPS (only one SPS30)
  *
- * Return:      0 on success, an error code otherwise
+ * Register the device path of each port with sensirion_uart_set_port_path().
+ *
+ * Return:      0 on success, -1 if the selected port is invalid
  */
 int16_t sensirion_uart_select_port(uint8_t port) {
+    if (port >= SENSIRION_UART_MAX_PORTS)
+        return -1;
+    cur_port = port;
     return 0;
 }
 
-int16_t sensirion_uart_open() {
+int16_t sensirion_uart_open_port(uint8_t port) {
+    const char* path;
+    int fd;
+
+    if (port >= SENSIRION_UART_MAX_PORTS)
+        return -1;
+    path = uart_path(port);
+    if (!path) {
+        fprintf(stderr, "No device path set for UART port %u\n", port);
+        return -1;
+    }
+    if (ports[port].fd_plus_one)
+        sensirion_uart_close_port(port);
+
     // The flags (defined in fcntl.h):
     //    Access modes (use 1 of these):
     //        O_RDONLY - Open for reading only.
@@ -71,15 +302,18 @@ int16_t sensirion_uart_open() {
     //      shall not cause the terminal device to become the controlling
     //      terminal for the process.
 #ifdef DEBUG
-    fprintf(stderr, "Opening UART %s\n", SENSIRION_UART_TTYDEV);
+    fprintf(stderr, "Opening UART %s\n", path);
 #endif
-    uart_fd = open(SENSIRION_UART_TTYDEV, O_RDWR | O_NOCTTY);
-    if (uart_fd == -1) {
+    // The port is opened non-blocking, a serial port without CLOCAL would
+    // wait for the carrier otherwise, and switched to blocking writes below.
+    fd = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd == -1) {
         fprintf(stderr, "Error opening UART. Ensure it's not otherwise used\n");
         return -1;
     }
+    ports[port].fd_plus_one = fd + 1;
 #ifdef DEBUG
-    fprintf(stderr, "Opened UART! %s\n", SENSIRION_UART_TTYDEV);
+    fprintf(stderr, "Opened UART! %s\n", path);
 #endif
 
     // see http://pubs.opengroup.org/onlinepubs/007908799/xsh/termios.h.html:
@@ -93,33 +327,56 @@ int16_t sensirion_uart_open() {
     //    PARENB - Parity enable
     //    PARODD - Odd parity (else even)
     struct termios options;
-    tcgetattr(uart_fd, &options);
+    tcgetattr(fd, &options);
 #ifdef DEBUG
-    fprintf(stderr, "Got UART attr %s\n", SENSIRION_UART_TTYDEV);
+    fprintf(stderr, "Got UART attr %s\n", path);
 #endif
 
     options.c_cflag = B115200 | CS8 | CLOCAL | CREAD;  // set baud rate
     options.c_iflag = IGNPAR;
     options.c_oflag = 0;
     options.c_lflag = 0;
-    tcflush(uart_fd, TCIFLUSH);
+    // read() returns the bytes available, possibly none, and never blocks:
+    // waiting for input is bounded by the poll() in sensirion_uart_rx_timeout()
+    options.c_cc[VMIN] = 0;
+    options.c_cc[VTIME] = 0;
+    tcflush(fd, TCIFLUSH);
 #ifdef DEBUG
-    fprintf(stderr, "Flushed UART %s\n", SENSIRION_UART_TTYDEV);
+    fprintf(stderr, "Flushed UART %s\n", path);
 #endif
 
-    tcsetattr(uart_fd, TCSANOW, &options);
+    tcsetattr(fd, TCSANOW, &options);
 #ifdef DEBUG
-    fprintf(stderr, "Set UART attr! %s\n", SENSIRION_UART_TTYDEV);
+    fprintf(stderr, "Set UART attr! %s\n", path);
 #endif
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+
+    uart_tune_latency(&ports[port], fd, path);
 
     return 0;
 }
 
+int16_t sensirion_uart_open() {
+    return sensirion_uart_open_port(cur_port);
+}
+
+int16_t sensirion_uart_close_port(uint8_t port) {
+    int fd;
+
+    if (port >= SENSIRION_UART_MAX_PORTS || !ports[port].fd_plus_one)
+        return -1;
+    fd = ports[port].fd_plus_one - 1;
+    ports[port].fd_plus_one = 0;
+    return (int16_t)close(fd);
+}
+
 int16_t sensirion_uart_close() {
-    return close(uart_fd);
+    return sensirion_uart_close_port(cur_port);
 }
 
-int16_t sensirion_uart_tx(uint16_t data_len, const uint8_t* data) {
+static int16_t uart_port_tx(void* ctx, uint16_t data_len, const uint8_t* data) {
+    int uart_fd = ((struct uart_port*)ctx)->fd_plus_one - 1;
+
     if (uart_fd == -1)
         return -1;
 #ifdef DEBUG
@@ -129,10 +386,37 @@ int16_t sensirion_uart_tx(uint16_t data_len, const uint8_t* data) {
 #ifdef DEBUG
     fprintf(stderr, "transmitted/wrote: %d:%x to fd=%d err=%d\n", data_len, *data, uart_fd, e);
 #endif
+    if (e > 0 && ((struct uart_port*)ctx)->settings.tx_drain)
+        tcdrain(uart_fd);
+    uart_capture_buf(ctx, SENSIRION_UART_CAPTURE_TX, data, e);
     return e;
 }
 
-int16_t sensirion_uart_rx(uint16_t max_data_len, uint8_t* data) {
+static int16_t uart_port_txv(void* ctx, uint8_t iovcnt,
+                             const struct sensirion_uart_iovec* iov) {
+    struct iovec vec[SENSIRION_UART_MAX_IOV];
+    int uart_fd = ((struct uart_port*)ctx)->fd_plus_one - 1;
+    ssize_t e;
+    uint8_t i;
+
+    if (uart_fd == -1 || iovcnt > SENSIRION_UART_MAX_IOV)
+        return -1;
+
+    for (i = 0; i < iovcnt; ++i) {
+        vec[i].iov_base = (void*)iov[i].data;
+        vec[i].iov_len = iov[i].len;
+    }
+    e = writev(uart_fd, vec, iovcnt);
+    if (e > 0 && ((struct uart_port*)ctx)->settings.tx_drain)
+        tcdrain(uart_fd);
+    if (e > 0)
+        uart_capture(ctx, SENSIRION_UART_CAPTURE_TX, iovcnt, vec, (size_t)e);
+    return (int16_t)e;
+}
+
+static int16_t uart_port_rx(void* ctx, uint16_t max_data_len, uint8_t* data) {
+    int uart_fd = ((struct uart_port*)ctx)->fd_plus_one - 1;
+
     if (uart_fd == -1)
         return -1;
 
@@ -143,8 +427,145 @@ int16_t sensirion_uart_rx(uint16_t max_data_len, uint8_t* data) {
 #ifdef DEBUG
     fprintf(stderr, "received/read: %d:%x from fd=%d\n", e, *data, uart_fd);
 #endif
+    uart_capture_buf(ctx, SENSIRION_UART_CAPTURE_RX, data, e);
     return e;
 }
+
+static int16_t uart_port_rx_timeout(void* ctx, uint16_t max_data_len,
+                                    uint8_t* data, uint32_t timeout_us) {
+    struct pollfd pfd;
+    int uart_fd = ((struct uart_port*)ctx)->fd_plus_one - 1;
+    uint64_t deadline = uart_now_us() + timeout_us;
+    uint64_t now;
+    int e;
+
+    if (uart_fd == -1)
+        return -1;
+
+    pfd.fd = uart_fd;
+    pfd.events = POLLIN;
+    for (;;) {
+        now = uart_now_us();
+        if (now > deadline)
+            now = deadline;
+        /* round up, poll() has a millisecond resolution */
+        e = poll(&pfd, 1, (int)((deadline - now + 999) / 1000));
+        if (e > 0)
+            break;
+        if (e == 0)
+            return 0;
+        if (errno != EINTR)
+            return -1;
+    }
+    return uart_port_rx(ctx, max_data_len, data);
+}
+
+/* Watch the deepest existing directory on the path of a device, e.g. /dev
+ * until udev created /dev/serial/by-id for a link to the device */
+static void uart_watch_dir(int inotify_fd, const char* path) {
+    const uint32_t mask = IN_CREATE | IN_ATTRIB | IN_MOVED_TO;
+    char dir[PATH_MAX];
+    size_t len = strlen(path);
+    char* sep;
+
+    /* SENSIRION_UART_TTYDEV is not checked like sensirion_uart_set_port_path()
+     * checks its paths */
+    if (len >= sizeof(dir))
+        return;
+    memcpy(dir, path, len + 1);
+    for (;;) {
+        sep = strrchr(dir, '/');
+        if (!sep) {
+            inotify_add_watch(inotify_fd, ".", mask);
+            return;
+        }
+        /* keep the root of absolute paths */
+        sep[sep == dir] = '\0';
+        if (inotify_add_watch(inotify_fd, dir, mask) != -1 ||
+            errno != ENOENT || sep == dir)
+            return;
+    }
+}
+
+int16_t sensirion_uart_wait_device(uint32_t timeout_us) {
+    const char* path = uart_path(cur_port);
+    uint64_t deadline = uart_now_us() + timeout_us;
+    uint8_t events[sizeof(struct inotify_event) + NAME_MAX + 1];
+    struct pollfd pfd;
+    int16_t ret = -1;
+    uint64_t now;
+    int e;
+
+    if (!path)
+        return -1;
+
+    pfd.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (pfd.fd == -1)
+        return access(path, R_OK | W_OK) ? -1 : 0;
+    pfd.events = POLLIN;
+
+    for (;;) {
+        /* watch before checking, so the device can't appear in between. udev
+         * creates the node first and sets its permissions after. */
+        uart_watch_dir(pfd.fd, path);
+        if (!access(path, R_OK | W_OK)) {
+            ret = 0;
+            break;
+        }
+        now = uart_now_us();
+        if (now >= deadline)
+            break;
+        e = poll(&pfd, 1, (int)((deadline - now + 999) / 1000));
+        if (e < 0 && errno != EINTR)
+            break;
+        /* any change is a reason to check again, the events are dropped */
+        while (read(pfd.fd, events, sizeof(events)) > 0)
+            ;
+    }
+    close(pfd.fd);
+    return ret;
+}
+
+static uint32_t uart_port_time_usec(void* ctx) {
+    return (uint32_t)uart_now_us();
+}
+
+const struct sensirion_uart_ops sensirion_uart_linux_ops = {
+    uart_port_tx,
+    uart_port_txv,
+    uart_port_rx_timeout,
+    uart_port_time_usec,
+};
+
+void* sensirion_uart_linux_port(uint8_t port) {
+    if (port >= SENSIRION_UART_MAX_PORTS)
+        return NULL;
+    return &ports[port];
+}
+
+int16_t sensirion_uart_tx(uint16_t data_len, const uint8_t* data) {
+    return uart_port_tx(&ports[cur_port], data_len, data);
+}
+
+int16_t sensirion_uart_txv(uint8_t iovcnt,
+                           const struct sensirion_uart_iovec* iov) {
+    return uart_port_txv(&ports[cur_port], iovcnt, iov);
+}
+
+int16_t sensirion_uart_rx(uint16_t max_data_len, uint8_t* data) {
+    return uart_port_rx(&ports[cur_port], max_data_len, data);
+}
+
+int16_t sensirion_uart_rx_timeout(uint16_t max_data_len, uint8_t* data,
+                                  uint32_t timeout_us) {
+    return uart_port_rx_timeout(&ports[cur_port], max_data_len, data,
+                                timeout_us);
+}
+
 void sensirion_sleep_usec(uint32_t useconds) {
     usleep(useconds);
 }
+
+uint32_t sensirion_time_usec(void) {
+    return (uint32_t)uart_now_us();
+}
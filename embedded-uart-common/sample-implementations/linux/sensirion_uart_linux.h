@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SENSIRION_UART_LINUX_H
+#define SENSIRION_UART_LINUX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <limits.h>
+
+#include "sensirion_arch_config.h"
+#include "sensirion_uart.h"
+
+#ifndef SENSIRION_UART_MAX_PORTS
+#define SENSIRION_UART_MAX_PORTS 32
+#endif
+
+/**
+ * Max. length of a device path including the terminating zero, enough for the
+ * long links in /dev/serial/by-id
+ */
+#define SENSIRION_UART_MAX_PATH_LEN PATH_MAX
+
+/**
+ * Tune ports for latency when opening them, off by default. Define as 1 to
+ * enable it for all ports or use sensirion_uart_set_low_latency() per port,
+ * see struct sensirion_uart_linux_settings.
+ */
+#ifndef SENSIRION_UART_LOW_LATENCY
+#define SENSIRION_UART_LOW_LATENCY 0
+#endif
+
+/** Latency timer of USB serial adapters in low latency mode, 1..255 ms */
+#ifndef SENSIRION_UART_LATENCY_TIMER_MS
+#define SENSIRION_UART_LATENCY_TIMER_MS 1
+#endif
+
+/** Where the kernel lists USB serial adapters, e.g. FTDI's latency_timer */
+#ifndef SENSIRION_UART_USB_SERIAL_SYSFS
+#define SENSIRION_UART_USB_SERIAL_SYSFS "/sys/bus/usb-serial/devices"
+#endif
+
+/**
+ * Effective settings of an open port. In low latency mode the HAL sets
+ * ASYNC_LOW_LATENCY, lowers the latency timer of USB serial adapters which
+ * have one and waits with tcdrain() until transmitted bytes left the UART.
+ * USB adapters otherwise hold received bytes for up to 16ms.
+ *
+ * @low_latency:        ASYNC_LOW_LATENCY is set on the serial driver
+ * @latency_timer_ms:   latency timer of the USB serial adapter, 0 if the port
+ *                      has none or it cannot be read
+ * @tx_drain:           transmissions return once the bytes are on the wire
+ */
+struct sensirion_uart_linux_settings {
+    uint8_t low_latency;
+    uint8_t latency_timer_ms;
+    uint8_t tx_drain;
+};
+
+/**
+ * sensirion_uart_set_port_path() - set the device path of a UART port
+ *
+ * Ports without a path are not usable, except port 0 which defaults to
+ * SENSIRION_UART_TTYDEV. The path is used by the next sensirion_uart_open()
+ * on that port, already open ports are not affected.
+ *
+ * @port:   Port index, see sensirion_uart_select_port()
+ * @path:   Device path, e.g. "/dev/ttyUSB0". The string is copied.
+ * Return:  0 on success, -1 if the port index or path is invalid
+ */
+int16_t sensirion_uart_set_port_path(uint8_t port, const char* path);
+
+/**
+ * sensirion_uart_set_low_latency() - enable or disable low latency mode
+ *
+ * Overrides SENSIRION_UART_LOW_LATENCY for a port, takes effect on the next
+ * sensirion_uart_open(). The settings which cannot be applied, e.g. because
+ * the latency timer is not writable, are skipped silently.
+ *
+ * @port:   Port index, see sensirion_uart_select_port()
+ * @enable: 1 to enable low latency mode, 0 to disable it
+ * Return:  0 on success, -1 if the port index is invalid
+ */
+int16_t sensirion_uart_set_low_latency(uint8_t port, uint8_t enable);
+
+/**
+ * sensirion_uart_get_settings() - effective settings of an open port
+ *
+ * @port:       Port index, see sensirion_uart_select_port()
+ * @settings:   Set to the settings applied by sensirion_uart_open()
+ * Return:      0 on success, -1 if the port index is invalid or not open
+ */
+int16_t
+sensirion_uart_get_settings(uint8_t port,
+                            struct sensirion_uart_linux_settings* settings);
+
+/**
+ * sensirion_uart_open_port() - open a port without selecting it
+ *
+ * Like sensirion_uart_open() on the given port. Different ports may be opened
+ * and closed from different threads at the same time.
+ *
+ * @port:   Port index, see sensirion_uart_select_port()
+ * Return:  0 on success, -1 if the port is invalid or cannot be opened
+ */
+int16_t sensirion_uart_open_port(uint8_t port);
+
+/**
+ * sensirion_uart_close_port() - close a port without selecting it
+ *
+ * @port:   Port index, see sensirion_uart_select_port()
+ * Return:  0 on success, -1 if the port is invalid or not open
+ */
+int16_t sensirion_uart_close_port(uint8_t port);
+
+/**
+ * sensirion_uart_get_fd() - file descriptor of the selected port
+ *
+ * Return:  The file descriptor or -1 if the port is not open
+ */
+int sensirion_uart_get_fd(void);
+
+/**
+ * UART operations for the reentrant driver API, see struct sensirion_shdlc_dev.
+ * Their context is a port returned by sensirion_uart_linux_port(). Open the
+ * port first with sensirion_uart_select_port() and sensirion_uart_open().
+ */
+extern const struct sensirion_uart_ops sensirion_uart_linux_ops;
+
+/**
+ * sensirion_uart_linux_port() - context of a port for sensirion_uart_linux_ops
+ *
+ * @port:   Port index, see sensirion_uart_select_port()
+ * Return:  The context to pass along with sensirion_uart_linux_ops or NULL if
+ *          the port index is invalid
+ */
+void* sensirion_uart_linux_port(uint8_t port);
+
+/**
+ * sensirion_uart_capture_start() - log all UART traffic to a file
+ *
+ * Every buffer transmitted or received on any port is appended to the file
+ * with a timestamp, see sensirion_uart_capture.h. Replay captures with
+ * sensirion_uart_replay_ops.
+ *
+ * @path:   File to create or truncate
+ * Return:  0 on success, -1 if the file could not be created
+ */
+int16_t sensirion_uart_capture_start(const char* path);
+
+/**
+ * sensirion_uart_capture_stop() - stop logging and close the capture file
+ */
+void sensirion_uart_capture_stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSIRION_UART_LINUX_H */
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "sensirion_uart_replay.h"
+#include "sensirion_arch_config.h"
+#include "sensirion_uart.h"
+#include "sensirion_uart_capture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint64_t sensirion_uart_replay_now_us(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void sensirion_uart_replay_sleep_until(uint64_t time_us) {
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)(time_us / 1000000);
+    ts.tv_nsec = (long)(time_us % 1000000) * 1000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL))
+        ;
+}
+
+/** Decode the header of the record at pos, see sensirion_uart_capture.h */
+static void
+sensirion_uart_replay_record(const struct sensirion_uart_replay* replay,
+                             uint32_t pos,
+                             struct sensirion_uart_capture_record* record) {
+    const uint8_t* bytes = &replay->data[pos];
+    uint8_t i;
+
+    record->time_us = 0;
+    for (i = 0; i < 8; ++i)
+        record->time_us |= (uint64_t)bytes[i] << (8 * i);
+    record->len = (uint16_t)(bytes[8] | bytes[9] << 8);
+    record->type = bytes[10];
+    record->port = bytes[11];
+}
+
+/**
+ * Find the next record of the replayed port at or after pos.
+ * Return: 1 if a record was found, 0 at the end of the capture
+ */
+static uint8_t
+sensirion_uart_replay_next(const struct sensirion_uart_replay* replay,
+                           uint32_t* pos,
+                           struct sensirion_uart_capture_record* record) {
+    while (*pos < replay->len) {
+        sensirion_uart_replay_record(replay, *pos, record);
+        if (record->port == replay->port)
+            return 1;
+        *pos += SENSIRION_UART_CAPTURE_RECORD_SIZE + record->len;
+    }
+    return 0;
+}
+
+int16_t sensirion_uart_replay_open(struct sensirion_uart_replay* replay,
+                                   const char* path, uint8_t port,
+                                   uint32_t speed) {
+    struct sensirion_uart_capture_record record;
+    char magic[SENSIRION_UART_CAPTURE_MAGIC_LEN];
+    uint32_t pos;
+    long len;
+    FILE* f;
+
+    memset(replay, 0, sizeof(*replay));
+    f = fopen(path, "rb");
+    if (!f)
+        return -1;
+
+    if (fread(magic, sizeof(magic), 1, f) != 1 ||
+        memcmp(magic, SENSIRION_UART_CAPTURE_MAGIC, sizeof(magic)) ||
+        fseek(f, 0, SEEK_END) || (len = ftell(f)) < (long)sizeof(magic) ||
+        fseek(f, (long)sizeof(magic), SEEK_SET))
+        goto err;
+
+    replay->len = (uint32_t)(len - (long)sizeof(magic));
+    replay->data = (uint8_t*)malloc(replay->len ? replay->len : 1);
+    if (!replay->data ||
+        (replay->len && fread(replay->data, replay->len, 1, f) != 1))
+        goto err;
+    fclose(f);
+
+    /* reject truncated captures, the replay relies on complete records */
+    for (pos = 0; pos < replay->len;
+         pos += SENSIRION_UART_CAPTURE_RECORD_SIZE + record.len) {
+        if (replay->len - pos < SENSIRION_UART_CAPTURE_RECORD_SIZE)
+            break;
+        sensirion_uart_replay_record(replay, pos, &record);
+        if (replay->len - pos - SENSIRION_UART_CAPTURE_RECORD_SIZE < record.len)
+            break;
+    }
+    if (pos != replay->len) {
+        sensirion_uart_replay_close(replay);
+        return -1;
+    }
+
+    replay->port = port;
+    replay->speed = speed;
+    sensirion_uart_replay_rewind(replay);
+    return 0;
+
+err:
+    fclose(f);
+    sensirion_uart_replay_close(replay);
+    return -1;
+}
+
+void sensirion_uart_replay_rewind(struct sensirion_uart_replay* replay) {
+    replay->pos = 0;
+    replay->rx_pos = 0;
+    replay->anchor_us = sensirion_uart_replay_now_us();
+    replay->anchor_time_us = 0;
+}
+
+uint8_t sensirion_uart_replay_done(struct sensirion_uart_replay* replay) {
+    struct sensirion_uart_capture_record record;
+    uint32_t pos = replay->pos;
+
+    return !sensirion_uart_replay_next(replay, &pos, &record);
+}
+
+void sensirion_uart_replay_close(struct sensirion_uart_replay* replay) {
+    free(replay->data);
+    replay->data = NULL;
+    replay->len = 0;
+    replay->pos = 0;
+}
+
+int16_t sensirion_uart_replay_txv(struct sensirion_uart_replay* replay,
+                                  uint8_t iovcnt,
+                                  const struct sensirion_uart_iovec* iov) {
+    struct sensirion_uart_capture_record record;
+    const uint8_t* captured;
+    uint16_t len = 0;
+    uint16_t offset;
+    uint8_t i;
+
+    for (i = 0; i < iovcnt; ++i)
+        len = (uint16_t)(len + iov[i].len);
+
+    /* received bytes the driver did not read before transmitting are
+     * dropped, as they would be by the next command on a real port */
+    while (sensirion_uart_replay_next(replay, &replay->pos, &record) &&
+           record.type != SENSIRION_UART_CAPTURE_TX)
+        replay->pos += SENSIRION_UART_CAPTURE_RECORD_SIZE + record.len;
+    replay->rx_pos = 0;
+
+    if (replay->pos >= replay->len) {
+        ++replay->tx_mismatches;
+        return (int16_t)len;
+    }
+
+    captured = &replay->data[replay->pos + SENSIRION_UART_CAPTURE_RECORD_SIZE];
+    if (record.len != len) {
+        ++replay->tx_mismatches;
+    } else {
+        for (i = 0, offset = 0; i < iovcnt; offset += iov[i++].len) {
+            if (memcmp(&captured[offset], iov[i].data, iov[i].len)) {
+                ++replay->tx_mismatches;
+                break;
+            }
+        }
+    }
+    replay->pos += SENSIRION_UART_CAPTURE_RECORD_SIZE + record.len;
+
+    /* the response is timed relative to its command, time spent by the
+     * caller between two transactions is not replayed */
+    replay->anchor_us = sensirion_uart_replay_now_us();
+    replay->anchor_time_us = record.time_us;
+    return (int16_t)len;
+}
+
+int16_t sensirion_uart_replay_tx(struct sensirion_uart_replay* replay,
+                                 uint16_t data_len, const uint8_t* data) {
+    struct sensirion_uart_iovec iov;
+
+    iov.data = data;
+    iov.len = data_len;
+    return sensirion_uart_replay_txv(replay, 1, &iov);
+}
+
+int16_t sensirion_uart_replay_rx_timeout(struct sensirion_uart_replay* replay,
+                                         uint16_t max_data_len, uint8_t* data,
+                                         uint32_t timeout_us) {
+    struct sensirion_uart_capture_record record;
+    uint64_t now = 0;
+    uint64_t due;
+    uint16_t len;
+
+    if (replay->speed)
+        now = sensirion_uart_replay_now_us();
+
+    if (!sensirion_uart_replay_next(replay, &replay->pos, &record) ||
+        record.type != SENSIRION_UART_CAPTURE_RX) {
+        /* nothing more to receive before the next command */
+        if (replay->speed)
+            sensirion_uart_replay_sleep_until(now + timeout_us);
+        return 0;
+    }
+
+    if (replay->speed) {
+        due = replay->anchor_us;
+        if (record.time_us > replay->anchor_time_us)
+            due += (record.time_us - replay->anchor_time_us) / replay->speed;
+        if (due > now + timeout_us) {
+            ++replay->rx_timeouts;
+            sensirion_uart_replay_sleep_until(now + timeout_us);
+            return 0;
+        }
+        if (due > now)
+            sensirion_uart_replay_sleep_until(due);
+    }
+
+    len = (uint16_t)(record.len - replay->rx_pos);
+    if (len > max_data_len)
+        len = max_data_len;
+    memcpy(data,
+           &replay->data[replay->pos + SENSIRION_UART_CAPTURE_RECORD_SIZE +
+                         replay->rx_pos],
+           len);
+    replay->rx_pos = (uint16_t)(replay->rx_pos + len);
+    if (replay->rx_pos == record.len) {
+        replay->pos += SENSIRION_UART_CAPTURE_RECORD_SIZE + record.len;
+        replay->rx_pos = 0;
+    }
+    return (int16_t)len;
+}
+
+static int16_t sensirion_uart_replay_ops_tx(void* ctx, uint16_t data_len,
+                                            const uint8_t* data) {
+    return sensirion_uart_replay_tx((struct sensirion_uart_replay*)ctx,
+                                    data_len, data);
+}
+
+static int16_t
+sensirion_uart_replay_ops_txv(void* ctx, uint8_t iovcnt,
+                              const struct sensirion_uart_iovec* iov) {
+    return sensirion_uart_replay_txv((struct sensirion_uart_replay*)ctx,
+                                     iovcnt, iov);
+}
+
+static int16_t sensirion_uart_replay_ops_rx_timeout(void* ctx,
+                                                    uint16_t max_data_len,
+                                                    uint8_t* data,
+                                                    uint32_t timeout_us) {
+    return sensirion_uart_replay_rx_timeout((struct sensirion_uart_replay*)ctx,
+                                            max_data_len, data, timeout_us);
+}
+
+const struct sensirion_uart_ops sensirion_uart_replay_ops = {
+    sensirion_uart_replay_ops_tx,
+    sensirion_uart_replay_ops_txv,
+    sensirion_uart_replay_ops_rx_timeout,
+};
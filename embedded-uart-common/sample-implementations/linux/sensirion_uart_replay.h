@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SENSIRION_UART_REPLAY_H
+#define SENSIRION_UART_REPLAY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sensirion_arch_config.h"
+#include "sensirion_uart.h"
+
+/**
+ * UART feeding a capture of sensirion_uart_capture_start() back to the driver
+ * for deterministic tests and benchmarks without a sensor. Use it with
+ * sensirion_uart_replay_ops as the ctx of a reentrant device, e.g.
+ * sps30_dev_init(&dev, &sensirion_uart_replay_ops, &replay).
+ *
+ * Transmitted buffers are compared against the captured ones, received bytes
+ * are delivered with their original timing divided by the speed. All fields
+ * are private except for the statistics.
+ *
+ * @tx_mismatches:  number of transmitted buffers which differ from the capture
+ * @rx_timeouts:    number of reads that timed out before the captured data was
+ *                  due, the capture is a bad fit for the replayed calls
+ */
+struct sensirion_uart_replay {
+    uint8_t* data;
+    uint32_t len;
+    uint32_t pos;
+    uint16_t rx_pos;
+    uint8_t port;
+    uint32_t speed;
+    uint64_t anchor_us;
+    uint64_t anchor_time_us;
+
+    uint32_t tx_mismatches;
+    uint32_t rx_timeouts;
+};
+
+/**
+ * sensirion_uart_replay_open() - load a capture file
+ *
+ * @replay: Replay to initialize
+ * @path:   Capture file
+ * @port:   Replay the traffic of this port of the capture
+ * @speed:  Replay this many times faster than captured, 0 to deliver all
+ *          data without delay
+ * Return:  0 on success, -1 if the file cannot be read or is no capture
+ */
+int16_t sensirion_uart_replay_open(struct sensirion_uart_replay* replay,
+                                   const char* path, uint8_t port,
+                                   uint32_t speed);
+
+/**
+ * sensirion_uart_replay_rewind() - restart the replay from the beginning
+ */
+void sensirion_uart_replay_rewind(struct sensirion_uart_replay* replay);
+
+/**
+ * sensirion_uart_replay_done() - check if the capture was replayed completely
+ *
+ * Return:  1 when all records of the port were consumed, 0 otherwise
+ */
+uint8_t sensirion_uart_replay_done(struct sensirion_uart_replay* replay);
+
+/**
+ * sensirion_uart_replay_close() - release the loaded capture
+ */
+void sensirion_uart_replay_close(struct sensirion_uart_replay* replay);
+
+/**
+ * sensirion_uart_replay_tx() - transmit to the replay, same as the tx
+ * operation of sensirion_uart_replay_ops without the indirect call
+ */
+int16_t sensirion_uart_replay_tx(struct sensirion_uart_replay* replay,
+                                 uint16_t data_len, const uint8_t* data);
+
+/**
+ * sensirion_uart_replay_txv() - transmit several buffers to the replay
+ */
+int16_t sensirion_uart_replay_txv(struct sensirion_uart_replay* replay,
+                                  uint8_t iovcnt,
+                                  const struct sensirion_uart_iovec* iov);
+
+/**
+ * sensirion_uart_replay_rx_timeout() - receive from the replay
+ *
+ * Return:  Number of bytes received, 0 if none were due within timeout_us
+ */
+int16_t sensirion_uart_replay_rx_timeout(struct sensirion_uart_replay* replay,
+                                         uint16_t max_data_len, uint8_t* data,
+                                         uint32_t timeout_us);
+
+/**
+ * UART operations of a replay, the ctx is a struct sensirion_uart_replay
+ */
+extern const struct sensirion_uart_ops sensirion_uart_replay_ops;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SENSIRION_UART_REPLAY_H */
@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Transports of the header-only SHDLC driver in sensirion_shdlc.hpp for
+ * Linux: LinuxTty for serial ports configured like the Linux UART HAL does,
+ * Pty for pseudo terminals, e.g. of a simulator, and Replay for captures of
+ * sensirion_uart_capture_start().
+ *
+ * Each transport owns its file descriptor or capture and is move-only. Check
+ * valid() after construction, the constructors don't throw.
+ */
+
+#ifndef SENSIRION_UART_TRANSPORT_HPP
+#define SENSIRION_UART_TRANSPORT_HPP
+
+#include <utility>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/serial.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sensirion_uart_linux.h"
+#include "sensirion_uart_replay.h"
+
+namespace sensirion {
+namespace uart {
+
+/**
+ * A file descriptor with the tx() and rx() of a transport, the base of the
+ * terminal transports
+ */
+class FdTransport {
+  public:
+    FdTransport(FdTransport&& other) noexcept
+        : fd_(std::exchange(other.fd_, -1)) {
+    }
+
+    FdTransport& operator=(FdTransport&& other) noexcept {
+        if (this != &other) {
+            reset();
+            fd_ = std::exchange(other.fd_, -1);
+        }
+        return *this;
+    }
+
+    FdTransport(const FdTransport&) = delete;
+    FdTransport& operator=(const FdTransport&) = delete;
+
+    ~FdTransport() {
+        reset();
+    }
+
+    bool valid() const {
+        return fd_ >= 0;
+    }
+
+    int fd() const {
+        return fd_;
+    }
+
+    int16_t tx(uint16_t len, const uint8_t* data) {
+        return static_cast<int16_t>(write(fd_, data, len));
+    }
+
+    /* wait for input up to timeout_us and read what arrived */
+    int16_t rx(uint16_t max_len, uint8_t* data, uint32_t timeout_us) {
+        struct pollfd pfd = {fd_, POLLIN, 0};
+        uint64_t deadline = now_us() + timeout_us;
+        uint64_t now;
+        int e;
+
+        for (;;) {
+            now = now_us();
+            if (now > deadline)
+                now = deadline;
+            /* round up, poll() has a millisecond resolution */
+            e = poll(&pfd, 1, static_cast<int>((deadline - now + 999) / 1000));
+            if (e > 0)
+                break;
+            if (e == 0)
+                return 0;
+            if (errno != EINTR)
+                return -1;
+        }
+        return static_cast<int16_t>(read(fd_, data, max_len));
+    }
+
+  protected:
+    FdTransport() = default;
+
+    /*
+     * Open a terminal in raw mode with read() never blocking, like
+     * sensirion_uart_open_port(). Non-blocking while opening so a serial port
+     * without carrier does not wait for it.
+     */
+    void open_raw(const char* path, speed_t baud) {
+        struct termios options;
+
+        fd_ = open(path, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (fd_ < 0)
+            return;
+        if (tcgetattr(fd_, &options)) {
+            reset();
+            return;
+        }
+        options.c_cflag = baud | CS8 | CLOCAL | CREAD;
+        options.c_iflag = IGNPAR;
+        options.c_oflag = 0;
+        options.c_lflag = 0;
+        options.c_cc[VMIN] = 0;
+        options.c_cc[VTIME] = 0;
+        tcflush(fd_, TCIFLUSH);
+        tcsetattr(fd_, TCSANOW, &options);
+        fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) & ~O_NONBLOCK);
+    }
+
+    void reset() {
+        if (fd_ >= 0)
+            close(fd_);
+        fd_ = -1;
+    }
+
+  private:
+    static uint64_t now_us() {
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000 +
+               static_cast<uint64_t>(ts.tv_nsec) / 1000;
+    }
+
+    int fd_ = -1;
+};
+
+/**
+ * A serial port at 115200 baud. In low latency mode ASYNC_LOW_LATENCY is set
+ * and transmissions are drained, see sensirion_uart_set_low_latency(). The
+ * latency timer of USB serial adapters is left to the Linux UART HAL.
+ */
+class LinuxTty : public FdTransport {
+  public:
+    explicit LinuxTty(const char* path,
+                      bool low_latency = SENSIRION_UART_LOW_LATENCY)
+        : drain_(low_latency) {
+        const int async_low_latency = static_cast<int>(ASYNC_LOW_LATENCY);
+        struct serial_struct serial;
+
+        open_raw(path, B115200);
+        if (!valid() || !low_latency || ioctl(fd(), TIOCGSERIAL, &serial))
+            return;
+        if (!(serial.flags & async_low_latency)) {
+            serial.flags |= async_low_latency;
+            ioctl(fd(), TIOCSSERIAL, &serial);
+        }
+    }
+
+    int16_t tx(uint16_t len, const uint8_t* data) {
+        int16_t ret = FdTransport::tx(len, data);
+
+        if (ret > 0 && drain_)
+            tcdrain(fd());
+        return ret;
+    }
+
+  private:
+    bool drain_;
+};
+
+/**
+ * The slave side of a pseudo terminal, e.g. sps30_simulator_path(). Only raw
+ * mode is set, there is no baud rate or serial driver to tune.
+ */
+class Pty : public FdTransport {
+  public:
+    explicit Pty(const char* path) {
+        open_raw(path, B115200);
+    }
+};
+
+/**
+ * A capture of sensirion_uart_capture_start() replayed as in
+ * sensirion_uart_replay_open()
+ */
+class Replay {
+  public:
+    Replay(const char* path, uint8_t port, uint32_t speed)
+        : valid_(!sensirion_uart_replay_open(&replay_, path, port, speed)) {
+    }
+
+    Replay(Replay&& other) noexcept
+        : replay_(other.replay_), valid_(std::exchange(other.valid_, false)) {
+        other.replay_.data = nullptr;
+    }
+
+    Replay& operator=(Replay&& other) noexcept {
+        if (this != &other) {
+            if (valid_)
+                sensirion_uart_replay_close(&replay_);
+            replay_ = other.replay_;
+            valid_ = std::exchange(other.valid_, false);
+            other.replay_.data = nullptr;
+        }
+        return *this;
+    }
+
+    Replay(const Replay&) = delete;
+    Replay& operator=(const Replay&) = delete;
+
+    ~Replay() {
+        if (valid_)
+            sensirion_uart_replay_close(&replay_);
+    }
+
+    bool valid() const {
+        return valid_;
+    }
+
+    /* the statistics and sensirion_uart_replay_rewind()/_done() */
+    struct sensirion_uart_replay& replay() {
+        return replay_;
+    }
+
+    int16_t tx(uint16_t len, const uint8_t* data) {
+        return sensirion_uart_replay_tx(&replay_, len, data);
+    }
+
+    int16_t rx(uint16_t max_len, uint8_t* data, uint32_t timeout_us) {
+        return sensirion_uart_replay_rx_timeout(&replay_, max_len, data,
+                                                timeout_us);
+    }
+
+  private:
+    struct sensirion_uart_replay replay_ = {};
+    bool valid_;
+};
+
+}  // namespace uart
+}  // namespace sensirion
+
+#endif /* SENSIRION_UART_TRANSPORT_HPP */
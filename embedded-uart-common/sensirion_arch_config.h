@@ -60,6 +60,16 @@ extern "C" {
 #define NULL ((void*)0)
 #endif
 
+/**
+ * Marks the default implementations of optional UART HAL functions, e.g.
+ * sensirion_uart_txv(), which a HAL replaces by implementing the function.
+ * On compilers without weak symbols leave it undefined, the HAL must then
+ * implement all functions of sensirion_uart.h.
+ */
+#if !defined(SENSIRION_WEAK) && (defined(__GNUC__) || defined(__clang__))
+#define SENSIRION_WEAK __attribute__((weak))
+#endif
+
 #ifdef __cplusplus
 }
 #endif
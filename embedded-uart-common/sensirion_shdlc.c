@@ -33,18 +33,153 @@
 #include "sensirion_arch_config.h"
 #include "sensirion_uart.h"
 
+#include <string.h>
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#include <emmintrin.h>
+#define SHDLC_USE_SSE2
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#define SHDLC_USE_SSSE3
+#endif
+#elif defined(__GNUC__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SHDLC_USE_NEON
+#endif
+
 #define SHDLC_START 0x7e
 #define SHDLC_STOP 0x7e
 
 #define SHDLC_MIN_TX_FRAME_SIZE 6
-/** start/stop + (4 header + 255 data) * 2 because of byte stuffing */
-#define SHDLC_FRAME_MAX_TX_FRAME_SIZE (2 + (4 + 255) * 2)
 
-/** start/stop + (5 header + 255 data) * 2 because of byte stuffing */
-#define SHDLC_FRAME_MAX_RX_FRAME_SIZE (2 + (5 + 255) * 2)
+/**
+ * Stuffed bytes (header, escaped data, checksum) buffered per
+ * sensirion_uart_txv() call. Only frames with many escaped bytes need more
+ * than one call.
+ */
+#define SHDLC_TX_BUF_SIZE 64
+
+/** Shorter runs of data are copied instead of getting their own iovec */
+#define SHDLC_TX_MIN_REF_LEN 8
 
 #define RX_DELAY_US 20000
 
+/**
+ * Once the start of a frame was received, wait up to
+ * RX_CHUNK_DELAY_US * RX_MAX_CHUNK_DELAYS for the rest of it. A max. length
+ * frame takes 45ms on the wire at 115200 baud.
+ */
+#define RX_CHUNK_DELAY_US 1000
+#define RX_MAX_CHUNK_DELAYS 50
+
+/**
+ * Max. gap between two chunks of the same frame when waiting for data. Leaves
+ * room for the latency timer of USB-serial adapters (16ms on FTDI).
+ */
+#define RX_CHUNK_TIMEOUT_US 50000
+
+/* polling interval of the default sensirion_uart_rx_timeout() */
+#define RX_POLL_INTERVAL_US 1000
+
+enum sensirion_shdlc_rx_state {
+    SHDLC_RX_STATE_START,
+    SHDLC_RX_STATE_SKIP,
+    SHDLC_RX_STATE_HEADER,
+    SHDLC_RX_STATE_DATA,
+    SHDLC_RX_STATE_CRC,
+    SHDLC_RX_STATE_STOP,
+    SHDLC_RX_STATE_DONE,
+};
+
+#ifdef SENSIRION_WEAK
+/* used unless the UART HAL implements scatter/gather */
+SENSIRION_WEAK int16_t
+sensirion_uart_txv(uint8_t iovcnt, const struct sensirion_uart_iovec* iov) {
+    int16_t sent = 0;
+    int16_t ret;
+    uint8_t i;
+
+    for (i = 0; i < iovcnt; ++i) {
+        ret = sensirion_uart_tx(iov[i].len, iov[i].data);
+        if (ret < 0)
+            return ret;
+        sent += ret;
+        if (ret != iov[i].len)
+            break;
+    }
+    return sent;
+}
+
+/* used unless the UART HAL can wait for input */
+SENSIRION_WEAK int16_t sensirion_uart_rx_timeout(uint16_t max_data_len,
+                                                 uint8_t* data,
+                                                 uint32_t timeout_us) {
+    uint32_t waited = 0;
+    int16_t ret;
+
+    for (;;) {
+        ret = sensirion_uart_rx(max_data_len, data);
+        if (ret != 0 || waited >= timeout_us)
+            return ret;
+        sensirion_sleep_usec(RX_POLL_INTERVAL_US);
+        waited += RX_POLL_INTERVAL_US;
+    }
+}
+
+/* used unless the UART HAL supports hot-plugged UARTs */
+SENSIRION_WEAK int16_t sensirion_uart_wait_device(uint32_t timeout_us) {
+    return 0;
+}
+
+/* used unless the HAL has a clock */
+SENSIRION_WEAK uint32_t sensirion_time_usec(void) {
+    return 0;
+}
+#endif /* SENSIRION_WEAK */
+
+static int16_t sensirion_uart_default_tx(void* ctx, uint16_t data_len,
+                                         const uint8_t* data) {
+    return sensirion_uart_tx(data_len, data);
+}
+
+static int16_t
+sensirion_uart_default_txv(void* ctx, uint8_t iovcnt,
+                           const struct sensirion_uart_iovec* iov) {
+    return sensirion_uart_txv(iovcnt, iov);
+}
+
+static int16_t sensirion_uart_default_rx_timeout(void* ctx,
+                                                 uint16_t max_data_len,
+                                                 uint8_t* data,
+                                                 uint32_t timeout_us) {
+#ifdef SENSIRION_SHDLC_FIXED_RX_DELAY
+    /* the HAL does not need to implement sensirion_uart_rx_timeout() */
+    return sensirion_uart_rx(max_data_len, data);
+#else
+    return sensirion_uart_rx_timeout(max_data_len, data, timeout_us);
+#endif
+}
+
+#ifdef SENSIRION_SHDLC_FIXED_RX_DELAY
+/* the number of delays bounds the response */
+#define sensirion_uart_default_time_usec NULL
+#else
+static uint32_t sensirion_uart_default_time_usec(void* ctx) {
+    return sensirion_time_usec();
+}
+#endif
+
+const struct sensirion_uart_ops sensirion_uart_default_ops = {
+    sensirion_uart_default_tx,
+    sensirion_uart_default_txv,
+    sensirion_uart_default_rx_timeout,
+    sensirion_uart_default_time_usec,
+};
+
+/* used by the functions without _dev suffix */
+static struct sensirion_shdlc_dev default_dev = {&sensirion_uart_default_ops,
+                                                 NULL, 0, 0, {0}};
+
 uint16_t sensirion_bytes_to_uint16_t(const uint8_t* bytes) {
     return (uint16_t)bytes[0] << 8 | (uint16_t)bytes[1];
 }
@@ -72,6 +207,47 @@ float sensirion_bytes_to_float(const uint8_t* bytes) {
     return tmp.float32;
 }
 
+void sensirion_be32_array_to_float(uint16_t count, const uint8_t* bytes,
+                                   float* values) {
+    uint8_t* out = (uint8_t*)values;
+    uint16_t i = 0;
+    uint32_t word;
+
+#if defined(SHDLC_USE_SSE2)
+#if defined(SHDLC_USE_SSSE3)
+    const __m128i bswap32 =
+        _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+#endif
+    __m128i v;
+
+    for (; i + 4 <= count; i += 4) {
+        v = _mm_loadu_si128((const __m128i*)&bytes[i * 4]);
+#if defined(SHDLC_USE_SSSE3)
+        v = _mm_shuffle_epi8(v, bswap32);
+#else
+        /* swap the bytes of each half word, then the half words */
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xb1), 0xb1);
+#endif
+        _mm_storeu_si128((__m128i*)&out[i * 4], v);
+    }
+#elif defined(SHDLC_USE_NEON)
+    for (; i + 4 <= count; i += 4)
+        vst1q_u8(&out[i * 4], vrev32q_u8(vld1q_u8(&bytes[i * 4])));
+#endif
+
+    for (; i < count; ++i) {
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        memcpy(&word, &bytes[i * 4], sizeof(word));
+        word = __builtin_bswap32(word);
+#else
+        word = sensirion_bytes_to_uint32_t(&bytes[i * 4]);
+#endif
+        memcpy(&out[i * 4], &word, sizeof(word));
+    }
+}
+
 void sensirion_uint32_t_to_bytes(const uint32_t value, uint8_t* bytes) {
     bytes[0] = value >> 24;
     bytes[1] = value >> 16;
@@ -105,40 +281,102 @@ void sensirion_float_to_bytes(const float value, uint8_t* bytes) {
     sensirion_uint32_t_to_bytes(tmp.u32_value, bytes);
 }
 
-static uint8_t sensirion_shdlc_crc(uint8_t header_sum, uint8_t data_len,
-                                   const uint8_t* data) {
-    header_sum += data_len;
+/**
+ * Bytes which need to be escaped, the value is the escaped byte following
+ * the 0x7d escape byte, 0 for bytes that are transmitted as is.
+ */
+static const uint8_t sensirion_shdlc_escape[256] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x31, 0x00, 0x33, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x5d, 0x5e, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00};
 
-    while (data_len--)
-        header_sum += *(data++);
+/** Nonzero if any of the bytes in the 32bit word v is zero */
+#define SHDLC_HAS_ZERO_BYTE(v) (((v) - 0x01010101UL) & ~(v) & 0x80808080UL)
+#define SHDLC_HAS_BYTE(v, b) SHDLC_HAS_ZERO_BYTE((v) ^ (0x01010101UL * (b)))
+#define SHDLC_HAS_ESCAPE(v)                                                    \
+    (SHDLC_HAS_BYTE(v, 0x11) | SHDLC_HAS_BYTE(v, 0x13) |                       \
+     SHDLC_HAS_BYTE(v, 0x7d) | SHDLC_HAS_BYTE(v, 0x7e))
 
-    return ~header_sum;
+static uint8_t* sensirion_shdlc_stuff_byte(uint8_t c, uint8_t* stuffed) {
+    uint8_t escaped = sensirion_shdlc_escape[c];
+
+    if (escaped) {
+        *(stuffed++) = 0x7d;
+        *(stuffed++) = escaped;
+    } else {
+        *(stuffed++) = c;
+    }
+    return stuffed;
 }
 
-static uint16_t sensirion_shdlc_stuff_data(uint8_t data_len,
+/**
+ * Byte-stuff data and sum it up in a single pass, four bytes at a time. Words
+ * without any byte that needs escaping are copied as is. The sum is
+ * accumulated in two 16bit lanes which cannot overflow for 255 bytes.
+ *
+ * Return: Pointer to the end of the stuffed data
+ */
+static uint8_t* sensirion_shdlc_stuff_data(uint8_t data_len,
                                            const uint8_t* data,
-                                           uint8_t* stuffed_data) {
-    uint16_t output_data_len = 0;
-    uint8_t c;
+                                           uint8_t* stuffed, uint8_t* sum) {
+    uint32_t lanes = 0;
+    uint32_t word;
+    uint8_t i;
 
-    while (data_len--) {
-        c = *(data++);
-        switch (c) {
-            case 0x11:
-            case 0x13:
-            case 0x7d:
-            case 0x7e:
-                // byte stuffing is done by inserting 0x7d and inverting bit 5
-                *(stuffed_data++) = 0x7d;
-                *(stuffed_data++) = c ^ (1 << 5);
-                output_data_len += 2;
-                break;
-            default:
-                *(stuffed_data++) = c;
-                output_data_len += 1;
+    for (; data_len >= sizeof(word); data_len -= sizeof(word)) {
+        memcpy(&word, data, sizeof(word));
+        lanes += (word & 0x00ff00ffUL) + ((word >> 8) & 0x00ff00ffUL);
+        if (SHDLC_HAS_ESCAPE(word)) {
+            for (i = 0; i < sizeof(word); ++i)
+                stuffed = sensirion_shdlc_stuff_byte(data[i], stuffed);
+        } else {
+            memcpy(stuffed, &word, sizeof(word));
+            stuffed += sizeof(word);
         }
+        data += sizeof(word);
+    }
+    while (data_len--) {
+        lanes += *data;
+        stuffed = sensirion_shdlc_stuff_byte(*(data++), stuffed);
     }
-    return output_data_len;
+
+    *sum += (uint8_t)(lanes + (lanes >> 16));
+    return stuffed;
+}
+
+uint16_t sensirion_shdlc_encode(uint8_t addr, uint8_t cmd, uint8_t data_len,
+                                const uint8_t* data, uint8_t* frame) {
+    uint8_t* out = frame;
+    uint8_t sum = addr + cmd + data_len;
+
+    *(out++) = SHDLC_START;
+    out = sensirion_shdlc_stuff_byte(addr, out);
+    out = sensirion_shdlc_stuff_byte(cmd, out);
+    out = sensirion_shdlc_stuff_byte(data_len, out);
+    out = sensirion_shdlc_stuff_data(data_len, data, out, &sum);
+    out = sensirion_shdlc_stuff_byte((uint8_t)~sum, out);
+    *(out++) = SHDLC_STOP;
+
+    return (uint16_t)(out - frame);
 }
 
 static uint8_t sensirion_shdlc_check_unstuff(uint8_t data) {
@@ -160,103 +398,815 @@ static uint8_t sensirion_shdlc_unstuff_byte(uint8_t data) {
     }
 }
 
-int16_t sensirion_shdlc_xcv(uint8_t addr, uint8_t cmd, uint8_t tx_data_len,
-                            const uint8_t* tx_data, uint8_t max_rx_data_len,
+void sensirion_shdlc_dev_init(struct sensirion_shdlc_dev* dev,
+                              const struct sensirion_uart_ops* uart,
+                              void* uart_ctx) {
+    memset(dev, 0, sizeof(*dev));
+    dev->uart = uart;
+    dev->uart_ctx = uart_ctx;
+}
+
+static int16_t
+sensirion_shdlc_rx_response(struct sensirion_shdlc_dev* dev,
+                            uint8_t max_rx_data_len,
                             struct sensirion_shdlc_rx_header* rx_header,
-                            uint8_t* rx_data) {
+                            uint8_t* rx_data, uint32_t rx_timeout_us) {
+#ifdef SENSIRION_SHDLC_FIXED_RX_DELAY
+    sensirion_sleep_usec(RX_DELAY_US);
+#endif
+    return sensirion_shdlc_rx_timeout_dev(dev, max_rx_data_len, rx_header,
+                                          rx_data, rx_timeout_us);
+}
+
+int16_t sensirion_shdlc_xcv_dev(struct sensirion_shdlc_dev* dev, uint8_t addr,
+                                uint8_t cmd, uint8_t tx_data_len,
+                                const uint8_t* tx_data, uint8_t max_rx_data_len,
+                                struct sensirion_shdlc_rx_header* rx_header,
+                                uint8_t* rx_data) {
+    return sensirion_shdlc_xcv_timeout_dev(dev, addr, cmd, tx_data_len, tx_data,
+                                           max_rx_data_len, rx_header, rx_data,
+                                           SENSIRION_SHDLC_RX_TIMEOUT_US);
+}
+
+int16_t sensirion_shdlc_xcv_timeout_dev(
+    struct sensirion_shdlc_dev* dev, uint8_t addr, uint8_t cmd,
+    uint8_t tx_data_len, const uint8_t* tx_data, uint8_t max_rx_data_len,
+    struct sensirion_shdlc_rx_header* rx_header, uint8_t* rx_data,
+    uint32_t rx_timeout_us) {
     int16_t ret;
 
-    ret = sensirion_shdlc_tx(addr, cmd, tx_data_len, tx_data);
+    ret = sensirion_shdlc_tx_dev(dev, addr, cmd, tx_data_len, tx_data);
     if (ret != 0)
         return ret;
 
+    return sensirion_shdlc_rx_response(dev, max_rx_data_len, rx_header,
+                                       rx_data, rx_timeout_us);
+}
+
+int16_t sensirion_shdlc_xcv_batch_dev(struct sensirion_shdlc_dev* dev,
+                                      uint8_t addr, uint8_t cmd_count,
+                                      struct sensirion_shdlc_batch_cmd* cmds,
+                                      uint32_t rx_timeout_us) {
+    struct sensirion_shdlc_rx_header header;
+    struct sensirion_shdlc_batch_cmd* match;
+    uint8_t data[255];
+    uint8_t received = 0;
+    uint8_t i;
+    int16_t first_err = 0;
+    int16_t ret;
+
+    for (i = 0; i < cmd_count; ++i) {
+        cmds[i].status = SENSIRION_SHDLC_ERR_NO_DATA;
+        ret = sensirion_shdlc_tx_dev(dev, addr, cmds[i].cmd,
+                                     cmds[i].tx_data_len, cmds[i].tx_data);
+        if (ret != 0)
+            return ret;
+    }
+
+#ifdef SENSIRION_SHDLC_FIXED_RX_DELAY
     sensirion_sleep_usec(RX_DELAY_US);
-    return sensirion_shdlc_rx(max_rx_data_len, rx_header, rx_data);
+#endif
+    while (received < cmd_count) {
+        /* the data is received into a buffer first since the receiving
+         * command is only known once the header is complete */
+        ret = sensirion_shdlc_rx_timeout_dev(dev, sizeof(data), &header, data,
+                                             rx_timeout_us);
+        if (ret != 0 && !first_err)
+            first_err = ret;
+        if (ret == SENSIRION_SHDLC_ERR_CRC_MISMATCH ||
+            ret == SENSIRION_SHDLC_ERR_ENCODING_ERROR) {
+            /* a response was lost, the others must not be left behind for
+             * the next transaction */
+            ++received;
+            continue;
+        }
+        if (ret != 0)
+            break;
+
+        for (match = NULL, i = 0; i < cmd_count && !match; ++i) {
+            if (cmds[i].status == SENSIRION_SHDLC_ERR_NO_DATA &&
+                cmds[i].cmd == header.cmd)
+                match = &cmds[i];
+        }
+        if (!match)
+            continue;
+
+        match->rx_header = header;
+        if (header.data_len > match->max_rx_data_len) {
+            match->status = SENSIRION_SHDLC_ERR_FRAME_TOO_LONG;
+        } else {
+            if (header.data_len)
+                memcpy(match->rx_data, data, header.data_len);
+            match->status = 0;
+        }
+        ++received;
+    }
+
+    if (first_err)
+        return first_err;
+    for (i = 0; i < cmd_count; ++i) {
+        if (cmds[i].status != 0)
+            return cmds[i].status;
+    }
+    return 0;
 }
 
-int16_t sensirion_shdlc_tx(uint8_t addr, uint8_t cmd, uint8_t data_len,
-                           const uint8_t* data) {
-    uint16_t len = 0;
+int16_t sensirion_shdlc_xcv_rawv_dev(
+    struct sensirion_shdlc_dev* dev, uint8_t tx_iovcnt,
+    const struct sensirion_uart_iovec* tx_iov, uint8_t max_rx_data_len,
+    struct sensirion_shdlc_rx_header* rx_header, uint8_t* rx_data,
+    uint32_t rx_timeout_us) {
+    int16_t ret;
+
+    ret = sensirion_shdlc_tx_rawv_dev(dev, tx_iovcnt, tx_iov);
+    if (ret != 0)
+        return ret;
+
+    return sensirion_shdlc_rx_response(dev, max_rx_data_len, rx_header,
+                                       rx_data, rx_timeout_us);
+}
+
+int16_t sensirion_shdlc_xcv_raw_dev(struct sensirion_shdlc_dev* dev,
+                                    uint16_t tx_frame_len,
+                                    const uint8_t* tx_frame,
+                                    uint8_t max_rx_data_len,
+                                    struct sensirion_shdlc_rx_header* rx_header,
+                                    uint8_t* rx_data, uint32_t rx_timeout_us) {
+    int16_t ret;
+
+    ret = sensirion_shdlc_tx_raw_dev(dev, tx_frame_len, tx_frame);
+    if (ret != 0)
+        return ret;
+
+    return sensirion_shdlc_rx_response(dev, max_rx_data_len, rx_header,
+                                       rx_data, rx_timeout_us);
+}
+
+/**
+ * Number of leading bytes which can be transmitted without stuffing
+ */
+static uint8_t sensirion_shdlc_find_tx_escape(const uint8_t* data,
+                                              uint8_t data_len) {
+    uint8_t i = 0;
+    uint32_t word;
+
+    for (; i + sizeof(word) <= data_len; i += sizeof(word)) {
+        memcpy(&word, &data[i], sizeof(word));
+        if (SHDLC_HAS_ESCAPE(word))
+            break;
+    }
+    while (i < data_len && !sensirion_shdlc_escape[data[i]])
+        ++i;
+    return i;
+}
+
+/** Sum of the data bytes, see sensirion_shdlc_stuff_data() */
+static uint8_t sensirion_shdlc_sum(uint8_t data_len, const uint8_t* data) {
+    uint32_t lanes = 0;
+    uint32_t word;
+
+    for (; data_len >= sizeof(word); data_len -= sizeof(word)) {
+        memcpy(&word, data, sizeof(word));
+        lanes += (word & 0x00ff00ffUL) + ((word >> 8) & 0x00ff00ffUL);
+        data += sizeof(word);
+    }
+    while (data_len--)
+        lanes += *(data++);
+    return (uint8_t)(lanes + (lanes >> 16));
+}
+
+/**
+ * Frame under construction for sensirion_uart_txv(): runs of data which need
+ * no stuffing are sent from the caller's buffer, everything else is stuffed
+ * into buf. The iovecs are flushed early if either of them is full.
+ */
+struct sensirion_shdlc_txv {
+    struct sensirion_shdlc_dev* dev;
+    struct sensirion_uart_iovec iov[SENSIRION_UART_MAX_IOV];
+    uint8_t iovcnt;
+    uint8_t buf_len;
+    uint8_t buf[SHDLC_TX_BUF_SIZE];
+};
+
+static int16_t sensirion_shdlc_txv_flush(struct sensirion_shdlc_txv* txv) {
     int16_t ret;
+
+    ret = sensirion_shdlc_tx_rawv_dev(txv->dev, txv->iovcnt, txv->iov);
+    txv->iovcnt = 0;
+    txv->buf_len = 0;
+    return ret;
+}
+
+static int16_t sensirion_shdlc_txv_ref(struct sensirion_shdlc_txv* txv,
+                                       const uint8_t* data, uint8_t len) {
+    int16_t ret;
+
+    if (txv->iovcnt == SENSIRION_UART_MAX_IOV) {
+        ret = sensirion_shdlc_txv_flush(txv);
+        if (ret != 0)
+            return ret;
+    }
+    txv->iov[txv->iovcnt].data = data;
+    txv->iov[txv->iovcnt].len = len;
+    ++txv->iovcnt;
+    return 0;
+}
+
+/** Copy up to two bytes into buf, appending to the last iovec if possible */
+static int16_t sensirion_shdlc_txv_put(struct sensirion_shdlc_txv* txv,
+                                       const uint8_t* bytes, uint8_t len) {
+    struct sensirion_uart_iovec* last = NULL;
+    uint8_t* out = &txv->buf[txv->buf_len];
+    int16_t ret;
+
+    if (txv->iovcnt) {
+        last = &txv->iov[txv->iovcnt - 1];
+        if (last->data + last->len != out)
+            last = NULL;
+    }
+
+    /*
+     * Flush before copying: the flush empties buf, bytes copied before it
+     * would be overwritten before they were sent
+     */
+    if (txv->buf_len + len > SHDLC_TX_BUF_SIZE ||
+        (!last && txv->iovcnt == SENSIRION_UART_MAX_IOV)) {
+        ret = sensirion_shdlc_txv_flush(txv);
+        if (ret != 0)
+            return ret;
+        last = NULL;
+        out = txv->buf;
+    }
+
+    memcpy(out, bytes, len);
+    txv->buf_len += len;
+    if (last) {
+        last->len += len;
+        return 0;
+    }
+    return sensirion_shdlc_txv_ref(txv, out, len);
+}
+
+/** Stuff data into buf, appending to the last iovec if possible */
+static int16_t sensirion_shdlc_txv_stuff(struct sensirion_shdlc_txv* txv,
+                                         const uint8_t* data,
+                                         uint8_t data_len) {
+    struct sensirion_uart_iovec* last;
+    uint8_t* out;
+    uint8_t* end;
+    uint8_t len;
+    uint8_t i;
+    int16_t ret;
+
+    while (data_len) {
+        out = &txv->buf[txv->buf_len];
+        last = txv->iovcnt ? &txv->iov[txv->iovcnt - 1] : NULL;
+        if (last && last->data + last->len != out)
+            last = NULL;
+
+        /* as many bytes as fit even if all of them need escaping */
+        len = (uint8_t)((SHDLC_TX_BUF_SIZE - txv->buf_len) / 2);
+        if (len > data_len)
+            len = data_len;
+        if (!len || (!last && txv->iovcnt == SENSIRION_UART_MAX_IOV)) {
+            ret = sensirion_shdlc_txv_flush(txv);
+            if (ret != 0)
+                return ret;
+            continue;
+        }
+
+        for (end = out, i = 0; i < len; ++i)
+            end = sensirion_shdlc_stuff_byte(data[i], end);
+        txv->buf_len = (uint8_t)(txv->buf_len + (end - out));
+        if (last) {
+            last->len = (uint16_t)(last->len + (end - out));
+        } else {
+            txv->iov[txv->iovcnt].data = out;
+            txv->iov[txv->iovcnt].len = (uint16_t)(end - out);
+            ++txv->iovcnt;
+        }
+        data += len;
+        data_len -= len;
+    }
+    return 0;
+}
+
+int16_t sensirion_shdlc_tx_dev(struct sensirion_shdlc_dev* dev, uint8_t addr,
+                               uint8_t cmd, uint8_t data_len,
+                               const uint8_t* data) {
+    struct sensirion_shdlc_txv txv;
+    const uint8_t start = SHDLC_START;
+    const uint8_t stop = SHDLC_STOP;
+    const uint8_t header[] = {addr, cmd, data_len};
     uint8_t crc;
-    uint8_t tx_frame_buf[SHDLC_FRAME_MAX_TX_FRAME_SIZE];
+    uint8_t run;
+    uint8_t i;
+    int16_t ret;
+
+    crc = addr + cmd + data_len + sensirion_shdlc_sum(data_len, data);
+    crc = (uint8_t)~crc;
+    txv.dev = dev;
+    txv.iovcnt = 0;
+    txv.buf_len = 0;
 
-    crc = sensirion_shdlc_crc(addr + cmd, data_len, data);
+    /* the header always fits */
+    (void)sensirion_shdlc_txv_put(&txv, &start, 1);
+    (void)sensirion_shdlc_txv_stuff(&txv, header, sizeof(header));
 
-    tx_frame_buf[len++] = SHDLC_START;
-    len += sensirion_shdlc_stuff_data(1, &addr, tx_frame_buf + len);
-    len += sensirion_shdlc_stuff_data(1, &cmd, tx_frame_buf + len);
-    len += sensirion_shdlc_stuff_data(1, &data_len, tx_frame_buf + len);
-    len += sensirion_shdlc_stuff_data(data_len, data, tx_frame_buf + len);
-    len += sensirion_shdlc_stuff_data(1, &crc, tx_frame_buf + len);
-    tx_frame_buf[len++] = SHDLC_STOP;
+    /*
+     * Runs without escapes of at least SHDLC_TX_MIN_REF_LEN bytes are sent
+     * from the caller's buffer, the i bytes in front of such a run (escapes
+     * and shorter runs) are stuffed into buf
+     */
+    i = 0;
+    while (i < data_len) {
+        if (sensirion_shdlc_escape[data[i]]) {
+            ++i;
+            continue;
+        }
+        run = sensirion_shdlc_find_tx_escape(&data[i], data_len - i);
+        if (run < SHDLC_TX_MIN_REF_LEN) {
+            i += run;
+            continue;
+        }
+        ret = sensirion_shdlc_txv_stuff(&txv, data, i);
+        if (ret == 0)
+            ret = sensirion_shdlc_txv_ref(&txv, &data[i], run);
+        if (ret != 0)
+            return ret;
+        data += i + run;
+        data_len -= i + run;
+        i = 0;
+    }
 
-    ret = sensirion_uart_tx(len, tx_frame_buf);
+    ret = sensirion_shdlc_txv_stuff(&txv, data, data_len);
+    if (ret == 0)
+        ret = sensirion_shdlc_txv_stuff(&txv, &crc, 1);
+    if (ret == 0)
+        ret = sensirion_shdlc_txv_put(&txv, &stop, 1);
+    if (ret != 0)
+        return ret;
+    return sensirion_shdlc_txv_flush(&txv);
+}
+
+int16_t sensirion_shdlc_tx_raw_dev(struct sensirion_shdlc_dev* dev,
+                                   uint16_t frame_len, const uint8_t* frame) {
+    int16_t ret;
+
+    ret = dev->uart->tx(dev->uart_ctx, frame_len, frame);
     if (ret < 0)
         return ret;
-    if (ret != len)
+    if (ret != frame_len)
         return SENSIRION_SHDLC_ERR_TX_INCOMPLETE;
     return 0;
 }
 
-int16_t sensirion_shdlc_rx(uint8_t max_data_len,
-                           struct sensirion_shdlc_rx_header* rxh,
-                           uint8_t* data) {
-    int16_t len;
-    uint16_t i;
-    uint8_t rx_frame[SHDLC_FRAME_MAX_RX_FRAME_SIZE];
-    uint8_t* rx_header = (uint8_t*)rxh;
-    uint8_t j;
-    uint8_t crc;
-    uint8_t unstuff_next;
+int16_t sensirion_shdlc_tx_rawv_dev(struct sensirion_shdlc_dev* dev,
+                                    uint8_t iovcnt,
+                                    const struct sensirion_uart_iovec* iov) {
+    uint16_t len = 0;
+    int16_t ret;
+    uint8_t i;
+
+    for (i = 0; i < iovcnt; ++i)
+        len += iov[i].len;
+
+    ret = dev->uart->txv(dev->uart_ctx, iovcnt, iov);
+    if (ret < 0)
+        return ret;
+    if ((uint16_t)ret != len)
+        return SENSIRION_SHDLC_ERR_TX_INCOMPLETE;
+    return 0;
+}
+
+/**
+ * Number of leading bytes which are neither an escape nor a frame delimiter
+ * and thus can be copied as is.
+ */
+static uint16_t sensirion_shdlc_find_escape(const uint8_t* bytes,
+                                            uint16_t len) {
+    uint16_t i = 0;
+    uint32_t word;
 
-    len = sensirion_uart_rx(2 + (5 + (uint16_t)max_data_len) * 2, rx_frame);
-    if (len < 1 || rx_frame[0] != SHDLC_START)
-        return SENSIRION_SHDLC_ERR_MISSING_START;
+#if defined(SHDLC_USE_SSE2)
+    const __m128i escape = _mm_set1_epi8(0x7d);
+    const __m128i stop = _mm_set1_epi8(SHDLC_STOP);
+    __m128i v;
+    int mask;
+
+    for (; i + 16 <= len; i += 16) {
+        v = _mm_loadu_si128((const __m128i*)&bytes[i]);
+        mask = _mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(v, escape), _mm_cmpeq_epi8(v, stop)));
+        if (mask)
+            return (uint16_t)(i + __builtin_ctz((unsigned)mask));
+    }
+#elif defined(SHDLC_USE_NEON)
+    uint8x16_t v;
+    uint64_t mask;
+
+    for (; i + 16 <= len; i += 16) {
+        v = vld1q_u8(&bytes[i]);
+        v = vorrq_u8(vceqq_u8(v, vdupq_n_u8(0x7d)),
+                     vceqq_u8(v, vdupq_n_u8(SHDLC_STOP)));
+        /* narrow to one nibble per byte */
+        mask = vget_lane_u64(
+            vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(v), 4)), 0);
+        if (mask)
+            return (uint16_t)(i + __builtin_ctzll(mask) / 4);
+    }
+#endif
 
-    for (unstuff_next = 0, i = 1, j = 0; j < sizeof(*rxh) && i < len - 2; ++i) {
+    for (; i + sizeof(word) <= len; i += sizeof(word)) {
+        memcpy(&word, &bytes[i], sizeof(word));
+        if (SHDLC_HAS_BYTE(word, 0x7d) | SHDLC_HAS_BYTE(word, SHDLC_STOP))
+            break;
+    }
+    while (i < len && bytes[i] != 0x7d && bytes[i] != SHDLC_STOP)
+        ++i;
+    return i;
+}
+
+/**
+ * Decode data bytes: runs of bytes which need no un-stuffing are copied as a
+ * whole. The bytes may overlap with the data buffer when decoding in place
+ * since un-stuffing never makes the data longer.
+ *
+ * Return: Number of bytes consumed, decoding stops in front of a frame
+ *         delimiter
+ */
+static uint16_t sensirion_shdlc_rx_data(struct sensirion_shdlc_rx_decoder* dec,
+                                        uint16_t len, const uint8_t* bytes) {
+    /* work on copies since writing the data may alias the decoder state */
+    uint8_t* data = dec->data;
+    uint16_t pos = dec->pos;
+    uint16_t data_len = dec->header->data_len;
+    uint8_t unstuff_next = dec->unstuff_next;
+    uint8_t sum = dec->crc;
+    uint16_t i = 0;
+    uint16_t run;
+    uint8_t c;
+
+    while (i < len && pos < data_len) {
+        c = bytes[i];
         if (unstuff_next) {
-            rx_header[j++] = sensirion_shdlc_unstuff_byte(rx_frame[i]);
+            c = sensirion_shdlc_unstuff_byte(c);
+            data[pos++] = c;
+            sum += c;
             unstuff_next = 0;
+            ++i;
+        } else if (c == 0x7d) {
+            unstuff_next = 1;
+            ++i;
+        } else if (c == SHDLC_STOP) {
+            /* frame ended prematurely, let the caller resync */
+            break;
         } else {
-            unstuff_next = sensirion_shdlc_check_unstuff(rx_frame[i]);
-            if (!unstuff_next)
-                rx_header[j++] = rx_frame[i];
+            run = (uint16_t)(data_len - pos);
+            if (run > len - i)
+                run = (uint16_t)(len - i);
+            run = sensirion_shdlc_find_escape(&bytes[i], run);
+            if (&data[pos] != &bytes[i])
+                memmove(&data[pos], &bytes[i], run);
+            for (i += run; run; --run)
+                sum += data[pos++];
         }
     }
-    if (j != sizeof(*rxh) || unstuff_next)
-        return SENSIRION_SHDLC_ERR_ENCODING_ERROR;
 
-    if (max_data_len < rxh->data_len)
-        return SENSIRION_SHDLC_ERR_FRAME_TOO_LONG; /* more data than expected */
+    dec->pos = (uint8_t)pos;
+    dec->unstuff_next = unstuff_next;
+    dec->crc = sum;
+    if (pos == data_len)
+        dec->state = SHDLC_RX_STATE_CRC;
+    return i;
+}
 
-    for (unstuff_next = 0, j = 0; j < rxh->data_len && i < len - 2; ++i) {
-        if (unstuff_next) {
-            data[j++] = sensirion_shdlc_unstuff_byte(rx_frame[i]);
-            unstuff_next = 0;
+/**
+ * Restart decoding after an unexpected frame delimiter, assuming it is the
+ * start of a new frame
+ */
+static void sensirion_shdlc_rx_restart(struct sensirion_shdlc_rx_decoder* dec) {
+    dec->state = SHDLC_RX_STATE_HEADER;
+    dec->pos = 0;
+    dec->unstuff_next = 0;
+    dec->crc = 0;
+    ++dec->resyncs;
+}
+
+/** Whether any byte of the frame other than the start byte was decoded */
+static uint8_t
+sensirion_shdlc_rx_started(const struct sensirion_shdlc_rx_decoder* dec) {
+    switch (dec->state) {
+        case SHDLC_RX_STATE_START:
+        case SHDLC_RX_STATE_SKIP:
+            return 0;
+        case SHDLC_RX_STATE_HEADER:
+            return dec->pos || dec->unstuff_next;
+        default:
+            return 1;
+    }
+}
+
+void sensirion_shdlc_rx_decoder_init(struct sensirion_shdlc_rx_decoder* decoder,
+                                     uint8_t max_data_len,
+                                     struct sensirion_shdlc_rx_header* header,
+                                     uint8_t* data) {
+    decoder->header = header;
+    decoder->data = data;
+    decoder->max_data_len = max_data_len;
+    decoder->state = SHDLC_RX_STATE_START;
+    decoder->pos = 0;
+    decoder->unstuff_next = 0;
+    decoder->crc = 0;
+    decoder->resyncs = 0;
+}
+
+int16_t sensirion_shdlc_rx_decode(struct sensirion_shdlc_rx_decoder* dec,
+                                  uint16_t len, const uint8_t* bytes,
+                                  uint16_t* consumed) {
+    uint8_t* rx_header = (uint8_t*)dec->header;
+    uint16_t i;
+    int16_t ret = SENSIRION_SHDLC_RX_INCOMPLETE;
+    uint8_t c;
+
+    for (i = 0; i < len && ret == SENSIRION_SHDLC_RX_INCOMPLETE;) {
+        if (dec->state == SHDLC_RX_STATE_DATA) {
+            i += sensirion_shdlc_rx_data(dec, (uint16_t)(len - i), &bytes[i]);
+            if (dec->state == SHDLC_RX_STATE_DATA && i < len) {
+                /* stopped at a frame delimiter */
+                sensirion_shdlc_rx_restart(dec);
+                ++i;
+            }
+            continue;
+        }
+
+        c = bytes[i++];
+
+        if (dec->state == SHDLC_RX_STATE_START ||
+            dec->state == SHDLC_RX_STATE_SKIP) {
+            if (c == SHDLC_START) {
+                dec->state = SHDLC_RX_STATE_HEADER;
+            } else if (dec->state == SHDLC_RX_STATE_START) {
+                /* noise before the frame, skip up to the next delimiter */
+                dec->state = SHDLC_RX_STATE_SKIP;
+                ++dec->resyncs;
+            }
+            continue;
+        }
+
+        if (dec->state == SHDLC_RX_STATE_STOP) {
+            if (c != SHDLC_STOP) {
+                ret = SENSIRION_SHDLC_ERR_MISSING_STOP;
+            } else {
+                dec->state = SHDLC_RX_STATE_DONE;
+                ret = 0;
+            }
+            continue;
+        }
+
+        if (c == SHDLC_START) {
+            /* a repeated frame delimiter before any header byte is skipped,
+             * otherwise the frame ended prematurely and a new one starts */
+            if (sensirion_shdlc_rx_started(dec))
+                sensirion_shdlc_rx_restart(dec);
+            continue;
+        }
+
+        if (dec->unstuff_next) {
+            c = sensirion_shdlc_unstuff_byte(c);
+            dec->unstuff_next = 0;
+        } else if (sensirion_shdlc_check_unstuff(c)) {
+            dec->unstuff_next = 1;
+            continue;
+        }
+
+        switch (dec->state) {
+            case SHDLC_RX_STATE_HEADER:
+                rx_header[dec->pos++] = c;
+                dec->crc += c;
+                if (dec->pos == sizeof(*dec->header)) {
+                    if (dec->max_data_len < dec->header->data_len)
+                        ret = SENSIRION_SHDLC_ERR_FRAME_TOO_LONG;
+                    dec->pos = 0;
+                    dec->state = dec->header->data_len ? SHDLC_RX_STATE_DATA
+                                                       : SHDLC_RX_STATE_CRC;
+                }
+                break;
+
+            case SHDLC_RX_STATE_CRC:
+                /* the checksum is the inverted sum of all bytes */
+                if ((uint8_t)(dec->crc + c) != 0xff)
+                    ret = SENSIRION_SHDLC_ERR_CRC_MISMATCH;
+                dec->state = SHDLC_RX_STATE_STOP;
+                break;
+        }
+    }
+
+    *consumed = i;
+    return ret;
+}
+
+int16_t sensirion_shdlc_rx_dev(struct sensirion_shdlc_dev* dev,
+                               uint8_t max_data_len,
+                               struct sensirion_shdlc_rx_header* rxh,
+                               uint8_t* data) {
+    return sensirion_shdlc_rx_timeout_dev(dev, max_data_len, rxh, data,
+                                          SENSIRION_SHDLC_RX_TIMEOUT_US);
+}
+
+/* 0 on ports without a clock, the time limits then apply to each read */
+static uint32_t sensirion_shdlc_time_usec(struct sensirion_shdlc_dev* dev) {
+    return dev->uart->time_usec ? dev->uart->time_usec(dev->uart_ctx) : 0;
+}
+
+/**
+ * Keep bytes received after the end of a frame for the next frame. Bytes which
+ * don't fit are dropped, the next frame resyncs in that case.
+ */
+static void sensirion_shdlc_rx_keep(struct sensirion_shdlc_dev* dev,
+                                    const uint8_t* bytes, uint16_t len) {
+    if (len > sizeof(dev->rx_pending) - dev->rx_pending_len)
+        len = (uint16_t)(sizeof(dev->rx_pending) - dev->rx_pending_len);
+    memmove(&dev->rx_pending[dev->rx_pending_len], bytes, len);
+    dev->rx_pending_len = (uint8_t)(dev->rx_pending_len + len);
+}
+
+int16_t sensirion_shdlc_rx_timeout_dev(struct sensirion_shdlc_dev* dev,
+                                       uint8_t max_data_len,
+                                       struct sensirion_shdlc_rx_header* rxh,
+                                       uint8_t* data, uint32_t timeout_us) {
+    struct sensirion_shdlc_rx_decoder decoder;
+    /* whole short frames, everything but the data of long ones */
+    uint8_t rx_chunk[SENSIRION_SHDLC_RX_PENDING_SIZE];
+    uint8_t* rx_buf;
+    uint16_t rx_len;
+    uint16_t consumed;
+    uint32_t start;
+    uint32_t elapsed;
+    uint32_t wait;
+    int16_t len;
+    int16_t ret = SENSIRION_SHDLC_RX_INCOMPLETE;
+#ifdef SENSIRION_SHDLC_FIXED_RX_DELAY
+    uint8_t delays = 0;
+#endif
+
+    start = sensirion_shdlc_time_usec(dev);
+    sensirion_shdlc_rx_decoder_init(&decoder, max_data_len, rxh, data);
+
+    if (dev->rx_pending_len) {
+        /* bytes left over from the last frame come first */
+        rx_len = dev->rx_pending_len;
+        ret = sensirion_shdlc_rx_decode(&decoder, rx_len, dev->rx_pending,
+                                        &consumed);
+        dev->rx_pending_len = 0;
+        sensirion_shdlc_rx_keep(dev, &dev->rx_pending[consumed],
+                                (uint16_t)(rx_len - consumed));
+    }
+
+    while (ret == SENSIRION_SHDLC_RX_INCOMPLETE) {
+        if (decoder.state == SHDLC_RX_STATE_DATA &&
+            (uint16_t)(rxh->data_len - decoder.pos) >= sizeof(rx_chunk)) {
+            /* receive long data into the data buffer and un-stuff in place */
+            rx_buf = &data[decoder.pos];
+            rx_len = (uint16_t)(rxh->data_len - decoder.pos);
         } else {
-            unstuff_next = sensirion_shdlc_check_unstuff(rx_frame[i]);
-            if (!unstuff_next)
-                data[j++] = rx_frame[i];
+            /* as much as possible in one read: the chunk is no larger than
+             * rx_pending, which is empty here and takes the bytes beyond the
+             * end of the frame */
+            rx_buf = rx_chunk;
+            rx_len = sizeof(rx_chunk);
+        }
+
+        /* the time limit covers the whole frame, noise must not extend it.
+         * Once the frame started, the rest must follow without long gaps */
+        elapsed = sensirion_shdlc_time_usec(dev) - start;
+        wait = elapsed < timeout_us ? timeout_us - elapsed : 0;
+        if (sensirion_shdlc_rx_started(&decoder) && wait > RX_CHUNK_TIMEOUT_US)
+            wait = RX_CHUNK_TIMEOUT_US;
+        len = dev->uart->rx_timeout(dev->uart_ctx, rx_len, rx_buf, wait);
+        if (len < 0) {
+            ret = len;
+            break;
+        }
+
+        if (len == 0) {
+#ifdef SENSIRION_SHDLC_FIXED_RX_DELAY
+            ret = SENSIRION_SHDLC_RX_INCOMPLETE;
+            if (!sensirion_shdlc_rx_started(&decoder)) {
+                ret = SENSIRION_SHDLC_ERR_MISSING_START;
+            } else if (++delays > RX_MAX_CHUNK_DELAYS) {
+                ret = SENSIRION_SHDLC_ERR_MISSING_STOP;
+            } else {
+                sensirion_sleep_usec(RX_CHUNK_DELAY_US);
+            }
+            continue;
+#else
+            ret = sensirion_shdlc_rx_started(&decoder)
+                      ? SENSIRION_SHDLC_ERR_MISSING_STOP
+                      : SENSIRION_SHDLC_ERR_MISSING_START;
+            break;
+#endif
+        }
+
+        ret = sensirion_shdlc_rx_decode(&decoder, (uint16_t)len, rx_buf,
+                                        &consumed);
+        if (consumed < len)
+            sensirion_shdlc_rx_keep(dev, &rx_buf[consumed],
+                                    (uint16_t)(len - consumed));
+
+        if (ret == SENSIRION_SHDLC_RX_INCOMPLETE &&
+            sensirion_shdlc_time_usec(dev) - start >= timeout_us) {
+            ret = sensirion_shdlc_rx_started(&decoder)
+                      ? SENSIRION_SHDLC_ERR_MISSING_STOP
+                      : SENSIRION_SHDLC_ERR_MISSING_START;
         }
     }
 
-    if (unstuff_next)
-        return SENSIRION_SHDLC_ERR_ENCODING_ERROR;
+    dev->rx_resyncs += decoder.resyncs;
+    return ret;
+}
 
-    if (j < rxh->data_len)
-        return SENSIRION_SHDLC_ERR_ENCODING_ERROR;
+uint32_t sensirion_shdlc_rx_resync_count_dev(struct sensirion_shdlc_dev* dev) {
+    return dev->rx_resyncs;
+}
 
-    crc = rx_frame[i++];
-    if (sensirion_shdlc_check_unstuff(crc))
-        crc = sensirion_shdlc_unstuff_byte(rx_frame[i++]);
+struct sensirion_shdlc_dev* sensirion_shdlc_default_dev(void) {
+    return &default_dev;
+}
 
-    if (sensirion_shdlc_crc(rxh->addr + rxh->cmd + rxh->state, rxh->data_len,
-                            data) != crc)
-        return SENSIRION_SHDLC_ERR_CRC_MISMATCH;
+int16_t sensirion_shdlc_tx(uint8_t addr, uint8_t cmd, uint8_t data_len,
+                           const uint8_t* data) {
+    return sensirion_shdlc_tx_dev(&default_dev, addr, cmd, data_len, data);
+}
 
-    if (i >= len || rx_frame[i] != SHDLC_STOP)
-        return SENSIRION_SHDLC_ERR_MISSING_STOP;
+int16_t sensirion_shdlc_tx_raw(uint16_t frame_len, const uint8_t* frame) {
+    return sensirion_shdlc_tx_raw_dev(&default_dev, frame_len, frame);
+}
 
-    return 0;
+int16_t sensirion_shdlc_tx_rawv(uint8_t iovcnt,
+                                const struct sensirion_uart_iovec* iov) {
+    return sensirion_shdlc_tx_rawv_dev(&default_dev, iovcnt, iov);
+}
+
+int16_t sensirion_shdlc_rx(uint8_t max_data_len,
+                           struct sensirion_shdlc_rx_header* header,
+                           uint8_t* data) {
+    return sensirion_shdlc_rx_dev(&default_dev, max_data_len, header, data);
+}
+
+uint32_t sensirion_shdlc_rx_resync_count(void) {
+    return sensirion_shdlc_rx_resync_count_dev(&default_dev);
+}
+
+int16_t sensirion_shdlc_rx_timeout(uint8_t max_data_len,
+                                   struct sensirion_shdlc_rx_header* header,
+                                   uint8_t* data, uint32_t timeout_us) {
+    return sensirion_shdlc_rx_timeout_dev(&default_dev, max_data_len, header,
+                                          data, timeout_us);
+}
+
+int16_t sensirion_shdlc_xcv(uint8_t addr, uint8_t cmd, uint8_t tx_data_len,
+                            const uint8_t* tx_data, uint8_t max_rx_data_len,
+                            struct sensirion_shdlc_rx_header* rx_header,
+                            uint8_t* rx_data) {
+    return sensirion_shdlc_xcv_dev(&default_dev, addr, cmd, tx_data_len,
+                                   tx_data, max_rx_data_len, rx_header,
+                                   rx_data);
+}
+
+int16_t sensirion_shdlc_xcv_timeout(uint8_t addr, uint8_t cmd,
+                                    uint8_t tx_data_len, const uint8_t* tx_data,
+                                    uint8_t max_rx_data_len,
+                                    struct sensirion_shdlc_rx_header* rx_header,
+                                    uint8_t* rx_data, uint32_t rx_timeout_us) {
+    return sensirion_shdlc_xcv_timeout_dev(&default_dev, addr, cmd,
+                                           tx_data_len, tx_data,
+                                           max_rx_data_len, rx_header, rx_data,
+                                           rx_timeout_us);
+}
+
+int16_t sensirion_shdlc_xcv_batch(uint8_t addr, uint8_t cmd_count,
+                                  struct sensirion_shdlc_batch_cmd* cmds,
+                                  uint32_t rx_timeout_us) {
+    return sensirion_shdlc_xcv_batch_dev(&default_dev, addr, cmd_count, cmds,
+                                         rx_timeout_us);
+}
+
+int16_t sensirion_shdlc_xcv_raw(uint16_t tx_frame_len, const uint8_t* tx_frame,
+                                uint8_t max_rx_data_len,
+                                struct sensirion_shdlc_rx_header* rx_header,
+                                uint8_t* rx_data, uint32_t rx_timeout_us) {
+    return sensirion_shdlc_xcv_raw_dev(&default_dev, tx_frame_len, tx_frame,
+                                       max_rx_data_len, rx_header, rx_data,
+                                       rx_timeout_us);
+}
+
+int16_t sensirion_shdlc_xcv_rawv(uint8_t tx_iovcnt,
+                                 const struct sensirion_uart_iovec* tx_iov,
+                                 uint8_t max_rx_data_len,
+                                 struct sensirion_shdlc_rx_header* rx_header,
+                                 uint8_t* rx_data, uint32_t rx_timeout_us) {
+    return sensirion_shdlc_xcv_rawv_dev(&default_dev, tx_iovcnt, tx_iov,
+                                        max_rx_data_len, rx_header, rx_data,
+                                        rx_timeout_us);
 }
@@ -37,6 +37,7 @@ extern "C" {
 #endif
 
 #include "sensirion_arch_config.h"
+#include "sensirion_uart.h"
 
 #define SENSIRION_SHDLC_ERR_NO_DATA -1
 #define SENSIRION_SHDLC_ERR_MISSING_START -2
@@ -101,6 +102,20 @@ uint32_t sensirion_bytes_to_uint32_t(const uint8_t* bytes);
  */
 float sensirion_bytes_to_float(const uint8_t* bytes);
 
+/**
+ * sensirion_be32_array_to_float() - Convert an array of bytes to floats
+ *
+ * Same as calling sensirion_bytes_to_float() for each group of four bytes,
+ * but converts several values at once. The conversion may be done in place,
+ * i.e. values may point to the same memory as bytes.
+ *
+ * @param count  Number of values to convert
+ * @param bytes  An array of count * 4 bytes (MSB first)
+ * @param values An array of count floats
+ */
+void sensirion_be32_array_to_float(uint16_t count, const uint8_t* bytes,
+                                   float* values);
+
 /**
  * sensirion_uint32_t_to_bytes() - Convert an uint32_t to an array of bytes
  *
@@ -156,6 +171,25 @@ void sensirion_int16_t_to_bytes(const int16_t value, uint8_t* bytes);
  */
 void sensirion_float_to_bytes(const float value, uint8_t* bytes);
 
+/** start/stop + (4 header + 255 data) * 2 because of byte stuffing */
+#define SENSIRION_SHDLC_MAX_TX_FRAME_SIZE (2 + (4 + 255) * 2)
+
+/**
+ * Default time to wait for the start of a response frame.
+ *
+ * By default, responses are received as soon as they arrive, using
+ * sensirion_uart_rx_timeout() to wait for data. Define
+ * SENSIRION_SHDLC_FIXED_RX_DELAY for UART HALs which cannot wait for input:
+ * sensirion_shdlc_xcv() then sleeps a fixed 20ms between transmitting and
+ * receiving and sensirion_uart_rx() is used instead.
+ */
+#define SENSIRION_SHDLC_RX_TIMEOUT_US 50000
+
+/**
+ * Return value of sensirion_shdlc_rx_decode() while the frame is not complete
+ */
+#define SENSIRION_SHDLC_RX_INCOMPLETE 1
+
 struct sensirion_shdlc_rx_header {
     uint8_t addr;
     uint8_t cmd;
@@ -163,6 +197,148 @@ struct sensirion_shdlc_rx_header {
     uint8_t data_len;
 };
 
+/**
+ * State of the incremental SHDLC frame decoder. Treat as opaque, use
+ * sensirion_shdlc_rx_decoder_init() to initialize it.
+ */
+struct sensirion_shdlc_rx_decoder {
+    struct sensirion_shdlc_rx_header* header;
+    uint8_t* data;
+    uint8_t max_data_len;
+    uint8_t state;
+    uint8_t pos;
+    uint8_t unstuff_next;
+    uint8_t crc;
+    /* number of times the decoder skipped noise or restarted the frame */
+    uint16_t resyncs;
+};
+
+/**
+ * One command of a pipelined transaction, see sensirion_shdlc_xcv_batch()
+ *
+ * @cmd:                command parameter
+ * @tx_data_len:        data length to send
+ * @tx_data:            data to send
+ * @max_rx_data_len:    max data length to receive
+ * @rx_data:            Memory where the received data is stored
+ * @rx_header:          Set to the header of the response
+ * @status:             Set to 0 when the response was received,
+ *                      SENSIRION_SHDLC_ERR_NO_DATA if there was none,
+ *                      SENSIRION_SHDLC_ERR_FRAME_TOO_LONG if the response did
+ *                      not fit into rx_data
+ */
+struct sensirion_shdlc_batch_cmd {
+    uint8_t cmd;
+    uint8_t tx_data_len;
+    const uint8_t* tx_data;
+    uint8_t max_rx_data_len;
+    uint8_t* rx_data;
+    struct sensirion_shdlc_rx_header rx_header;
+    int16_t status;
+};
+
+/** Bytes received beyond the end of a frame which are kept for the next one */
+#define SENSIRION_SHDLC_RX_PENDING_SIZE 64
+
+/**
+ * An SHDLC connection for the reentrant API, i.e. the functions with a _dev
+ * suffix. The functions without suffix use a default device on top of the
+ * global sensirion_uart_*() functions.
+ *
+ * Treat as opaque, use sensirion_shdlc_dev_init() to initialize it. A device
+ * must not be used by several threads at the same time, but different devices
+ * may be used concurrently.
+ */
+struct sensirion_shdlc_dev {
+    const struct sensirion_uart_ops* uart;
+    void* uart_ctx;
+    uint32_t rx_resyncs;
+    uint8_t rx_pending_len;
+    uint8_t rx_pending[SENSIRION_SHDLC_RX_PENDING_SIZE];
+};
+
+/** UART operations on the global sensirion_uart_*() functions, ctx is unused */
+extern const struct sensirion_uart_ops sensirion_uart_default_ops;
+
+/**
+ * sensirion_shdlc_dev_init() - initialize an SHDLC device
+ *
+ * @dev:        Device to initialize
+ * @uart:       UART operations of the port the device is connected to
+ * @uart_ctx:   Passed to the UART operations
+ */
+void sensirion_shdlc_dev_init(struct sensirion_shdlc_dev* dev,
+                              const struct sensirion_uart_ops* uart,
+                              void* uart_ctx);
+
+/**
+ * sensirion_shdlc_default_dev() - the device of the functions without suffix
+ *
+ * Drivers built on SHDLC use it for their own functions without _dev suffix,
+ * so that they share the bytes kept for the next frame and the resync count
+ * with the sensirion_shdlc_*() functions.
+ *
+ * Return:      The default device on the global sensirion_uart_*() functions
+ */
+struct sensirion_shdlc_dev* sensirion_shdlc_default_dev(void);
+
+/**
+ * sensirion_shdlc_rx_decoder_init() - prepare a decoder for a new frame
+ *
+ * @decoder:        Decoder state to initialize
+ * @max_data_len:   max data length to receive
+ * @header:         Memory where the SHDLC header is stored
+ * @data:           Memory where received data is stored
+ */
+void sensirion_shdlc_rx_decoder_init(struct sensirion_shdlc_rx_decoder* decoder,
+                                     uint8_t max_data_len,
+                                     struct sensirion_shdlc_rx_header* header,
+                                     uint8_t* data);
+
+/**
+ * sensirion_shdlc_rx_decode() - feed received bytes into the frame decoder
+ *
+ * Bytes may be passed in chunks of any size as they arrive from the UART,
+ * byte un-stuffing and the checksum are carried across chunks. Decoding stops
+ * right after the stop byte, i.e. bytes following the frame are not consumed.
+ *
+ * The decoder resynchronizes to the stream: bytes before the first frame
+ * delimiter are skipped and an unexpected delimiter within a frame restarts
+ * decoding there, see decoder->resyncs.
+ *
+ * While receiving data, the bytes may also be placed in the data buffer at the
+ * position of the next data byte (&decoder->data[decoder->pos]) to be decoded
+ * in place.
+ *
+ * Note that the header and data must be discarded on failure
+ *
+ * @decoder:    Decoder state
+ * @len:        Number of received bytes
+ * @bytes:      Received bytes
+ * @consumed:   Set to the number of bytes consumed by the decoder, also on
+ *              failure
+ * Return:      0 when a complete frame was decoded,
+ *              SENSIRION_SHDLC_RX_INCOMPLETE if more bytes are needed,
+ *              an error code otherwise
+ */
+int16_t sensirion_shdlc_rx_decode(struct sensirion_shdlc_rx_decoder* decoder,
+                                  uint16_t len, const uint8_t* bytes,
+                                  uint16_t* consumed);
+
+/**
+ * sensirion_shdlc_encode() - encode an SHDLC frame without transmitting it
+ *
+ * @addr:       SHDLC recipient address
+ * @cmd:        command parameter
+ * @data_len:   data length to send
+ * @data:       data to send
+ * @frame:      Memory of at least SENSIRION_SHDLC_MAX_TX_FRAME_SIZE bytes
+ *              where the byte-stuffed frame is stored
+ * Return:      Length of the encoded frame
+ */
+uint16_t sensirion_shdlc_encode(uint8_t addr, uint8_t cmd, uint8_t data_len,
+                                const uint8_t* data, uint8_t* frame);
+
 /**
  * sensirion_shdlc_tx() - transmit an SHDLC frame
  *
@@ -175,9 +351,65 @@ struct sensirion_shdlc_rx_header {
 int16_t sensirion_shdlc_tx(uint8_t addr, uint8_t cmd, uint8_t data_len,
                            const uint8_t* data);
 
+/**
+ * sensirion_shdlc_tx_dev() - reentrant variant
+ *
+ * Same as sensirion_shdlc_tx() on the given device.
+ */
+int16_t sensirion_shdlc_tx_dev(struct sensirion_shdlc_dev* dev, uint8_t addr,
+                               uint8_t cmd, uint8_t data_len,
+                               const uint8_t* data);
+
+/**
+ * sensirion_shdlc_tx_raw() - transmit an already encoded SHDLC frame
+ *
+ * Transmits the frame as is, e.g. a frame precomputed at compile time or
+ * encoded with sensirion_shdlc_encode() before.
+ *
+ * @frame_len:  length of the encoded frame
+ * @frame:      byte-stuffed frame including start and stop bytes
+ * Return:      0 on success, an error code otherwise
+ */
+int16_t sensirion_shdlc_tx_raw(uint16_t frame_len, const uint8_t* frame);
+
+/**
+ * sensirion_shdlc_tx_raw_dev() - reentrant variant
+ *
+ * Same as sensirion_shdlc_tx_raw() on the given device.
+ */
+int16_t sensirion_shdlc_tx_raw_dev(struct sensirion_shdlc_dev* dev,
+                                   uint16_t frame_len, const uint8_t* frame);
+
+/**
+ * sensirion_shdlc_tx_rawv() - transmit encoded data from several buffers
+ *
+ * Same as sensirion_shdlc_tx_raw() but the bytes are gathered from several
+ * buffers with a single sensirion_uart_txv() call, e.g. to prefix a frame with
+ * a wake-up byte.
+ *
+ * @iovcnt:     number of buffers, at most SENSIRION_UART_MAX_IOV
+ * @iov:        buffers to send
+ * Return:      0 on success, an error code otherwise
+ */
+int16_t sensirion_shdlc_tx_rawv(uint8_t iovcnt,
+                                const struct sensirion_uart_iovec* iov);
+
+/**
+ * sensirion_shdlc_tx_rawv_dev() - reentrant variant
+ *
+ * Same as sensirion_shdlc_tx_rawv() on the given device.
+ */
+int16_t sensirion_shdlc_tx_rawv_dev(struct sensirion_shdlc_dev* dev,
+                                    uint8_t iovcnt,
+                                    const struct sensirion_uart_iovec* iov);
+
 /**
  * sensirion_shdlc_rx() - receive an SHDLC frame
  *
+ * Noise in front of the frame is skipped and a frame which was received only
+ * partially is dropped in favour of the frame following it. Bytes received
+ * beyond the end of the frame are kept for the next call.
+ *
  * Note that the header and data must be discarded on failure
  *
  * @data_len:   max data length to receive
@@ -190,6 +422,62 @@ int16_t sensirion_shdlc_rx(uint8_t max_data_len,
                            struct sensirion_shdlc_rx_header* header,
                            uint8_t* data);
 
+/**
+ * sensirion_shdlc_rx_dev() - reentrant variant
+ *
+ * Same as sensirion_shdlc_rx() on the given device.
+ */
+int16_t sensirion_shdlc_rx_dev(struct sensirion_shdlc_dev* dev,
+                               uint8_t max_data_len,
+                               struct sensirion_shdlc_rx_header* header,
+                               uint8_t* data);
+
+/**
+ * sensirion_shdlc_rx_resync_count() - number of resyncs of the receiver
+ *
+ * Counts how often sensirion_shdlc_rx() had to skip noise or restart a frame
+ * received only partially, e.g. after a sensor reset or a glitch on the line.
+ *
+ * Return:      Number of resyncs since startup
+ */
+uint32_t sensirion_shdlc_rx_resync_count(void);
+
+/**
+ * sensirion_shdlc_rx_resync_count_dev() - reentrant variant
+ *
+ * Same as sensirion_shdlc_rx_resync_count() on the given device.
+ */
+uint32_t sensirion_shdlc_rx_resync_count_dev(struct sensirion_shdlc_dev* dev);
+
+/**
+ * sensirion_shdlc_rx_timeout() - receive an SHDLC frame within a deadline
+ *
+ * Same as sensirion_shdlc_rx() but with a custom time limit for the start of
+ * the frame to arrive.
+ *
+ * Note that the header and data must be discarded on failure
+ *
+ * @data_len:   max data length to receive
+ * @header:     Memory where the SHDLC header containing the sender address,
+ *              command, sensor state and data length is stored
+ * @data:       Memory where received data is stored
+ * @timeout_us: Time to wait for the frame to start in microseconds
+ * Return:      0 on success, an error code otherwise
+ */
+int16_t sensirion_shdlc_rx_timeout(uint8_t max_data_len,
+                                   struct sensirion_shdlc_rx_header* header,
+                                   uint8_t* data, uint32_t timeout_us);
+
+/**
+ * sensirion_shdlc_rx_timeout_dev() - reentrant variant
+ *
+ * Same as sensirion_shdlc_rx_timeout() on the given device.
+ */
+int16_t sensirion_shdlc_rx_timeout_dev(struct sensirion_shdlc_dev* dev,
+                                       uint8_t max_data_len,
+                                       struct sensirion_shdlc_rx_header* header,
+                                       uint8_t* data, uint32_t timeout_us);
+
 /**
  * sensirion_shdlc_xcv() - transceive (transmit then receive) an SHDLC frame
  *
@@ -209,6 +497,154 @@ int16_t sensirion_shdlc_xcv(uint8_t addr, uint8_t cmd, uint8_t tx_data_len,
                             struct sensirion_shdlc_rx_header* rx_header,
                             uint8_t* rx_data);
 
+/**
+ * sensirion_shdlc_xcv_dev() - reentrant variant
+ *
+ * Same as sensirion_shdlc_xcv() on the given device.
+ */
+int16_t sensirion_shdlc_xcv_dev(struct sensirion_shdlc_dev* dev, uint8_t addr,
+                                uint8_t cmd, uint8_t tx_data_len,
+                                const uint8_t* tx_data, uint8_t max_rx_data_len,
+                                struct sensirion_shdlc_rx_header* rx_header,
+                                uint8_t* rx_data);
+
+/**
+ * sensirion_shdlc_xcv_timeout() - transceive an SHDLC frame within a deadline
+ *
+ * Same as sensirion_shdlc_xcv() but with a custom time limit for the response
+ * to arrive, e.g. for commands with a long execution time.
+ *
+ * Note that rx_header and rx_data must be discarded on failure
+ *
+ * @addr:           recipient address
+ * @cmd:            parameter
+ * @tx_data_len:    data length to send
+ * @tx_data:        data to send
+ * @rx_header:      Memory where the SHDLC header containing the sender address,
+ *                  command, sensor state and data length is stored
+ * @rx_data:        Memory where the received data is stored
+ * @rx_timeout_us:  Time to wait for the response in microseconds
+ * Return:          0 on success, an error code otherwise
+ */
+int16_t sensirion_shdlc_xcv_timeout(uint8_t addr, uint8_t cmd,
+                                    uint8_t tx_data_len, const uint8_t* tx_data,
+                                    uint8_t max_rx_data_len,
+                                    struct sensirion_shdlc_rx_header* rx_header,
+                                    uint8_t* rx_data, uint32_t rx_timeout_us);
+
+/**
+ * sensirion_shdlc_xcv_timeout_dev() - reentrant variant
+ *
+ * Same as sensirion_shdlc_xcv_timeout() on the given device.
+ */
+int16_t sensirion_shdlc_xcv_timeout_dev(
+    struct sensirion_shdlc_dev* dev, uint8_t addr, uint8_t cmd,
+    uint8_t tx_data_len, const uint8_t* tx_data, uint8_t max_rx_data_len,
+    struct sensirion_shdlc_rx_header* rx_header, uint8_t* rx_data,
+    uint32_t rx_timeout_us);
+
+/**
+ * sensirion_shdlc_xcv_batch() - transceive several SHDLC frames pipelined
+ *
+ * All commands are transmitted back to back before any response is received,
+ * so the whole batch takes about one round trip. Responses are matched to the
+ * commands by the command byte of their header, in whichever order they
+ * arrive. Responses to commands which are not part of the batch are skipped.
+ * Responses which fail to decode don't end the batch: the remaining responses
+ * are received until all commands are answered or the timeout expired, so that
+ * none of them is mistaken for the response of a later transaction.
+ *
+ * Note that the rx_header and rx_data of commands whose status is not 0 must
+ * be discarded.
+ *
+ * @addr:           recipient address
+ * @cmd_count:      number of commands
+ * @cmds:           commands to transceive, see
+ *                  struct sensirion_shdlc_batch_cmd
+ * @rx_timeout_us:  Time to wait for each response in microseconds
+ * Return:          0 when all responses were received, the first error code
+ *                  otherwise
+ */
+int16_t sensirion_shdlc_xcv_batch(uint8_t addr, uint8_t cmd_count,
+                                  struct sensirion_shdlc_batch_cmd* cmds,
+                                  uint32_t rx_timeout_us);
+
+/**
+ * sensirion_shdlc_xcv_batch_dev() - reentrant variant
+ *
+ * Same as sensirion_shdlc_xcv_batch() on the given device.
+ */
+int16_t sensirion_shdlc_xcv_batch_dev(struct sensirion_shdlc_dev* dev,
+                                      uint8_t addr, uint8_t cmd_count,
+                                      struct sensirion_shdlc_batch_cmd* cmds,
+                                      uint32_t rx_timeout_us);
+
+/**
+ * sensirion_shdlc_xcv_raw() - transceive an already encoded SHDLC frame
+ *
+ * Same as sensirion_shdlc_xcv_timeout() but transmits an encoded frame as is,
+ * see sensirion_shdlc_tx_raw().
+ *
+ * Note that rx_header and rx_data must be discarded on failure
+ *
+ * @tx_frame_len:   length of the encoded frame
+ * @tx_frame:       byte-stuffed frame including start and stop bytes
+ * @rx_header:      Memory where the SHDLC header containing the sender address,
+ *                  command, sensor state and data length is stored
+ * @rx_data:        Memory where the received data is stored
+ * @rx_timeout_us:  Time to wait for the response in microseconds
+ * Return:          0 on success, an error code otherwise
+ */
+int16_t sensirion_shdlc_xcv_raw(uint16_t tx_frame_len, const uint8_t* tx_frame,
+                                uint8_t max_rx_data_len,
+                                struct sensirion_shdlc_rx_header* rx_header,
+                                uint8_t* rx_data, uint32_t rx_timeout_us);
+
+/**
+ * sensirion_shdlc_xcv_raw_dev() - reentrant variant
+ *
+ * Same as sensirion_shdlc_xcv_raw() on the given device.
+ */
+int16_t sensirion_shdlc_xcv_raw_dev(struct sensirion_shdlc_dev* dev,
+                                    uint16_t tx_frame_len,
+                                    const uint8_t* tx_frame,
+                                    uint8_t max_rx_data_len,
+                                    struct sensirion_shdlc_rx_header* rx_header,
+                                    uint8_t* rx_data, uint32_t rx_timeout_us);
+
+/**
+ * sensirion_shdlc_xcv_rawv() - transceive encoded data from several buffers
+ *
+ * Same as sensirion_shdlc_xcv_raw() but transmits with
+ * sensirion_shdlc_tx_rawv().
+ *
+ * Note that rx_header and rx_data must be discarded on failure
+ *
+ * @tx_iovcnt:      number of buffers, at most SENSIRION_UART_MAX_IOV
+ * @tx_iov:         buffers to send
+ * @rx_header:      Memory where the SHDLC header containing the sender address,
+ *                  command, sensor state and data length is stored
+ * @rx_data:        Memory where the received data is stored
+ * @rx_timeout_us:  Time to wait for the response in microseconds
+ * Return:          0 on success, an error code otherwise
+ */
+int16_t sensirion_shdlc_xcv_rawv(uint8_t tx_iovcnt,
+                                 const struct sensirion_uart_iovec* tx_iov,
+                                 uint8_t max_rx_data_len,
+                                 struct sensirion_shdlc_rx_header* rx_header,
+                                 uint8_t* rx_data, uint32_t rx_timeout_us);
+
+/**
+ * sensirion_shdlc_xcv_rawv_dev() - reentrant variant
+ *
+ * Same as sensirion_shdlc_xcv_rawv() on the given device.
+ */
+int16_t sensirion_shdlc_xcv_rawv_dev(
+    struct sensirion_shdlc_dev* dev, uint8_t tx_iovcnt,
+    const struct sensirion_uart_iovec* tx_iov, uint8_t max_rx_data_len,
+    struct sensirion_shdlc_rx_header* rx_header, uint8_t* rx_data,
+    uint32_t rx_timeout_us);
+
 #ifdef __cplusplus
 }
 #endif
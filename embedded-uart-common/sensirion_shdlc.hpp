@@ -0,0 +1,394 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Header-only SHDLC for C++14 and later, with the transport as a template
+ * parameter instead of the UART HAL linked in.
+ *
+ * The framing is the one of sensirion_shdlc.c written as inline code, so the
+ * compiler sees the whole transaction from the driver down to the read() of
+ * the transport. A Transport is any move-only class with
+ *
+ *     int16_t tx(uint16_t len, const uint8_t* data);
+ *     int16_t rx(uint16_t max_len, uint8_t* data, uint32_t timeout_us);
+ *
+ * returning the number of bytes transmitted or received (0 if nothing arrived
+ * within the timeout) or a negative error, see sensirion_uart_transport.hpp.
+ * Results and error codes are the same as the ones of sensirion_shdlc.h.
+ */
+
+#ifndef SENSIRION_SHDLC_HPP
+#define SENSIRION_SHDLC_HPP
+
+#include <string.h>
+#include <utility>
+
+#include "sensirion_shdlc.h"
+#include "sensirion_shdlc_frame.hpp"
+
+namespace sensirion {
+namespace shdlc {
+
+using RxHeader = sensirion_shdlc_rx_header;
+
+constexpr uint8_t start_stop = 0x7e;
+constexpr uint8_t escape = 0x7d;
+
+/** start/stop + 4 header + crc */
+constexpr uint16_t min_rx_frame_size = 7;
+
+/** Max. gap between two chunks of the same frame */
+constexpr uint32_t rx_chunk_timeout_us = 50000;
+
+inline uint8_t* stuff_byte(uint8_t c, uint8_t* out) {
+    if (needs_stuffing(c)) {
+        *out++ = escape;
+        c = static_cast<uint8_t>(c ^ 0x20);
+    }
+    *out++ = c;
+    return out;
+}
+
+/**
+ * encode() - encode a frame into a buffer, same as sensirion_shdlc_encode()
+ *
+ * @frame:  Output buffer of at least max_frame_size(data_len) bytes
+ * Return:  Length of the frame
+ */
+inline uint16_t encode(uint8_t addr, uint8_t cmd, uint8_t data_len,
+                       const uint8_t* data, uint8_t* frame) {
+    uint8_t* out = frame;
+    uint8_t sum = static_cast<uint8_t>(addr + cmd + data_len);
+
+    *out++ = start_stop;
+    out = stuff_byte(addr, out);
+    out = stuff_byte(cmd, out);
+    out = stuff_byte(data_len, out);
+    for (uint8_t i = 0; i < data_len; ++i) {
+        sum = static_cast<uint8_t>(sum + data[i]);
+        out = stuff_byte(data[i], out);
+    }
+    out = stuff_byte(static_cast<uint8_t>(~sum), out);
+    *out++ = start_stop;
+    return static_cast<uint16_t>(out - frame);
+}
+
+/**
+ * Incremental frame decoder, same as sensirion_shdlc_rx_decode(): noise in
+ * front of a frame is skipped and a frame delimiter within a frame restarts
+ * decoding.
+ */
+class Decoder {
+  public:
+    Decoder(uint8_t max_data_len, RxHeader& header, uint8_t* data)
+        : header_(reinterpret_cast<uint8_t*>(&header)), data_(data),
+          max_data_len_(max_data_len) {
+    }
+
+    /**
+     * Decode bytes until the frame is complete
+     *
+     * Return:  SENSIRION_SHDLC_RX_INCOMPLETE if more bytes are needed, 0 once
+     *          the frame was received or an error code. consumed is set to
+     *          the number of bytes used.
+     */
+    int16_t decode(uint16_t len, const uint8_t* bytes, uint16_t& consumed) {
+        int16_t ret = SENSIRION_SHDLC_RX_INCOMPLETE;
+        uint16_t i = 0;
+        uint8_t c;
+
+        while (i < len && ret == SENSIRION_SHDLC_RX_INCOMPLETE) {
+            if (state_ == State::data && !unstuff_next_)
+                i = static_cast<uint16_t>(i + copy_data(len - i, &bytes[i]));
+            if (i == len)
+                break;
+            c = bytes[i++];
+
+            if (state_ == State::start || state_ == State::skip) {
+                if (c == start_stop) {
+                    state_ = State::header;
+                } else if (state_ == State::start) {
+                    state_ = State::skip;
+                    ++resyncs_;
+                }
+                continue;
+            }
+
+            if (state_ == State::stop) {
+                ret = c == start_stop ? 0 : SENSIRION_SHDLC_ERR_MISSING_STOP;
+                state_ = State::done;
+                continue;
+            }
+
+            if (c == start_stop) {
+                /* a repeated delimiter before the header is skipped,
+                 * otherwise a new frame starts */
+                if (started())
+                    restart();
+                continue;
+            }
+
+            if (unstuff_next_) {
+                c = static_cast<uint8_t>(c ^ 0x20);
+                unstuff_next_ = false;
+            } else if (c == escape) {
+                unstuff_next_ = true;
+                continue;
+            }
+
+            sum_ = static_cast<uint8_t>(sum_ + c);
+            switch (state_) {
+                case State::header:
+                    header_[pos_++] = c;
+                    if (pos_ == sizeof(RxHeader)) {
+                        pos_ = 0;
+                        if (data_len() > max_data_len_)
+                            ret = SENSIRION_SHDLC_ERR_FRAME_TOO_LONG;
+                        state_ = data_len() ? State::data : State::crc;
+                    }
+                    break;
+                case State::data:
+                    data_[pos_++] = c;
+                    if (pos_ == data_len())
+                        state_ = State::crc;
+                    break;
+                case State::crc:
+                    /* the checksum is the inverted sum of all bytes */
+                    if (sum_ != 0xff)
+                        ret = SENSIRION_SHDLC_ERR_CRC_MISMATCH;
+                    state_ = State::stop;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        consumed = i;
+        return ret;
+    }
+
+    /** Whether any byte of the frame other than the start byte arrived */
+    bool started() const {
+        switch (state_) {
+            case State::start:
+            case State::skip:
+                return false;
+            case State::header:
+                return pos_ || unstuff_next_;
+            default:
+                return true;
+        }
+    }
+
+    uint32_t resyncs() const {
+        return resyncs_;
+    }
+
+  private:
+    enum class State : uint8_t { start, skip, header, data, crc, stop, done };
+
+    /* copy the run of data bytes which need no un-stuffing as a whole */
+    uint16_t copy_data(uint16_t len, const uint8_t* bytes) {
+        uint16_t run = 0;
+        uint8_t sum = sum_;
+
+        if (len > data_len() - pos_)
+            len = static_cast<uint16_t>(data_len() - pos_);
+        while (run < len && bytes[run] != escape && bytes[run] != start_stop)
+            ++run;
+        memcpy(&data_[pos_], bytes, run);
+        for (uint16_t i = 0; i < run; ++i)
+            sum = static_cast<uint8_t>(sum + bytes[i]);
+        sum_ = sum;
+        pos_ = static_cast<uint8_t>(pos_ + run);
+        if (pos_ == data_len())
+            state_ = State::crc;
+        return run;
+    }
+
+    uint8_t data_len() const {
+        return header_[sizeof(RxHeader) - 1];
+    }
+
+    void restart() {
+        state_ = State::header;
+        pos_ = 0;
+        unstuff_next_ = false;
+        sum_ = 0;
+        ++resyncs_;
+    }
+
+    uint8_t* header_;
+    uint8_t* data_;
+    uint8_t max_data_len_;
+    State state_ = State::start;
+    uint8_t pos_ = 0;
+    bool unstuff_next_ = false;
+    uint8_t sum_ = 0;
+    uint32_t resyncs_ = 0;
+};
+
+/**
+ * An SHDLC device talking through a Transport it owns, the counterpart of
+ * struct sensirion_shdlc_dev. Move-only if the transport is.
+ */
+template <typename Transport> class Device {
+  public:
+    /* the arguments are passed on to the constructor of the transport */
+    template <typename... Args>
+    explicit Device(Args&&... args) : transport_(std::forward<Args>(args)...) {
+    }
+
+    Transport& transport() {
+        return transport_;
+    }
+
+    const Transport& transport() const {
+        return transport_;
+    }
+
+    /** Transmit an encoded frame, 0 on success */
+    int16_t tx_raw(uint16_t len, const uint8_t* frame) {
+        int16_t ret = transport_.tx(len, frame);
+
+        if (ret < 0)
+            return ret;
+        return ret == len ? 0 : SENSIRION_SHDLC_ERR_TX_INCOMPLETE;
+    }
+
+    /** Encode and transmit a frame, 0 on success */
+    int16_t tx(uint8_t addr, uint8_t cmd, uint8_t data_len,
+               const uint8_t* data) {
+        uint8_t frame[SENSIRION_SHDLC_MAX_TX_FRAME_SIZE];
+
+        return tx_raw(encode(addr, cmd, data_len, data, frame), frame);
+    }
+
+    /**
+     * Receive a frame, same as sensirion_shdlc_rx_timeout(): bytes received
+     * beyond the end of the frame are kept for the next one.
+     */
+    int16_t rx(uint8_t max_data_len, RxHeader& header, uint8_t* data,
+               uint32_t timeout_us = SENSIRION_SHDLC_RX_TIMEOUT_US) {
+        Decoder decoder(max_data_len, header, data);
+        uint8_t chunk[SENSIRION_SHDLC_RX_PENDING_SIZE];
+        uint16_t consumed = 0;
+        int16_t ret = SENSIRION_SHDLC_RX_INCOMPLETE;
+        int16_t len;
+
+        if (pending_len_) {
+            /* bytes left over from the last frame come first */
+            len = pending_len_;
+            memcpy(chunk, pending_, pending_len_);
+            pending_len_ = 0;
+            ret = decoder.decode(static_cast<uint16_t>(len), chunk, consumed);
+            keep(&chunk[consumed], static_cast<uint16_t>(len - consumed));
+        }
+
+        while (ret == SENSIRION_SHDLC_RX_INCOMPLETE) {
+            len = transport_.rx(sizeof(chunk), chunk,
+                                decoder.started() ? rx_chunk_timeout_us
+                                                  : timeout_us);
+            if (len < 0) {
+                ret = len;
+                break;
+            }
+            if (len == 0) {
+                ret = decoder.started() ? SENSIRION_SHDLC_ERR_MISSING_STOP
+                                        : SENSIRION_SHDLC_ERR_MISSING_START;
+                break;
+            }
+            ret = decoder.decode(static_cast<uint16_t>(len), chunk, consumed);
+            keep(&chunk[consumed], static_cast<uint16_t>(len - consumed));
+        }
+
+        resyncs_ += decoder.resyncs();
+        return ret;
+    }
+
+    /** Transmit an encoded frame and receive the response */
+    int16_t xcv_raw(uint16_t len, const uint8_t* frame, uint8_t max_data_len,
+                    RxHeader& header, uint8_t* data,
+                    uint32_t timeout_us = SENSIRION_SHDLC_RX_TIMEOUT_US) {
+        int16_t ret = tx_raw(len, frame);
+
+        if (ret)
+            return ret;
+        return rx(max_data_len, header, data, timeout_us);
+    }
+
+    /** Transmit a frame of sensirion_shdlc_frame.hpp and receive the
+     * response */
+    template <size_t N>
+    int16_t xcv(const Frame<N>& frame, uint8_t max_data_len, RxHeader& header,
+                uint8_t* data,
+                uint32_t timeout_us = SENSIRION_SHDLC_RX_TIMEOUT_US) {
+        return xcv_raw(frame.len, frame.bytes, max_data_len, header, data,
+                       timeout_us);
+    }
+
+    /** Encode and transmit a command and receive the response */
+    int16_t xcv(uint8_t addr, uint8_t cmd, uint8_t tx_data_len,
+                const uint8_t* tx_data, uint8_t max_data_len, RxHeader& header,
+                uint8_t* data,
+                uint32_t timeout_us = SENSIRION_SHDLC_RX_TIMEOUT_US) {
+        int16_t ret = tx(addr, cmd, tx_data_len, tx_data);
+
+        if (ret)
+            return ret;
+        return rx(max_data_len, header, data, timeout_us);
+    }
+
+    /** Number of frames which were resynchronized, see
+     * sensirion_shdlc_rx_resync_count() */
+    uint32_t resync_count() const {
+        return resyncs_;
+    }
+
+  private:
+    /* bytes which don't fit are dropped, the next frame resyncs then */
+    void keep(const uint8_t* bytes, uint16_t len) {
+        if (len > sizeof(pending_) - pending_len_)
+            len = static_cast<uint16_t>(sizeof(pending_) - pending_len_);
+        memcpy(&pending_[pending_len_], bytes, len);
+        pending_len_ = static_cast<uint8_t>(pending_len_ + len);
+    }
+
+    Transport transport_;
+    uint8_t pending_[SENSIRION_SHDLC_RX_PENDING_SIZE];
+    uint8_t pending_len_ = 0;
+    uint32_t resyncs_ = 0;
+};
+
+}  // namespace shdlc
+}  // namespace sensirion
+
+#endif /* SENSIRION_SHDLC_HPP */
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Compile-time SHDLC frame encoding for C++14 and later.
+ *
+ * Frames of commands with constant data are built by the compiler, e.g.
+ *
+ *     constexpr auto frame = sensirion::shdlc::frame(0x00, 0x03);
+ *     sensirion_shdlc_tx_raw(frame.len, frame.bytes);
+ *
+ * The encoding is the same as sensirion_shdlc_encode().
+ */
+
+#ifndef SENSIRION_SHDLC_FRAME_HPP
+#define SENSIRION_SHDLC_FRAME_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace sensirion {
+namespace shdlc {
+
+/** start/stop + (3 header + data + crc) * 2 because of byte stuffing */
+constexpr size_t max_frame_size(size_t data_len) {
+    return 2 + (3 + data_len + 1) * 2;
+}
+
+template <size_t MaxLen> struct Frame {
+    uint8_t cmd;
+    uint16_t len;
+    uint8_t bytes[MaxLen];
+};
+
+constexpr bool needs_stuffing(uint8_t c) {
+    return c == 0x11 || c == 0x13 || c == 0x7d || c == 0x7e;
+}
+
+/**
+ * frame() - encode an SHDLC frame at compile time
+ *
+ * @addr:   SHDLC recipient address
+ * @cmd:    command parameter
+ * @data:   data bytes to send
+ * Return:  The byte-stuffed frame including start and stop bytes
+ */
+template <typename... Data>
+constexpr Frame<max_frame_size(sizeof...(Data))> frame(uint8_t addr,
+                                                        uint8_t cmd,
+                                                        Data... data) {
+    const uint8_t raw[] = {addr, cmd, static_cast<uint8_t>(sizeof...(Data)),
+                           static_cast<uint8_t>(data)...};
+    Frame<max_frame_size(sizeof...(Data))> f{};
+    uint8_t sum = 0;
+    uint8_t c = 0;
+
+    f.cmd = cmd;
+    f.bytes[f.len++] = 0x7e;
+    for (size_t i = 0; i <= sizeof(raw); ++i) {
+        c = i < sizeof(raw) ? raw[i] : static_cast<uint8_t>(~sum);
+        sum = static_cast<uint8_t>(sum + c);
+        if (needs_stuffing(c)) {
+            f.bytes[f.len++] = 0x7d;
+            c = static_cast<uint8_t>(c ^ 0x20);
+        }
+        f.bytes[f.len++] = c;
+    }
+    f.bytes[f.len++] = 0x7e;
+    return f;
+}
+
+}  // namespace shdlc
+}  // namespace sensirion
+
+#endif /* SENSIRION_SHDLC_FRAME_HPP */
@@ -70,6 +70,30 @@ int16_t sensirion_uart_close();
  */
 int16_t sensirion_uart_tx(uint16_t data_len, const uint8_t* data);
 
+/** Max. number of buffers passed to sensirion_uart_txv() at once */
+#define SENSIRION_UART_MAX_IOV 16
+
+struct sensirion_uart_iovec {
+    const uint8_t* data;
+    uint16_t len;
+};
+
+/**
+ * sensirion_uart_txv() - transmit data from several buffers over UART
+ *                        THE IMPLEMENTATION IS OPTIONAL WITH SENSIRION_WEAK
+ *
+ * Transmit the buffers in order, as if they were concatenated, ideally with a
+ * single system call. Implementations without scatter/gather support may
+ * transmit each buffer with sensirion_uart_tx(), which is what the default
+ * implementation does.
+ *
+ * @iovcnt:     number of buffers, at most SENSIRION_UART_MAX_IOV
+ * @iov:        buffers to send
+ * Return:      Number of bytes sent or a negative error code
+ */
+int16_t sensirion_uart_txv(uint8_t iovcnt,
+                           const struct sensirion_uart_iovec* iov);
+
 /**
  * sensirion_uart_rx() - receive data over UART
  *
@@ -79,6 +103,43 @@ int16_t sensirion_uart_tx(uint16_t data_len, const uint8_t* data);
  */
 int16_t sensirion_uart_rx(uint16_t max_data_len, uint8_t* data);
 
+/**
+ * sensirion_uart_rx_timeout() - receive data over UART, waiting for it
+ *                               NOT NEEDED WITH SENSIRION_SHDLC_FIXED_RX_DELAY
+ *                               THE IMPLEMENTATION IS OPTIONAL WITH
+ *                               SENSIRION_WEAK
+ *
+ * Block until at least one byte arrived or the timeout expired, whichever
+ * happens first, then receive the bytes available without waiting any further.
+ * Must never block longer than the timeout, e.g. when the sensor stopped
+ * responding. The default implementation polls sensirion_uart_rx() once per
+ * millisecond, which relies on sensirion_uart_rx() returning 0 when no data is
+ * available.
+ *
+ * @max_data_len: max number of bytes to receive
+ * @data:       Memory where received data is stored
+ * @timeout_us: max time to wait for the first byte in microseconds
+ * Return:      Number of bytes received, 0 on timeout or a negative error code
+ */
+int16_t sensirion_uart_rx_timeout(uint16_t max_data_len, uint8_t* data,
+                                  uint32_t timeout_us);
+
+/**
+ * sensirion_uart_wait_device() - wait for the device of the selected port
+ *                                MAY RETURN 0 AT ONCE ON SETUPS WITHOUT
+ *                                HOT-PLUGGED UARTS
+ *                                THE IMPLEMENTATION IS OPTIONAL WITH
+ *                                SENSIRION_WEAK
+ *
+ * Block until the UART device is present, e.g. after a USB serial adapter
+ * was plugged in, or the timeout expired. The default implementation returns 0
+ * at once.
+ *
+ * @timeout_us: max time to wait in microseconds
+ * Return:      0 when the device is present, a negative error code otherwise
+ */
+int16_t sensirion_uart_wait_device(uint32_t timeout_us);
+
 /**
  * Sleep for a given number of microseconds. The function should delay the
  * execution for at least the given time, but may also sleep longer.
@@ -89,6 +150,35 @@ int16_t sensirion_uart_rx(uint16_t max_data_len, uint8_t* data);
  */
 void sensirion_sleep_usec(uint32_t useconds);
 
+/**
+ * sensirion_time_usec() - read a monotonic clock
+ *                         NOT NEEDED WITH SENSIRION_SHDLC_FIXED_RX_DELAY
+ *                         THE IMPLEMENTATION IS OPTIONAL WITH SENSIRION_WEAK
+ *
+ * The clock may start at any value and wraps around. The time limits of SHDLC
+ * responses are measured with it. The default implementation returns 0: with a
+ * clock which stands still the time limit applies to each UART read instead of
+ * the whole response, so a noisy line may delay the response indefinitely.
+ *
+ * Return:      Time in microseconds
+ */
+uint32_t sensirion_time_usec(void);
+
+/**
+ * UART operations of one port for the reentrant driver API, see
+ * struct sensirion_shdlc_dev. Each function behaves like its global
+ * counterpart, e.g. tx like sensirion_uart_tx(), on the port described by ctx.
+ */
+struct sensirion_uart_ops {
+    int16_t (*tx)(void* ctx, uint16_t data_len, const uint8_t* data);
+    int16_t (*txv)(void* ctx, uint8_t iovcnt,
+                   const struct sensirion_uart_iovec* iov);
+    int16_t (*rx_timeout)(void* ctx, uint16_t max_data_len, uint8_t* data,
+                          uint32_t timeout_us);
+    /* NULL if the port has no clock */
+    uint32_t (*time_usec)(void* ctx);
+};
+
 #ifdef __cplusplus
 }
 #endif
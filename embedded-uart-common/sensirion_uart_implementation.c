@@ -82,6 +82,34 @@ int16_t sensirion_uart_tx(uint16_t data_len, const uint8_t* data) {
     return 0;
 }
 
+/**
+ * sensirion_uart_txv() - transmit data from several buffers over UART
+ *
+ * Transmit the buffers in order, as if they were concatenated, ideally with a
+ * single system call. Implementations without scatter/gather support may
+ * transmit each buffer with sensirion_uart_tx().
+ *
+ * @iovcnt:     number of buffers, at most SENSIRION_UART_MAX_IOV
+ * @iov:        buffers to send
+ * Return:      Number of bytes sent or a negative error code
+ */
+int16_t sensirion_uart_txv(uint8_t iovcnt,
+                           const struct sensirion_uart_iovec* iov) {
+    int16_t sent = 0;
+    int16_t ret;
+    uint8_t i;
+
+    for (i = 0; i < iovcnt; ++i) {
+        ret = sensirion_uart_tx(iov[i].len, iov[i].data);
+        if (ret < 0)
+            return ret;
+        sent += ret;
+        if (ret != iov[i].len)
+            break;
+    }
+    return sent;
+}
+
 /**
  * sensirion_uart_rx() - receive data over UART
  *
@@ -94,6 +122,42 @@ int16_t sensirion_uart_rx(uint16_t max_data_len, uint8_t* data) {
     return 0;
 }
 
+/**
+ * sensirion_uart_rx_timeout() - receive data over UART, waiting for it
+ *                               NOT NEEDED WITH SENSIRION_SHDLC_FIXED_RX_DELAY
+ *
+ * Block until at least one byte arrived or the timeout expired, whichever
+ * happens first, then receive the bytes available without waiting any further.
+ * Must never block longer than the timeout, e.g. when the sensor stopped
+ * responding.
+ *
+ * @max_data_len: max number of bytes to receive
+ * @data:       Memory where received data is stored
+ * @timeout_us: max time to wait for the first byte in microseconds
+ * Return:      Number of bytes received, 0 on timeout or a negative error code
+ */
+int16_t sensirion_uart_rx_timeout(uint16_t max_data_len, uint8_t* data,
+                                  uint32_t timeout_us) {
+    // TODO: implement
+    return 0;
+}
+
+/**
+ * sensirion_uart_wait_device() - wait for the device of the selected port
+ *                                MAY RETURN 0 AT ONCE ON SETUPS WITHOUT
+ *                                HOT-PLUGGED UARTS
+ *
+ * Block until the UART device is present, e.g. after a USB serial adapter
+ * was plugged in, or the timeout expired.
+ *
+ * @timeout_us: max time to wait in microseconds
+ * Return:      0 when the device is present, a negative error code otherwise
+ */
+int16_t sensirion_uart_wait_device(uint32_t timeout_us) {
+    // TODO: implement if the UART can be unplugged
+    return 0;
+}
+
 /**
  * Sleep for a given number of microseconds. The function should delay the
  * execution for at least the given time, but may also sleep longer.
@@ -105,3 +169,17 @@ int16_t sensirion_uart_rx(uint16_t max_data_len, uint8_t* data) {
 void sensirion_sleep_usec(uint32_t useconds) {
     // TODO: implement
 }
+/**
+ * sensirion_time_usec() - read a monotonic clock
+ *                         NOT NEEDED WITH SENSIRION_SHDLC_FIXED_RX_DELAY
+ *
+ * The clock may start at any value and wraps around. The time limits of SHDLC
+ * responses are measured with it.
+ *
+ * Return:      Time in microseconds
+ */
+uint32_t sensirion_time_usec(void) {
+    // TODO: implement
+    return 0;
+}
+
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * In-memory transport of the header-only SHDLC driver in sensirion_shdlc.hpp
+ * for tests and benchmarks: responses are queued up front, transmitted
+ * frames are recorded.
+ */
+
+#ifndef SENSIRION_UART_MOCK_HPP
+#define SENSIRION_UART_MOCK_HPP
+
+#include <string.h>
+
+#include "sensirion_shdlc.hpp"
+
+namespace sensirion {
+namespace uart {
+
+/**
+ * Transport serving queued bytes to rx(). With repeat() set, every tx()
+ * restarts the queue so a benchmark can run the same transaction over and
+ * over without allocating or copying.
+ */
+template <uint16_t Size = 256> class Mock {
+  public:
+    Mock() = default;
+    Mock(Mock&&) = default;
+    Mock& operator=(Mock&&) = default;
+    Mock(const Mock&) = delete;
+    Mock& operator=(const Mock&) = delete;
+
+    /** Queue raw bytes to be received, false if they don't fit */
+    bool respond(uint16_t len, const uint8_t* bytes) {
+        if (len > Size - rx_len_)
+            return false;
+        memcpy(&rx_[rx_len_], bytes, len);
+        rx_len_ = static_cast<uint16_t>(rx_len_ + len);
+        return true;
+    }
+
+    /** Queue a response frame with the given device state */
+    bool respond_frame(uint8_t addr, uint8_t cmd, uint8_t state,
+                       uint8_t data_len, const uint8_t* data) {
+        uint8_t frame[SENSIRION_SHDLC_MAX_TX_FRAME_SIZE + 2];
+        uint8_t* out = frame;
+        uint8_t sum = static_cast<uint8_t>(addr + cmd + state + data_len);
+
+        *out++ = shdlc::start_stop;
+        out = shdlc::stuff_byte(addr, out);
+        out = shdlc::stuff_byte(cmd, out);
+        out = shdlc::stuff_byte(state, out);
+        out = shdlc::stuff_byte(data_len, out);
+        for (uint8_t i = 0; i < data_len; ++i) {
+            sum = static_cast<uint8_t>(sum + data[i]);
+            out = shdlc::stuff_byte(data[i], out);
+        }
+        out = shdlc::stuff_byte(static_cast<uint8_t>(~sum), out);
+        *out++ = shdlc::start_stop;
+        return respond(static_cast<uint16_t>(out - frame), frame);
+    }
+
+    /* serve the queued bytes again after each transmission */
+    void repeat(bool enable) {
+        repeat_ = enable;
+    }
+
+    /* drop everything queued */
+    void clear() {
+        rx_len_ = 0;
+        rx_pos_ = 0;
+    }
+
+    int16_t tx(uint16_t len, const uint8_t* data) {
+        if (len > sizeof(tx_))
+            len = sizeof(tx_);
+        memcpy(tx_, data, len);
+        tx_len_ = len;
+        ++tx_count_;
+        if (repeat_)
+            rx_pos_ = 0;
+        return static_cast<int16_t>(len);
+    }
+
+    /* the queued bytes, 0 once they are used up */
+    int16_t rx(uint16_t max_len, uint8_t* data, uint32_t timeout_us) {
+        uint16_t len = static_cast<uint16_t>(rx_len_ - rx_pos_);
+
+        (void)timeout_us;
+        if (len > max_len)
+            len = max_len;
+        memcpy(data, &rx_[rx_pos_], len);
+        rx_pos_ = static_cast<uint16_t>(rx_pos_ + len);
+        return static_cast<int16_t>(len);
+    }
+
+    /* the last transmitted frame */
+    const uint8_t* tx_data() const {
+        return tx_;
+    }
+
+    uint16_t tx_len() const {
+        return tx_len_;
+    }
+
+    uint32_t tx_count() const {
+        return tx_count_;
+    }
+
+  private:
+    uint8_t rx_[Size];
+    uint16_t rx_len_ = 0;
+    uint16_t rx_pos_ = 0;
+    uint8_t tx_[SENSIRION_SHDLC_MAX_TX_FRAME_SIZE + 1];
+    uint16_t tx_len_ = 0;
+    uint32_t tx_count_ = 0;
+    bool repeat_ = false;
+};
+
+}  // namespace uart
+}  // namespace sensirion
+
+#endif /* SENSIRION_UART_MOCK_HPP */
@@ -32,15 +32,14 @@
 #include "sps30.h"
 #include "sensirion_shdlc.h"
 #include "sensirion_uart.h"
+#include "sps30_frames.h"
 #include "sps_git_version.h"
 
+#include <string.h>
+
 #define SPS30_ADDR 0x00
 #define SPS30_CMD_START_MEASUREMENT 0x00
 #define SPS30_CMD_STOP_MEASUREMENT 0x01
-#define SPS30_SUBCMD_MEASUREMENT_START \
-    { 0x01, 0x03 } 
-    /* 0x03: Big-endian IEEE754 float values 
-       0x05: Big-endian unsigned 16-bit integer values */ 
 #define SPS30_CMD_READ_MEASUREMENT 0x03
 #define SPS30_CMD_SLEEP 0x10
 #define SPS30_CMD_WAKE_UP 0x11
@@ -49,121 +48,259 @@
 #define SPS30_SUBCMD_READ_FAN_CLEAN_INTV 0x00
 #define SPS30_CMD_START_FAN_CLEANING 0x56
 #define SPS30_CMD_DEV_INFO 0xd0
-#define SPS30_CMD_DEV_INFO_SUBCMD_GET_SERIAL \
-    { 0x03 }
+#define SPS30_SUBCMD_GET_SERIAL 0x03
 #define SPS30_CMD_READ_VERSION 0xd1
 #define SPS30_CMD_RESET 0xd3
 #define SPS30_ERR_STATE(state) (SPS30_ERR_STATE_MASK | (state))
 
+/* sps30_read_measurement() decodes into struct sps30_measurement as an array */
+typedef char sps30_measurement_is_float_array
+    [sizeof(struct sps30_measurement) == 10 * sizeof(float) ? 1 : -1];
+
+/**
+ * Response timeouts per command: the max. execution time from the datasheet
+ * plus transfer time and latency of USB-serial adapters.
+ */
+#define SPS30_DEFAULT_TIMEOUT_US 50000
+
+static const struct sps30_cmd_timeout {
+    uint8_t cmd;
+    uint32_t timeout_us;
+} sps30_cmd_timeouts[] = {
+    {SPS30_CMD_START_MEASUREMENT, 50000},
+    {SPS30_CMD_STOP_MEASUREMENT, 50000},
+    {SPS30_CMD_READ_MEASUREMENT, 50000},
+    {SPS30_CMD_SLEEP, 50000},
+    {SPS30_CMD_WAKE_UP, 100000},
+    {SPS30_CMD_FAN_CLEAN_INTV, 50000},
+    {SPS30_CMD_START_FAN_CLEANING, 50000},
+    {SPS30_CMD_DEV_INFO, 50000},
+    {SPS30_CMD_READ_VERSION, 50000},
+    {SPS30_CMD_RESET, 100000},
+};
+
+uint32_t sps30_cmd_timeout_us(uint8_t cmd) {
+    uint8_t i;
+
+    for (i = 0; i < sizeof(sps30_cmd_timeouts) / sizeof(sps30_cmd_timeouts[0]);
+         ++i) {
+        if (sps30_cmd_timeouts[i].cmd == cmd)
+            return sps30_cmd_timeouts[i].timeout_us;
+    }
+    return SPS30_DEFAULT_TIMEOUT_US;
+}
+
+/* used by the functions without _dev suffix, see sps30_shdlc() */
+#define SPS30_DEFAULT_DEV ((struct sps30_dev*)NULL)
+
+static struct sensirion_shdlc_dev* sps30_shdlc(struct sps30_dev* dev) {
+    /* the default sensor shares the SHDLC default device with the
+     * sensirion_shdlc_*() functions, and with it the pending bytes and the
+     * resync count */
+    if (dev == SPS30_DEFAULT_DEV)
+        return sensirion_shdlc_default_dev();
+    return &dev->shdlc;
+}
+
+static int16_t sps30_xcv(struct sps30_dev* dev, uint8_t cmd,
+                         uint8_t tx_data_len, const uint8_t* tx_data,
+                         uint8_t max_rx_data_len,
+                         struct sensirion_shdlc_rx_header* rx_header,
+                         uint8_t* rx_data) {
+    return sensirion_shdlc_xcv_timeout_dev(
+        sps30_shdlc(dev), SPS30_ADDR, cmd, tx_data_len, tx_data,
+        max_rx_data_len, rx_header, rx_data, sps30_cmd_timeout_us(cmd));
+}
+
+/* transceive a precomputed frame, see sps30_frames.h */
+static int16_t sps30_xcv_frame(struct sps30_dev* dev, enum sps30_frame_id id,
+                               uint8_t max_rx_data_len,
+                               struct sensirion_shdlc_rx_header* rx_header,
+                               uint8_t* rx_data) {
+    const struct sps30_frame* frame = &sps30_frames[id];
+
+    return sensirion_shdlc_xcv_raw_dev(
+        sps30_shdlc(dev), frame->len, frame->bytes, max_rx_data_len, rx_header,
+        rx_data, sps30_cmd_timeout_us(frame->cmd));
+}
+
 const char* sps_get_driver_version(void) {
     return SPS_DRV_VERSION_STR;
 }
 
-int16_t sps30_probe(void) {
+void sps30_dev_init(struct sps30_dev* dev,
+                    const struct sensirion_uart_ops* uart, void* uart_ctx) {
+    sensirion_shdlc_dev_init(&dev->shdlc, uart, uart_ctx);
+}
+
+int16_t sps30_probe_dev(struct sps30_dev* dev) {
     char serial[SPS30_MAX_SERIAL_LEN];
     // Try to wake up, but ignore failure if it is not in sleep mode
-    (void)sps30_wake_up();
-    int16_t ret = sps30_get_serial(serial);
+    (void)sps30_wake_up_dev(dev);
+    int16_t ret = sps30_get_serial_dev(dev, serial);
 
     return ret;
 }
 
-int16_t sps30_get_serial(char* serial) {
+int16_t sps30_get_serial_dev(struct sps30_dev* dev, char* serial) {
     struct sensirion_shdlc_rx_header header;
-    uint8_t param_buf[] = SPS30_CMD_DEV_INFO_SUBCMD_GET_SERIAL;
+    uint8_t data[SPS30_MAX_SERIAL_LEN];
     int16_t ret;
 
-    ret = sensirion_shdlc_xcv(SPS30_ADDR, SPS30_CMD_DEV_INFO, sizeof(param_buf),
-                              param_buf, SPS30_MAX_SERIAL_LEN, &header,
-                              (uint8_t*)serial);
+    ret = sps30_xcv_frame(dev, SPS30_FRAME_GET_SERIAL, sizeof(data), &header,
+                          data);
     if (ret < 0)
         return ret;
 
-    if (header.state)
-        return SPS30_ERR_STATE(header.state);
+    return sps30_decode_serial(&header, data, serial);
+}
+
+int16_t sps30_decode_serial(const struct sensirion_shdlc_rx_header* header,
+                            const uint8_t* data, char* serial) {
+    uint8_t len = header->data_len < SPS30_MAX_SERIAL_LEN
+                      ? header->data_len
+                      : SPS30_MAX_SERIAL_LEN - 1;
+
+    memcpy(serial, data, len);
+    serial[len] = '\0';
+
+    if (header->state)
+        return SPS30_ERR_STATE(header->state);
 
     return 0;
 }
 
-int16_t sps30_start_measurement(void) {
+int16_t sps30_start_measurement_dev(struct sps30_dev* dev) {
+    return sps30_start_measurement_format_dev(dev,
+                                              SPS30_MEASUREMENT_FORMAT_FLOAT);
+}
+
+int16_t sps30_start_measurement_format_dev(struct sps30_dev* dev,
+                                           uint8_t format) {
     struct sensirion_shdlc_rx_header header;
-    uint8_t param_buf[] = SPS30_SUBCMD_MEASUREMENT_START;
 
-    return sensirion_shdlc_xcv(SPS30_ADDR, SPS30_CMD_START_MEASUREMENT,
-                               sizeof(param_buf), param_buf, 0, &header,
-                               (uint8_t*)NULL);
+    switch (format) {
+        case SPS30_MEASUREMENT_FORMAT_FLOAT:
+            return sps30_xcv_frame(dev, SPS30_FRAME_START_MEASUREMENT, 0,
+                                   &header, (uint8_t*)NULL);
+        case SPS30_MEASUREMENT_FORMAT_UINT16:
+            return sps30_xcv_frame(dev, SPS30_FRAME_START_MEASUREMENT_UINT16,
+                                   0, &header, (uint8_t*)NULL);
+        default:
+            return SPS30_ERR_INVALID_FORMAT;
+    }
 }
 
-int16_t sps30_stop_measurement(void) {
+int16_t sps30_stop_measurement_dev(struct sps30_dev* dev) {
     struct sensirion_shdlc_rx_header header;
 
-    return sensirion_shdlc_xcv(SPS30_ADDR, SPS30_CMD_STOP_MEASUREMENT, 0,
-                               (uint8_t*)NULL, 0, &header, (uint8_t*)NULL);
+    return sps30_xcv_frame(dev, SPS30_FRAME_STOP_MEASUREMENT, 0, &header,
+                           (uint8_t*)NULL);
 }
 
-int16_t sps30_read_measurement(struct sps30_measurement* measurement) {
+int16_t sps30_read_measurement_dev(struct sps30_dev* dev,
+                                   struct sps30_measurement* measurement) {
+    struct sensirion_shdlc_rx_header header;
+    int16_t error;
+    uint8_t data[SPS30_MEASUREMENT_LEN];
+
+    error = sps30_xcv_frame(dev, SPS30_FRAME_READ_MEASUREMENT, sizeof(data),
+                            &header, data);
+    if (error) {
+        return error;
+    }
+
+    return sps30_decode_measurement(&header, data, measurement);
+}
+
+int16_t sps30_decode_measurement(const struct sensirion_shdlc_rx_header* header,
+                                 const uint8_t* data,
+                                 struct sps30_measurement* measurement) {
+    if (header->data_len != SPS30_MEASUREMENT_LEN) {
+        return SPS30_ERR_NOT_ENOUGH_DATA;
+    }
+
+    /* the measurement consists of ten floats in the order they are sent */
+    sensirion_be32_array_to_float(10, data, &measurement->mc_1p0);
+
+    if (header->state) {
+        return SPS30_ERR_STATE(header->state);
+    }
+
+    return 0;
+}
+
+int16_t sps30_read_measurement_u16_dev(
+    struct sps30_dev* dev, struct sps30_measurement_u16* measurement) {
     struct sensirion_shdlc_rx_header header;
     int16_t error;
-    uint8_t data[10][4];
+    uint8_t data[SPS30_MEASUREMENT_U16_LEN];
 
-    error = sensirion_shdlc_xcv(SPS30_ADDR, SPS30_CMD_READ_MEASUREMENT, 0,
-                                (uint8_t*)NULL, sizeof(data), &header,
-                                (uint8_t*)data);
+    error = sps30_xcv_frame(dev, SPS30_FRAME_READ_MEASUREMENT, sizeof(data),
+                            &header, data);
     if (error) {
         return error;
     }
 
-    if (header.data_len != sizeof(data)) {
+    return sps30_decode_measurement_u16(&header, data, measurement);
+}
+
+int16_t
+sps30_decode_measurement_u16(const struct sensirion_shdlc_rx_header* header,
+                             const uint8_t* data,
+                             struct sps30_measurement_u16* measurement) {
+    if (header->data_len != SPS30_MEASUREMENT_U16_LEN) {
         return SPS30_ERR_NOT_ENOUGH_DATA;
     }
 
-    measurement->mc_1p0 = sensirion_bytes_to_float(data[0]);
-    measurement->mc_2p5 = sensirion_bytes_to_float(data[1]);
-    measurement->mc_4p0 = sensirion_bytes_to_float(data[2]);
-    measurement->mc_10p0 = sensirion_bytes_to_float(data[3]);
-    measurement->nc_0p5 = sensirion_bytes_to_float(data[4]);
-    measurement->nc_1p0 = sensirion_bytes_to_float(data[5]);
-    measurement->nc_2p5 = sensirion_bytes_to_float(data[6]);
-    measurement->nc_4p0 = sensirion_bytes_to_float(data[7]);
-    measurement->nc_10p0 = sensirion_bytes_to_float(data[8]);
-    measurement->typical_particle_size = sensirion_bytes_to_float(data[9]);
-
-    if (header.state) {
-        return SPS30_ERR_STATE(header.state);
+    measurement->mc_1p0 = sensirion_bytes_to_uint16_t(&data[0]);
+    measurement->mc_2p5 = sensirion_bytes_to_uint16_t(&data[2]);
+    measurement->mc_4p0 = sensirion_bytes_to_uint16_t(&data[4]);
+    measurement->mc_10p0 = sensirion_bytes_to_uint16_t(&data[6]);
+    measurement->nc_0p5 = sensirion_bytes_to_uint16_t(&data[8]);
+    measurement->nc_1p0 = sensirion_bytes_to_uint16_t(&data[10]);
+    measurement->nc_2p5 = sensirion_bytes_to_uint16_t(&data[12]);
+    measurement->nc_4p0 = sensirion_bytes_to_uint16_t(&data[14]);
+    measurement->nc_10p0 = sensirion_bytes_to_uint16_t(&data[16]);
+    measurement->typical_particle_size = sensirion_bytes_to_uint16_t(&data[18]);
+
+    if (header->state) {
+        return SPS30_ERR_STATE(header->state);
     }
 
     return 0;
 }
 
-int16_t sps30_sleep(void) {
+int16_t sps30_sleep_dev(struct sps30_dev* dev) {
     struct sensirion_shdlc_rx_header header;
 
-    return sensirion_shdlc_xcv(SPS30_ADDR, SPS30_CMD_SLEEP, 0, (uint8_t*)NULL,
-                               0, &header, (uint8_t*)NULL);
+    return sps30_xcv_frame(dev, SPS30_FRAME_SLEEP, 0, &header, (uint8_t*)NULL);
 }
 
-int16_t sps30_wake_up(void) {
+int16_t sps30_wake_up_dev(struct sps30_dev* dev) {
     struct sensirion_shdlc_rx_header header;
-    int16_t ret;
+    const struct sps30_frame* frame = &sps30_frames[SPS30_FRAME_WAKE_UP];
     const uint8_t data = 0xFF;
-
-    ret = sensirion_uart_tx(1, &data);
-    if (ret < 0) {
-        return ret;
-    }
-    return sensirion_shdlc_xcv(SPS30_ADDR, SPS30_CMD_WAKE_UP, 0, (uint8_t*)NULL,
-                               0, &header, (uint8_t*)NULL);
+    struct sensirion_uart_iovec iov[2];
+
+    /* the wake-up byte and command go out together */
+    iov[0].data = &data;
+    iov[0].len = 1;
+    iov[1].data = frame->bytes;
+    iov[1].len = frame->len;
+    return sensirion_shdlc_xcv_rawv_dev(sps30_shdlc(dev), 2, iov, 0, &header,
+                                        (uint8_t*)NULL,
+                                        sps30_cmd_timeout_us(frame->cmd));
 }
 
-int16_t sps30_get_fan_auto_cleaning_interval(uint32_t* interval_seconds) {
+int16_t sps30_get_fan_auto_cleaning_interval_dev(struct sps30_dev* dev,
+                                                 uint32_t* interval_seconds) {
     struct sensirion_shdlc_rx_header header;
-    uint8_t tx_data[] = {SPS30_SUBCMD_READ_FAN_CLEAN_INTV};
     int16_t ret;
     uint8_t data[4];
 
-    ret = sensirion_shdlc_xcv(
-        SPS30_ADDR, SPS30_CMD_FAN_CLEAN_INTV, sizeof(tx_data), tx_data,
-        sizeof(*interval_seconds), &header, (uint8_t*)data);
+    ret = sps30_xcv_frame(dev, SPS30_FRAME_GET_FAN_CLEAN_INTV,
+                          sizeof(*interval_seconds), &header, (uint8_t*)data);
     if (ret < 0)
         return ret;
 
@@ -175,23 +312,24 @@ int16_t sps30_get_fan_auto_cleaning_interval(uint32_t* interval_seconds) {
     return 0;
 }
 
-int16_t sps30_set_fan_auto_cleaning_interval(uint32_t interval_seconds) {
+int16_t sps30_set_fan_auto_cleaning_interval_dev(struct sps30_dev* dev,
+                                                 uint32_t interval_seconds) {
     struct sensirion_shdlc_rx_header header;
     uint8_t cleaning_command[SPS30_CMD_FAN_CLEAN_INTV_LEN];
 
     cleaning_command[0] = SPS30_SUBCMD_READ_FAN_CLEAN_INTV;
     sensirion_uint32_t_to_bytes(interval_seconds, &cleaning_command[1]);
 
-    return sensirion_shdlc_xcv(SPS30_ADDR, SPS30_CMD_FAN_CLEAN_INTV,
-                               sizeof(cleaning_command), cleaning_command, 0,
-                               &header, (uint8_t*)NULL);
+    return sps30_xcv(dev, SPS30_CMD_FAN_CLEAN_INTV, sizeof(cleaning_command),
+                     cleaning_command, 0, &header, (uint8_t*)NULL);
 }
 
-int16_t sps30_get_fan_auto_cleaning_interval_days(uint8_t* interval_days) {
+int16_t sps30_get_fan_auto_cleaning_interval_days_dev(struct sps30_dev* dev,
+                                                      uint8_t* interval_days) {
     int16_t ret;
     uint32_t interval_seconds;
 
-    ret = sps30_get_fan_auto_cleaning_interval(&interval_seconds);
+    ret = sps30_get_fan_auto_cleaning_interval_dev(dev, &interval_seconds);
     if (ret < 0)
         return ret;
 
@@ -199,36 +337,45 @@ int16_t sps30_get_fan_auto_cleaning_interval_days(uint8_t* interval_days) {
     return ret;
 }
 
-int16_t sps30_set_fan_auto_cleaning_interval_days(uint8_t interval_days) {
-    return sps30_set_fan_auto_cleaning_interval((uint32_t)interval_days * 24 *
-                                                60 * 60);
+int16_t sps30_set_fan_auto_cleaning_interval_days_dev(struct sps30_dev* dev,
+                                                      uint8_t interval_days) {
+    return sps30_set_fan_auto_cleaning_interval_dev(
+        dev, (uint32_t)interval_days * 24 * 60 * 60);
 }
 
-int16_t sps30_start_manual_fan_cleaning(void) {
+int16_t sps30_start_manual_fan_cleaning_dev(struct sps30_dev* dev) {
     struct sensirion_shdlc_rx_header header;
 
-    return sensirion_shdlc_xcv(SPS30_ADDR, SPS30_CMD_START_FAN_CLEANING, 0,
-                               (uint8_t*)NULL, 0, &header, (uint8_t*)NULL);
+    return sps30_xcv_frame(dev, SPS30_FRAME_START_FAN_CLEANING, 0, &header,
+                           (uint8_t*)NULL);
 }
 
-int16_t
-sps30_read_version(struct sps30_version_information* version_information) {
+int16_t sps30_read_version_dev(
+    struct sps30_dev* dev,
+    struct sps30_version_information* version_information) {
     struct sensirion_shdlc_rx_header header;
     int16_t error;
-    uint8_t data[7];
+    uint8_t data[SPS30_VERSION_LEN];
 
-    error = sensirion_shdlc_xcv(SPS30_ADDR, SPS30_CMD_READ_VERSION, 0,
-                                (uint8_t*)NULL, sizeof(data), &header, data);
+    error = sps30_xcv_frame(dev, SPS30_FRAME_READ_VERSION, sizeof(data),
+                            &header, data);
     if (error) {
         return error;
     }
 
-    if (header.data_len != sizeof(data)) {
+    return sps30_decode_version(&header, data, version_information);
+}
+
+int16_t
+sps30_decode_version(const struct sensirion_shdlc_rx_header* header,
+                     const uint8_t* data,
+                     struct sps30_version_information* version_information) {
+    if (header->data_len != SPS30_VERSION_LEN) {
         return SPS30_ERR_NOT_ENOUGH_DATA;
     }
 
-    if (header.state) {
-        return SPS30_ERR_STATE(header.state);
+    if (header->state) {
+        return SPS30_ERR_STATE(header->state);
     }
 
     version_information->firmware_major = data[0];
@@ -236,10 +383,119 @@ sps30_read_version(struct sps30_version_information* version_information) {
     version_information->hardware_revision = data[3];
     version_information->shdlc_major = data[5];
     version_information->shdlc_minor = data[6];
+    return 0;
+}
+
+int16_t sps30_read_device_info_dev(
+    struct sps30_dev* dev, char* serial,
+    struct sps30_version_information* version_information) {
+    const uint8_t subcmd = SPS30_SUBCMD_GET_SERIAL;
+    struct sensirion_shdlc_batch_cmd cmds[2];
+    uint8_t version[SPS30_VERSION_LEN];
+    int16_t ret;
+
+    cmds[0].cmd = SPS30_CMD_DEV_INFO;
+    cmds[0].tx_data_len = sizeof(subcmd);
+    cmds[0].tx_data = &subcmd;
+    cmds[0].max_rx_data_len = SPS30_MAX_SERIAL_LEN;
+    cmds[0].rx_data = (uint8_t*)serial;
+
+    cmds[1].cmd = SPS30_CMD_READ_VERSION;
+    cmds[1].tx_data_len = 0;
+    cmds[1].tx_data = (uint8_t*)NULL;
+    cmds[1].max_rx_data_len = sizeof(version);
+    cmds[1].rx_data = version;
+
+    ret = sensirion_shdlc_xcv_batch_dev(
+        sps30_shdlc(dev), SPS30_ADDR, 2, cmds,
+        sps30_cmd_timeout_us(SPS30_CMD_DEV_INFO));
+    if (ret < 0)
+        return ret;
+
+    if (cmds[0].rx_header.state)
+        return SPS30_ERR_STATE(cmds[0].rx_header.state);
+
+    return sps30_decode_version(&cmds[1].rx_header, version,
+                                version_information);
+}
+
+int16_t sps30_reset_dev(struct sps30_dev* dev) {
+    struct sensirion_shdlc_rx_header header;
+
+    return sps30_xcv_frame(dev, SPS30_FRAME_RESET, 0, &header, (uint8_t*)NULL);
+}
+
+int16_t sps30_probe(void) {
+    return sps30_probe_dev(SPS30_DEFAULT_DEV);
+}
+
+int16_t sps30_get_serial(char* serial) {
+    return sps30_get_serial_dev(SPS30_DEFAULT_DEV, serial);
+}
+
+int16_t sps30_start_measurement(void) {
+    return sps30_start_measurement_dev(SPS30_DEFAULT_DEV);
+}
+
+int16_t sps30_start_measurement_format(uint8_t format) {
+    return sps30_start_measurement_format_dev(SPS30_DEFAULT_DEV, format);
+}
+
+int16_t sps30_stop_measurement(void) {
+    return sps30_stop_measurement_dev(SPS30_DEFAULT_DEV);
+}
+
+int16_t sps30_read_measurement(struct sps30_measurement* measurement) {
+    return sps30_read_measurement_dev(SPS30_DEFAULT_DEV, measurement);
+}
+
+int16_t sps30_read_measurement_u16(struct sps30_measurement_u16* measurement) {
+    return sps30_read_measurement_u16_dev(SPS30_DEFAULT_DEV, measurement);
+}
+
+int16_t sps30_sleep(void) {
+    return sps30_sleep_dev(SPS30_DEFAULT_DEV);
+}
+
+int16_t sps30_wake_up(void) {
+    return sps30_wake_up_dev(SPS30_DEFAULT_DEV);
+}
+
+int16_t sps30_get_fan_auto_cleaning_interval(uint32_t* interval_seconds) {
+    return sps30_get_fan_auto_cleaning_interval_dev(SPS30_DEFAULT_DEV,
+                                                    interval_seconds);
+}
+
+int16_t sps30_set_fan_auto_cleaning_interval(uint32_t interval_seconds) {
+    return sps30_set_fan_auto_cleaning_interval_dev(SPS30_DEFAULT_DEV,
+                                                    interval_seconds);
+}
+
+int16_t sps30_get_fan_auto_cleaning_interval_days(uint8_t* interval_days) {
+    return sps30_get_fan_auto_cleaning_interval_days_dev(SPS30_DEFAULT_DEV,
+                                                         interval_days);
+}
+
+int16_t sps30_set_fan_auto_cleaning_interval_days(uint8_t interval_days) {
+    return sps30_set_fan_auto_cleaning_interval_days_dev(SPS30_DEFAULT_DEV,
+                                                         interval_days);
+}
+
+int16_t sps30_start_manual_fan_cleaning(void) {
+    return sps30_start_manual_fan_cleaning_dev(SPS30_DEFAULT_DEV);
+}
+
+int16_t
+sps30_read_version(struct sps30_version_information* version_information) {
+    return sps30_read_version_dev(SPS30_DEFAULT_DEV, version_information);
+}
 
-    return error;
+int16_t sps30_read_device_info(
+    char* serial, struct sps30_version_information* version_information) {
+    return sps30_read_device_info_dev(SPS30_DEFAULT_DEV, serial,
+                                      version_information);
 }
 
 int16_t sps30_reset(void) {
-    return sensirion_shdlc_tx(SPS30_ADDR, SPS30_CMD_RESET, 0, (uint8_t*)NULL);
+    return sps30_reset_dev(SPS30_DEFAULT_DEV);
 }
@@ -37,13 +37,26 @@ extern "C" {
 #endif
 
 #include "sensirion_arch_config.h"
+#include "sensirion_shdlc.h"
 
 #define SPS30_MAX_SERIAL_LEN 32
+/** Length of a measurement in float format */
+#define SPS30_MEASUREMENT_LEN 40
+/** Length of a measurement in integer format */
+#define SPS30_MEASUREMENT_U16_LEN 20
+/** Length of the version information */
+#define SPS30_VERSION_LEN 7
 #define SPS30_ERR_NOT_ENOUGH_DATA (-1)
+#define SPS30_ERR_INVALID_FORMAT (-2)
 #define SPS30_ERR_STATE_MASK (0x100)
 #define SPS30_IS_ERR_STATE(err_code) (((err_code) | 0xff) == 0x1ff)
 #define SPS30_GET_ERR_STATE(err_code) ((err_code)&0xff)
 
+/** Big-endian IEEE754 float values, see struct sps30_measurement */
+#define SPS30_MEASUREMENT_FORMAT_FLOAT 0x03
+/** Big-endian unsigned 16-bit values, see struct sps30_measurement_u16 */
+#define SPS30_MEASUREMENT_FORMAT_UINT16 0x05
+
 struct sps30_measurement {
     float mc_1p0;
     float mc_2p5;
@@ -57,6 +70,23 @@ struct sps30_measurement {
     float typical_particle_size;
 };
 
+/**
+ * Measurement in integer format: mass concentrations in ug/m^3, number
+ * concentrations in #/cm^3 and the typical particle size in nm
+ */
+struct sps30_measurement_u16 {
+    uint16_t mc_1p0;
+    uint16_t mc_2p5;
+    uint16_t mc_4p0;
+    uint16_t mc_10p0;
+    uint16_t nc_0p5;
+    uint16_t nc_1p0;
+    uint16_t nc_2p5;
+    uint16_t nc_4p0;
+    uint16_t nc_10p0;
+    uint16_t typical_particle_size;
+};
+
 struct sps30_version_information {
     uint8_t firmware_major;
     uint8_t firmware_minor;
@@ -65,12 +95,35 @@ struct sps30_version_information {
     uint8_t shdlc_minor;
 };
 
+/**
+ * An SPS30 for the reentrant API, i.e. the functions with a _dev suffix. The
+ * functions without suffix use a default sensor connected to the global
+ * sensirion_uart_*() functions.
+ *
+ * Treat as opaque, use sps30_dev_init() to initialize it. A sensor must not be
+ * used by several threads at the same time, but different sensors may be used
+ * concurrently.
+ */
+struct sps30_dev {
+    struct sensirion_shdlc_dev shdlc;
+};
+
 /**
  * sps_get_driver_version() - Return the driver version
  * Return:  Driver version string
  */
 const char* sps_get_driver_version(void);
 
+/**
+ * sps30_dev_init() - initialize an SPS30 for the reentrant API
+ *
+ * @dev:        Sensor to initialize
+ * @uart:       UART operations of the port the sensor is connected to
+ * @uart_ctx:   Passed to the UART operations
+ */
+void sps30_dev_init(struct sps30_dev* dev,
+                    const struct sensirion_uart_ops* uart, void* uart_ctx);
+
 /**
  * sps30_probe() - check if SPS sensor is available and initialize it
  *
@@ -78,6 +131,13 @@ const char* sps_get_driver_version(void);
  */
 int16_t sps30_probe(void);
 
+/**
+ * sps30_probe_dev() - reentrant variant
+ *
+ * Same as sps30_probe() on the given sensor.
+ */
+int16_t sps30_probe_dev(struct sps30_dev* dev);
+
 /**
  * sps30_get_serial() - retrieve the serial number
  *
@@ -89,6 +149,28 @@ int16_t sps30_probe(void);
  */
 int16_t sps30_get_serial(char* serial);
 
+/**
+ * sps30_get_serial_dev() - reentrant variant
+ *
+ * Same as sps30_get_serial() on the given sensor.
+ */
+int16_t sps30_get_serial_dev(struct sps30_dev* dev, char* serial);
+
+/**
+ * sps30_decode_serial() - decode a received serial number
+ *
+ * Decodes the response to a get serial command which was received by other
+ * means than sps30_get_serial().
+ *
+ * @header: Header of the response
+ * @data:   Data of the response, header->data_len bytes
+ * @serial: Set to the zero terminated serial number, SPS30_MAX_SERIAL_LEN
+ *          bytes
+ * Return:  Same as sps30_get_serial()
+ */
+int16_t sps30_decode_serial(const struct sensirion_shdlc_rx_header* header,
+                            const uint8_t* data, char* serial);
+
 /**
  * sps30_start_measurement() - start measuring
  *
@@ -99,6 +181,36 @@ int16_t sps30_get_serial(char* serial);
  */
 int16_t sps30_start_measurement(void);
 
+/**
+ * sps30_start_measurement_dev() - reentrant variant
+ *
+ * Same as sps30_start_measurement() on the given sensor.
+ */
+int16_t sps30_start_measurement_dev(struct sps30_dev* dev);
+
+/**
+ * sps30_start_measurement_format() - start measuring in the given format
+ *
+ * Same as sps30_start_measurement() but measurements are sent in the given
+ * output format. Read them with the matching function, i.e.
+ * sps30_read_measurement() for SPS30_MEASUREMENT_FORMAT_FLOAT and
+ * sps30_read_measurement_u16() for SPS30_MEASUREMENT_FORMAT_UINT16.
+ *
+ * Note: The integer format is only available since firmware version 2.0.
+ *
+ * @format: SPS30_MEASUREMENT_FORMAT_FLOAT or SPS30_MEASUREMENT_FORMAT_UINT16
+ * Return:  0 on success, an error code otherwise
+ */
+int16_t sps30_start_measurement_format(uint8_t format);
+
+/**
+ * sps30_start_measurement_format_dev() - reentrant variant
+ *
+ * Same as sps30_start_measurement_format() on the given sensor.
+ */
+int16_t sps30_start_measurement_format_dev(struct sps30_dev* dev,
+                                           uint8_t format);
+
 /**
  * sps30_stop_measurement() - stop measuring
  *
@@ -106,6 +218,13 @@ int16_t sps30_start_measurement(void);
  */
 int16_t sps30_stop_measurement(void);
 
+/**
+ * sps30_stop_measurement_dev() - reentrant variant
+ *
+ * Same as sps30_stop_measurement() on the given sensor.
+ */
+int16_t sps30_stop_measurement_dev(struct sps30_dev* dev);
+
 /**
  * sps30_read_measurement() - read a measurement
  *
@@ -115,6 +234,75 @@ int16_t sps30_stop_measurement(void);
  */
 int16_t sps30_read_measurement(struct sps30_measurement* measurement);
 
+/**
+ * sps30_read_measurement_dev() - reentrant variant
+ *
+ * Same as sps30_read_measurement() on the given sensor.
+ */
+int16_t sps30_read_measurement_dev(struct sps30_dev* dev,
+                                   struct sps30_measurement* measurement);
+
+/**
+ * sps30_cmd_timeout_us() - time to wait for the response to a command
+ *
+ * For transactions run by other means than the functions of this driver,
+ * e.g. the frames of sps30_frames.h sent through an event loop.
+ *
+ * @cmd:    SHDLC command, e.g. sps30_frames[SPS30_FRAME_RESET].cmd
+ * Return:  The max. response time in microseconds
+ */
+uint32_t sps30_cmd_timeout_us(uint8_t cmd);
+
+/**
+ * sps30_decode_measurement() - decode a received measurement
+ *
+ * Decodes the response to a read measurement command in float format which
+ * was received by other means than sps30_read_measurement(), e.g. with
+ * sps30_frames[SPS30_FRAME_READ_MEASUREMENT] sent through an event loop.
+ *
+ * @header:         Header of the response
+ * @data:           Data of the response, SPS30_MEASUREMENT_LEN bytes
+ * @measurement:    Set to the decoded measurement
+ * Return:          Same as sps30_read_measurement()
+ */
+int16_t sps30_decode_measurement(const struct sensirion_shdlc_rx_header* header,
+                                 const uint8_t* data,
+                                 struct sps30_measurement* measurement);
+
+/**
+ * sps30_read_measurement_u16() - read a measurement in integer format
+ *
+ * Read the last measurement. The measurement must have been started with
+ * SPS30_MEASUREMENT_FORMAT_UINT16, see sps30_start_measurement_format().
+ *
+ * Return:  0 on success, an error code otherwise
+ */
+int16_t sps30_read_measurement_u16(struct sps30_measurement_u16* measurement);
+
+/**
+ * sps30_read_measurement_u16_dev() - reentrant variant
+ *
+ * Same as sps30_read_measurement_u16() on the given sensor.
+ */
+int16_t sps30_read_measurement_u16_dev(
+    struct sps30_dev* dev, struct sps30_measurement_u16* measurement);
+
+/**
+ * sps30_decode_measurement_u16() - decode a received measurement
+ *
+ * Same as sps30_decode_measurement() for the integer format, see
+ * sps30_read_measurement_u16().
+ *
+ * @header:         Header of the response
+ * @data:           Data of the response, SPS30_MEASUREMENT_U16_LEN bytes
+ * @measurement:    Set to the decoded measurement
+ * Return:          Same as sps30_read_measurement_u16()
+ */
+int16_t
+sps30_decode_measurement_u16(const struct sensirion_shdlc_rx_header* header,
+                             const uint8_t* data,
+                             struct sps30_measurement_u16* measurement);
+
 /**
  * sps30_sleep() - Enter sleep mode with minimum power consumption.
  *
@@ -125,6 +313,13 @@ int16_t sps30_read_measurement(struct sps30_measurement* measurement);
  */
 int16_t sps30_sleep(void);
 
+/**
+ * sps30_sleep_dev() - reentrant variant
+ *
+ * Same as sps30_sleep() on the given sensor.
+ */
+int16_t sps30_sleep_dev(struct sps30_dev* dev);
+
 /**
  * sps30_wake_up() - Wake up from sleep mode and enter idle state.
  *
@@ -135,6 +330,13 @@ int16_t sps30_sleep(void);
  */
 int16_t sps30_wake_up(void);
 
+/**
+ * sps30_wake_up_dev() - reentrant variant
+ *
+ * Same as sps30_wake_up() on the given sensor.
+ */
+int16_t sps30_wake_up_dev(struct sps30_dev* dev);
+
 /**
  * sps30_get_fan_auto_cleaning_interval() - read the current auto-cleaning
  * interval
@@ -147,6 +349,14 @@ int16_t sps30_wake_up(void);
  */
 int16_t sps30_get_fan_auto_cleaning_interval(uint32_t* interval_seconds);
 
+/**
+ * sps30_get_fan_auto_cleaning_interval_dev() - reentrant variant
+ *
+ * Same as sps30_get_fan_auto_cleaning_interval() on the given sensor.
+ */
+int16_t sps30_get_fan_auto_cleaning_interval_dev(struct sps30_dev* dev,
+                                                 uint32_t* interval_seconds);
+
 /**
  * sps30_set_fan_auto_cleaning_interval() - set the current auto-cleaning
  * interval
@@ -156,6 +366,14 @@ int16_t sps30_get_fan_auto_cleaning_interval(uint32_t* interval_seconds);
  */
 int16_t sps30_set_fan_auto_cleaning_interval(uint32_t interval_seconds);
 
+/**
+ * sps30_set_fan_auto_cleaning_interval_dev() - reentrant variant
+ *
+ * Same as sps30_set_fan_auto_cleaning_interval() on the given sensor.
+ */
+int16_t sps30_set_fan_auto_cleaning_interval_dev(struct sps30_dev* dev,
+                                                 uint32_t interval_seconds);
+
 /**
  * sps30_get_fan_auto_cleaning_interval_days() - convenience function to read
  * the current auto-cleaning interval in days
@@ -172,6 +390,14 @@ int16_t sps30_set_fan_auto_cleaning_interval(uint32_t interval_seconds);
  */
 int16_t sps30_get_fan_auto_cleaning_interval_days(uint8_t* interval_days);
 
+/**
+ * sps30_get_fan_auto_cleaning_interval_days_dev() - reentrant variant
+ *
+ * Same as sps30_get_fan_auto_cleaning_interval_days() on the given sensor.
+ */
+int16_t sps30_get_fan_auto_cleaning_interval_days_dev(struct sps30_dev* dev,
+                                                      uint8_t* interval_days);
+
 /**
  * sps30_set_fan_auto_cleaning_interval_days() - convenience function to set the
  * current auto-cleaning interval in days
@@ -181,6 +407,14 @@ int16_t sps30_get_fan_auto_cleaning_interval_days(uint8_t* interval_days);
  */
 int16_t sps30_set_fan_auto_cleaning_interval_days(uint8_t interval_days);
 
+/**
+ * sps30_set_fan_auto_cleaning_interval_days_dev() - reentrant variant
+ *
+ * Same as sps30_set_fan_auto_cleaning_interval_days() on the given sensor.
+ */
+int16_t sps30_set_fan_auto_cleaning_interval_days_dev(struct sps30_dev* dev,
+                                                      uint8_t interval_days);
+
 /**
  * sps30_start_manual_fan_cleaning() - Immediately trigger the fan cleaning
  *
@@ -192,6 +426,13 @@ int16_t sps30_set_fan_auto_cleaning_interval_days(uint8_t interval_days);
  */
 int16_t sps30_start_manual_fan_cleaning(void);
 
+/**
+ * sps30_start_manual_fan_cleaning_dev() - reentrant variant
+ *
+ * Same as sps30_start_manual_fan_cleaning() on the given sensor.
+ */
+int16_t sps30_start_manual_fan_cleaning_dev(struct sps30_dev* dev);
+
 /**
  * sps30_read_version() - Read version information.
  *
@@ -200,6 +441,58 @@ int16_t sps30_start_manual_fan_cleaning(void);
 int16_t
 sps30_read_version(struct sps30_version_information* version_information);
 
+/**
+ * sps30_read_version_dev() - reentrant variant
+ *
+ * Same as sps30_read_version() on the given sensor.
+ */
+int16_t sps30_read_version_dev(
+    struct sps30_dev* dev,
+    struct sps30_version_information* version_information);
+
+/**
+ * sps30_decode_version() - decode received version information
+ *
+ * Decodes the response to a read version command which was received by other
+ * means than sps30_read_version().
+ *
+ * @header:                 Header of the response
+ * @data:                   Data of the response, SPS30_VERSION_LEN bytes
+ * @version_information:    Set to the decoded version information
+ * Return:                  Same as sps30_read_version()
+ */
+int16_t
+sps30_decode_version(const struct sensirion_shdlc_rx_header* header,
+                     const uint8_t* data,
+                     struct sps30_version_information* version_information);
+
+/**
+ * sps30_read_device_info() - Read the serial number and version information
+ *
+ * Same as sps30_get_serial() followed by sps30_read_version() but both
+ * commands are pipelined, taking only about one round trip.
+ *
+ * Note that serial and version_information must be discarded when the return
+ * code is non-zero.
+ *
+ * @serial:                 Memory where the serial number is written into as
+ *                          hex string (zero terminated). Must be at least
+ *                          SPS30_MAX_SERIAL_LEN long.
+ * @version_information:    Memory where the version information is stored
+ * Return:                  0 on success, an error code otherwise
+ */
+int16_t sps30_read_device_info(
+    char* serial, struct sps30_version_information* version_information);
+
+/**
+ * sps30_read_device_info_dev() - reentrant variant
+ *
+ * Same as sps30_read_device_info() on the given sensor.
+ */
+int16_t sps30_read_device_info_dev(
+    struct sps30_dev* dev, char* serial,
+    struct sps30_version_information* version_information);
+
 /**
  * sps30_reset() - reset the SGP30
  *
@@ -207,6 +500,13 @@ sps30_read_version(struct sps30_version_information* version_information);
  */
 int16_t sps30_reset(void);
 
+/**
+ * sps30_reset_dev() - reentrant variant
+ *
+ * Same as sps30_reset() on the given sensor.
+ */
+int16_t sps30_reset_dev(struct sps30_dev* dev);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * SPS30 driver for C++14 and later with the transport as a template
+ * parameter, e.g.
+ *
+ *     sps30::Sps30<sensirion::uart::LinuxTty> sensor("/dev/ttyUSB0");
+ *     struct sps30_measurement m;
+ *
+ *     if (sensor.transport().valid() && !sensor.start_measurement())
+ *         sensor.read_measurement(m);
+ *
+ * The functions and their results are the ones of sps30.h, and so are the
+ * response timeouts: link sps30.c for sps30_cmd_timeout_us(). The framing of
+ * sensirion_shdlc.hpp is inlined into every transaction, which runs without
+ * virtual calls or heap allocations. Use it where the per-transaction
+ * overhead of the C driver matters; one object per sensor, not thread-safe.
+ */
+
+#ifndef SPS30_HPP
+#define SPS30_HPP
+
+#include <string.h>
+#include <utility>
+
+#include "sensirion_shdlc.hpp"
+#include "sps30.h"
+#include "sps30_frames.hpp"
+
+namespace sps30 {
+
+constexpr uint8_t cmd_fan_clean_interval = 0x80;
+constexpr uint8_t version_len = 7;
+constexpr uint8_t measurement_u16_len = 20;
+
+inline uint32_t be32(const uint8_t* bytes) {
+    return static_cast<uint32_t>(bytes[0]) << 24 |
+           static_cast<uint32_t>(bytes[1]) << 16 |
+           static_cast<uint32_t>(bytes[2]) << 8 | bytes[3];
+}
+
+inline uint16_t be16(const uint8_t* bytes) {
+    return static_cast<uint16_t>(bytes[0] << 8 | bytes[1]);
+}
+
+inline int16_t state_error(uint8_t state) {
+    return static_cast<int16_t>(SPS30_ERR_STATE_MASK | state);
+}
+
+template <typename Transport> class Sps30 {
+  public:
+    using RxHeader = sensirion::shdlc::RxHeader;
+
+    /* the arguments are passed on to the constructor of the transport */
+    template <typename... Args>
+    explicit Sps30(Args&&... args) : dev_(std::forward<Args>(args)...) {
+    }
+
+    Transport& transport() {
+        return dev_.transport();
+    }
+
+    sensirion::shdlc::Device<Transport>& shdlc() {
+        return dev_;
+    }
+
+    /** See sps30_probe() */
+    int16_t probe() {
+        char serial[SPS30_MAX_SERIAL_LEN];
+
+        (void)wake_up();
+        return get_serial(serial);
+    }
+
+    /** See sps30_get_serial() */
+    int16_t get_serial(char* serial) {
+        RxHeader header;
+        int16_t ret;
+
+        ret = xcv(frames::get_serial, SPS30_MAX_SERIAL_LEN, header,
+                  reinterpret_cast<uint8_t*>(serial));
+        if (ret < 0)
+            return ret;
+        return header.state ? state_error(header.state) : 0;
+    }
+
+    /** See sps30_start_measurement_format() */
+    int16_t
+    start_measurement(uint8_t format = SPS30_MEASUREMENT_FORMAT_FLOAT) {
+        RxHeader header;
+
+        switch (format) {
+            case SPS30_MEASUREMENT_FORMAT_FLOAT:
+                return xcv(frames::start_measurement, 0, header, nullptr);
+            case SPS30_MEASUREMENT_FORMAT_UINT16:
+                return xcv(frames::start_measurement_uint16, 0, header,
+                           nullptr);
+            default:
+                return SPS30_ERR_INVALID_FORMAT;
+        }
+    }
+
+    /** See sps30_stop_measurement() */
+    int16_t stop_measurement() {
+        RxHeader header;
+
+        return xcv(frames::stop_measurement, 0, header, nullptr);
+    }
+
+    /** See sps30_read_measurement() */
+    int16_t read_measurement(struct sps30_measurement& measurement) {
+        float* values = &measurement.mc_1p0;
+        uint8_t data[SPS30_MEASUREMENT_LEN];
+        RxHeader header;
+        uint32_t raw;
+        int16_t ret;
+
+        ret = xcv(frames::read_measurement, sizeof(data), header, data);
+        if (ret)
+            return ret;
+        if (header.data_len != sizeof(data))
+            return SPS30_ERR_NOT_ENOUGH_DATA;
+
+        for (uint8_t i = 0; i < 10; ++i) {
+            raw = be32(&data[i * 4]);
+            memcpy(&values[i], &raw, sizeof(raw));
+        }
+        return header.state ? state_error(header.state) : 0;
+    }
+
+    /** See sps30_read_measurement_u16() */
+    int16_t read_measurement_u16(struct sps30_measurement_u16& measurement) {
+        uint16_t* values = &measurement.mc_1p0;
+        uint8_t data[measurement_u16_len];
+        RxHeader header;
+        int16_t ret;
+
+        ret = xcv(frames::read_measurement, sizeof(data), header, data);
+        if (ret)
+            return ret;
+        if (header.data_len != sizeof(data))
+            return SPS30_ERR_NOT_ENOUGH_DATA;
+
+        for (uint8_t i = 0; i < 10; ++i)
+            values[i] = be16(&data[i * 2]);
+        return header.state ? state_error(header.state) : 0;
+    }
+
+    /** See sps30_sleep() */
+    int16_t sleep() {
+        RxHeader header;
+
+        return xcv(frames::sleep, 0, header, nullptr);
+    }
+
+    /** See sps30_wake_up(), the wake-up byte and command go out together */
+    int16_t wake_up() {
+        uint8_t seq[1 + sizeof(frames::wake_up.bytes)];
+        RxHeader header;
+
+        seq[0] = 0xff;
+        memcpy(&seq[1], frames::wake_up.bytes, frames::wake_up.len);
+        return dev_.xcv_raw(static_cast<uint16_t>(1 + frames::wake_up.len),
+                            seq, 0, header, nullptr,
+                            sps30_cmd_timeout_us(frames::wake_up.cmd));
+    }
+
+    /** See sps30_get_fan_auto_cleaning_interval() */
+    int16_t get_fan_auto_cleaning_interval(uint32_t& interval_seconds) {
+        uint8_t data[4];
+        RxHeader header;
+        int16_t ret;
+
+        ret = xcv(frames::get_fan_clean_interval, sizeof(data), header, data);
+        if (ret < 0)
+            return ret;
+        interval_seconds = be32(data);
+        return header.state ? state_error(header.state) : 0;
+    }
+
+    /** See sps30_set_fan_auto_cleaning_interval() */
+    int16_t set_fan_auto_cleaning_interval(uint32_t interval_seconds) {
+        const uint8_t data[] = {0x00,
+                                static_cast<uint8_t>(interval_seconds >> 24),
+                                static_cast<uint8_t>(interval_seconds >> 16),
+                                static_cast<uint8_t>(interval_seconds >> 8),
+                                static_cast<uint8_t>(interval_seconds)};
+        RxHeader header;
+
+        return dev_.xcv(frames::addr, cmd_fan_clean_interval, sizeof(data),
+                        data, 0, header, nullptr,
+                        sps30_cmd_timeout_us(cmd_fan_clean_interval));
+    }
+
+    /** See sps30_get_fan_auto_cleaning_interval_days() */
+    int16_t get_fan_auto_cleaning_interval_days(uint8_t& interval_days) {
+        uint32_t interval_seconds;
+        int16_t ret;
+
+        ret = get_fan_auto_cleaning_interval(interval_seconds);
+        if (ret < 0)
+            return ret;
+        interval_days = static_cast<uint8_t>(interval_seconds / (24 * 60 * 60));
+        return ret;
+    }
+
+    /** See sps30_set_fan_auto_cleaning_interval_days() */
+    int16_t set_fan_auto_cleaning_interval_days(uint8_t interval_days) {
+        return set_fan_auto_cleaning_interval(
+            static_cast<uint32_t>(interval_days) * 24 * 60 * 60);
+    }
+
+    /** See sps30_start_manual_fan_cleaning() */
+    int16_t start_manual_fan_cleaning() {
+        RxHeader header;
+
+        return xcv(frames::start_fan_cleaning, 0, header, nullptr);
+    }
+
+    /** See sps30_read_version() */
+    int16_t read_version(struct sps30_version_information& version) {
+        uint8_t data[version_len];
+        RxHeader header;
+        int16_t ret;
+
+        ret = xcv(frames::read_version, sizeof(data), header, data);
+        if (ret)
+            return ret;
+        if (header.data_len != sizeof(data))
+            return SPS30_ERR_NOT_ENOUGH_DATA;
+        if (header.state)
+            return state_error(header.state);
+
+        version.firmware_major = data[0];
+        version.firmware_minor = data[1];
+        version.hardware_revision = data[3];
+        version.shdlc_major = data[5];
+        version.shdlc_minor = data[6];
+        return 0;
+    }
+
+    /** See sps30_reset() */
+    int16_t reset() {
+        RxHeader header;
+
+        return xcv(frames::reset, 0, header, nullptr);
+    }
+
+  private:
+    /* transceive a precomputed frame, see sps30_frames.hpp */
+    template <size_t N>
+    int16_t xcv(const sensirion::shdlc::Frame<N>& frame, uint8_t max_data_len,
+                RxHeader& header, uint8_t* data) {
+        return dev_.xcv(frame, max_data_len, header, data,
+                        sps30_cmd_timeout_us(frame.cmd));
+    }
+
+    sensirion::shdlc::Device<Transport> dev_;
+};
+
+}  // namespace sps30
+
+#endif /* SPS30_HPP */
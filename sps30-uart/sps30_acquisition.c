@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <string.h>
+#include <time.h>
+
+#include "sps30_acquisition.h"
+
+/* wait for a post, up to timeout_us or forever if timeout_us is 0 */
+static void sps30_acq_sem_wait(sem_t* sem, uint32_t timeout_us) {
+    struct timespec ts;
+    uint64_t deadline_ns;
+
+    /* sem_timedwait() only takes CLOCK_REALTIME deadlines */
+    clock_gettime(CLOCK_REALTIME, &ts);
+    deadline_ns = (uint64_t)ts.tv_nsec + (uint64_t)timeout_us * 1000;
+    ts.tv_sec += (time_t)(deadline_ns / 1000000000);
+    ts.tv_nsec = (long)(deadline_ns % 1000000000);
+    while ((timeout_us ? sem_timedwait(sem, &ts) : sem_wait(sem)) &&
+           errno == EINTR)
+        ;
+}
+
+/* running average of the measurements of a sample */
+static void sps30_acq_merge(struct sps30_acq_sample* sample,
+                            const struct sps30_acq_sample* next) {
+    float* avg = &sample->measurement.mc_1p0;
+    const float* m = &next->measurement.mc_1p0;
+    uint16_t count = (uint16_t)(sample->count + 1);
+    uint8_t i;
+
+    for (i = 0; i < 10; ++i)
+        avg[i] += (m[i] - avg[i]) / (float)count;
+    sample->count = count;
+    sample->time_us = next->time_us;
+    if (next->status)
+        sample->status = next->status;
+}
+
+/**
+ * Push a sample into the ring as the producer. The oldest sample is dropped
+ * by moving the consumer's tail, which the consumer detects when it tries to
+ * move the tail itself.
+ *
+ * Return: 1 if the sample was pushed, 0 if the ring is full
+ */
+static uint8_t sps30_acq_push(struct sps30_acquisition* acq,
+                              const struct sps30_acq_sample* sample) {
+    uint32_t head = acq->head;
+    uint32_t tail;
+
+    for (;;) {
+        tail = __atomic_load_n(&acq->tail, __ATOMIC_ACQUIRE);
+        if (head - tail <= acq->mask)
+            break;
+
+        switch (acq->config.overflow) {
+            case SPS30_ACQ_DROP_OLDEST:
+                if (__atomic_compare_exchange_n(&acq->tail, &tail, tail + 1, 0,
+                                                __ATOMIC_ACQ_REL,
+                                                __ATOMIC_ACQUIRE))
+                    __atomic_fetch_add(&acq->dropped, 1, __ATOMIC_RELAXED);
+                break;
+
+            case SPS30_ACQ_BLOCK:
+                /* announce the wait before checking again, so the consumer
+                 * either sees it or the space it made is seen here */
+                __atomic_store_n(&acq->blocked, 1, __ATOMIC_SEQ_CST);
+                if (__atomic_load_n(&acq->tail, __ATOMIC_SEQ_CST) == tail &&
+                    !__atomic_load_n(&acq->stop, __ATOMIC_ACQUIRE))
+                    sps30_acq_sem_wait(&acq->space, 0);
+                __atomic_store_n(&acq->blocked, 0, __ATOMIC_SEQ_CST);
+                if (__atomic_load_n(&acq->stop, __ATOMIC_ACQUIRE))
+                    return 0;
+                break;
+
+            default:
+                return 0;
+        }
+    }
+
+    acq->config.ring[head & acq->mask] = *sample;
+    __atomic_store_n(&acq->head, head + 1, __ATOMIC_RELEASE);
+    sem_post(&acq->data);
+    return 1;
+}
+
+/* take up to max_count samples as the consumer */
+static uint16_t sps30_acq_take(struct sps30_acquisition* acq,
+                               struct sps30_acq_sample* samples,
+                               uint16_t max_count) {
+    uint32_t tail;
+    uint32_t count;
+    uint32_t i;
+
+    for (;;) {
+        tail = __atomic_load_n(&acq->tail, __ATOMIC_ACQUIRE);
+        count = __atomic_load_n(&acq->head, __ATOMIC_ACQUIRE) - tail;
+        if (count > max_count)
+            count = max_count;
+        if (!count)
+            return 0;
+
+        for (i = 0; i < count; ++i)
+            samples[i] = acq->config.ring[(tail + i) & acq->mask];
+
+        /* the copies are only valid if the producer did not drop any of the
+         * samples, and thus reuse their slots, in the meantime */
+        if (__atomic_compare_exchange_n(&acq->tail, &tail, tail + count, 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+            break;
+    }
+
+    if (__atomic_load_n(&acq->blocked, __ATOMIC_SEQ_CST))
+        sem_post(&acq->space);
+    return (uint16_t)count;
+}
+
+/* hand a measurement to the ring according to the overflow policy */
+static void sps30_acq_put(struct sps30_acquisition* acq,
+                          struct sps30_acq_sample* pending,
+                          const struct sps30_acq_sample* sample) {
+    if (pending->count && sps30_acq_push(acq, pending))
+        pending->count = 0;
+
+    if (pending->count) {
+        sps30_acq_merge(pending, sample);
+        __atomic_fetch_add(&acq->aggregated, 1, __ATOMIC_RELAXED);
+    } else if (!sps30_acq_push(acq, sample) &&
+               acq->config.overflow == SPS30_ACQ_AGGREGATE) {
+        *pending = *sample;
+    }
+}
+
+static void* sps30_acq_producer(void* arg) {
+    struct sps30_acquisition* acq = (struct sps30_acquisition*)arg;
+    struct sps30_acq_sample pending;
+    struct sps30_acq_sample sample;
+    uint32_t slot;
+    int16_t ret;
+
+    pending.count = 0;
+    while (sps30_timer_wait(&acq->timer, &slot) == 0) {
+        ret = sps30_read_measurement_dev(acq->dev, &sample.measurement);
+        /* the read returns as soon as the frame is complete */
+        sample.time_us = sps30_timer_now_us();
+        if (ret == 0 || SPS30_IS_ERR_STATE(ret)) {
+            sample.slot = slot;
+            sample.seq = __atomic_fetch_add(&acq->reads, 1, __ATOMIC_RELAXED);
+            sample.count = 1;
+            sample.status = ret;
+            sps30_acq_put(acq, &pending, &sample);
+        } else if (ret != SPS30_ERR_NOT_ENOUGH_DATA) {
+            __atomic_fetch_add(&acq->errors, 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    if (pending.count)
+        sps30_acq_push(acq, &pending);
+    return NULL;
+}
+
+static void* sps30_acq_consumer(void* arg) {
+    struct sps30_acquisition* acq = (struct sps30_acquisition*)arg;
+    struct sps30_acq_sample batch[SPS30_ACQ_BATCH_SIZE];
+    uint16_t count;
+    uint8_t stop;
+
+    do {
+        sps30_acq_sem_wait(&acq->data, 0);
+        /* stopping is announced after the producer is done */
+        stop = __atomic_load_n(&acq->stop, __ATOMIC_ACQUIRE) > 1;
+        while ((count = sps30_acq_take(acq, batch, SPS30_ACQ_BATCH_SIZE)))
+            acq->config.callback(batch, count, acq->config.callback_ctx);
+    } while (!stop);
+    return NULL;
+}
+
+int16_t sps30_acquisition_start(struct sps30_acquisition* acq,
+                                struct sps30_dev* dev,
+                                const struct sps30_acq_config* config) {
+    if (!config->interval_us || !config->ring || !config->ring_size ||
+        (config->ring_size & (config->ring_size - 1)))
+        return -1;
+
+    memset(acq, 0, sizeof(*acq));
+    acq->dev = dev;
+    acq->config = *config;
+    acq->mask = config->ring_size - 1;
+    if (sps30_timer_init(&acq->timer, config->interval_us,
+                         sps30_timer_now_us() + config->interval_us))
+        return -1;
+    sem_init(&acq->data, 0, 0);
+    sem_init(&acq->space, 0, 0);
+
+    if (config->callback && pthread_create(&acq->consumer, NULL,
+                                           sps30_acq_consumer, acq))
+        goto err_consumer;
+    if (pthread_create(&acq->producer, NULL, sps30_acq_producer, acq))
+        goto err_producer;
+    return 0;
+
+err_producer:
+    if (config->callback) {
+        __atomic_store_n(&acq->stop, 2, __ATOMIC_RELEASE);
+        sem_post(&acq->data);
+        pthread_join(acq->consumer, NULL);
+    }
+err_consumer:
+    sem_destroy(&acq->space);
+    sem_destroy(&acq->data);
+    sps30_timer_destroy(&acq->timer);
+    return -1;
+}
+
+uint16_t sps30_acquisition_drain(struct sps30_acquisition* acq,
+                                 struct sps30_acq_sample* samples,
+                                 uint16_t max_count, uint32_t timeout_us) {
+    uint16_t count;
+
+    /* forget the posts of samples which are taken now anyway */
+    while (sem_trywait(&acq->data) == 0)
+        ;
+    count = sps30_acq_take(acq, samples, max_count);
+    if (!count && timeout_us) {
+        sps30_acq_sem_wait(&acq->data, timeout_us);
+        count = sps30_acq_take(acq, samples, max_count);
+    }
+    return count;
+}
+
+void sps30_acquisition_stop(struct sps30_acquisition* acq) {
+    __atomic_store_n(&acq->stop, 1, __ATOMIC_RELEASE);
+    sps30_timer_cancel(&acq->timer);
+    /* a producer blocked on a full ring gives up */
+    sem_post(&acq->space);
+    pthread_join(acq->producer, NULL);
+
+    if (acq->config.callback) {
+        __atomic_store_n(&acq->stop, 2, __ATOMIC_RELEASE);
+        sem_post(&acq->data);
+        pthread_join(acq->consumer, NULL);
+    }
+
+    sem_destroy(&acq->space);
+    sem_destroy(&acq->data);
+    sps30_timer_destroy(&acq->timer);
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SPS30_ACQUISITION_H
+#define SPS30_ACQUISITION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "sensirion_arch_config.h"
+#include "sps30.h"
+#include "sps30_timer.h"
+
+/**
+ * Background acquisition for POSIX systems: a thread reads the measurements of
+ * a sensor at a fixed interval and pushes them into a lock-free
+ * single-producer/single-consumer ring, so a slow consumer never delays a
+ * read.
+ *
+ * The reads are scheduled on absolute deadlines of an sps30_timer, read i is
+ * due i + 1 intervals after the start. A read which is late because the
+ * previous one took too long is not repeated, its slot is skipped and missing
+ * in the sample slot numbers.
+ *
+ * Start the measurement before starting the acquisition. Consume the samples
+ * with sps30_acquisition_drain() from a single thread, or register a callback
+ * which is called in batches from a consumer thread of the acquisition.
+ */
+
+/**
+ * enum sps30_acq_overflow - what happens to a sample when the ring is full
+ *
+ * @SPS30_ACQ_DROP_OLDEST:  The oldest sample is dropped
+ * @SPS30_ACQ_BLOCK:        The acquisition thread waits for the consumer, the
+ *                          reads are delayed
+ * @SPS30_ACQ_AGGREGATE:    Measurements are averaged into one sample until
+ *                          there is room again
+ */
+enum sps30_acq_overflow {
+    SPS30_ACQ_DROP_OLDEST,
+    SPS30_ACQ_BLOCK,
+    SPS30_ACQ_AGGREGATE,
+};
+
+/**
+ * struct sps30_acq_sample - a timestamped measurement
+ *
+ * @time_us:        CLOCK_MONOTONIC time when the response frame was received
+ * @slot:           Number of the interval the read was scheduled for, due at
+ *                  sps30_timer_slot_us(&acq->timer, slot). Gaps are skipped
+ *                  slots or failed reads.
+ * @measurement:    The measurement, the average of count measurements
+ * @seq:            Number of the read, counting from 0, of the first
+ *                  measurement in the sample. Gaps are dropped samples.
+ * @count:          Number of measurements in the sample, 1 unless aggregated
+ * @status:         0 or the device state error of the read, see
+ *                  SPS30_IS_ERR_STATE()
+ */
+struct sps30_acq_sample {
+    uint64_t time_us;
+    uint32_t slot;
+    struct sps30_measurement measurement;
+    uint32_t seq;
+    uint16_t count;
+    int16_t status;
+};
+
+typedef void (*sps30_acq_callback)(const struct sps30_acq_sample* samples,
+                                   uint16_t count, void* ctx);
+
+/**
+ * struct sps30_acq_config - configuration of the acquisition
+ *
+ * @interval_us:    Time between two reads, e.g. 1000000
+ * @overflow:       Policy when the ring is full
+ * @ring_size:      Number of samples in the ring, a power of two
+ * @ring:           Storage of the ring, must stay valid until the acquisition
+ *                  is stopped
+ * @callback:       Called with the samples in batches of up to
+ *                  SPS30_ACQ_BATCH_SIZE from a consumer thread, NULL to
+ *                  consume them with sps30_acquisition_drain()
+ * @callback_ctx:   Passed to the callback
+ */
+struct sps30_acq_config {
+    uint32_t interval_us;
+    enum sps30_acq_overflow overflow;
+    uint32_t ring_size;
+    struct sps30_acq_sample* ring;
+    sps30_acq_callback callback;
+    void* callback_ctx;
+};
+
+#define SPS30_ACQ_BATCH_SIZE 16
+
+/**
+ * struct sps30_acquisition - the acquisition, all fields are private except
+ * for the statistics
+ *
+ * @timer:      Timer of the reads, see the skipped slots in timer.skipped
+ * @reads:      Number of measurements read
+ * @dropped:    Number of samples dropped by SPS30_ACQ_DROP_OLDEST
+ * @aggregated: Number of measurements averaged into another sample by
+ *              SPS30_ACQ_AGGREGATE
+ * @errors:     Number of reads which failed
+ */
+struct sps30_acquisition {
+    struct sps30_dev* dev;
+    struct sps30_acq_config config;
+    uint32_t mask;
+
+    /* written by the producer, read by the consumer, and vice versa */
+    uint32_t head;
+    uint32_t tail;
+    sem_t data;
+    sem_t space;
+    uint8_t blocked;
+
+    pthread_t producer;
+    pthread_t consumer;
+    uint8_t stop;
+
+    struct sps30_timer timer;
+
+    uint32_t reads;
+    uint32_t dropped;
+    uint32_t aggregated;
+    uint32_t errors;
+};
+
+/**
+ * sps30_acquisition_start() - start reading measurements in the background
+ *
+ * @acq:    Acquisition to initialize
+ * @dev:    Initialized device with a started measurement, used by the
+ *          acquisition thread only until the acquisition is stopped
+ * @config: Configuration, copied
+ * Return:  0 on success, -1 on invalid arguments or when the threads could not
+ *          be started
+ */
+int16_t sps30_acquisition_start(struct sps30_acquisition* acq,
+                                struct sps30_dev* dev,
+                                const struct sps30_acq_config* config);
+
+/**
+ * sps30_acquisition_drain() - take the oldest samples from the ring
+ *
+ * Only without callback, from one consumer thread at a time.
+ *
+ * @acq:        Started acquisition
+ * @samples:    Receives the samples, oldest first
+ * @max_count:  Size of samples
+ * @timeout_us: Time to wait for a sample if the ring is empty, 0 to return
+ *              immediately
+ * Return:      Number of samples taken
+ */
+uint16_t sps30_acquisition_drain(struct sps30_acquisition* acq,
+                                 struct sps30_acq_sample* samples,
+                                 uint16_t max_count, uint32_t timeout_us);
+
+/**
+ * sps30_acquisition_stop() - stop the threads
+ *
+ * Samples still in the ring are passed to the callback first, if any. The
+ * measurement of the sensor is not stopped.
+ */
+void sps30_acquisition_stop(struct sps30_acquisition* acq);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPS30_ACQUISITION_H */
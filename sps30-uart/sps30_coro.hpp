@@ -0,0 +1,609 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * C++20 coroutine API of the SPS30 for Linux.
+ *
+ * Each command is an awaitable which transmits its frame, suspends the
+ * calling coroutine and is resumed by a Reactor once the response was decoded
+ * or timed out. A thread running the reactor thus serves any number of
+ * sensors at once, e.g.
+ *
+ *     sps30::coro::Task<int16_t> poll(sps30::coro::Sensor& sensor) {
+ *         auto [error, measurement] = co_await sensor.read_measurement();
+ *         ...
+ *     }
+ *
+ *     sps30::coro::EpollReactor reactor;
+ *     sps30::coro::Sensor sensor(reactor, fd);
+ *     auto task = poll(sensor);
+ *     task.start();
+ *     reactor.run();
+ *
+ * The results are the same as the ones of the C functions in sps30.h. The fd
+ * is a serial port configured like the Linux UART HAL does, e.g. opened with
+ * sensirion_uart_open() and taken from sensirion_uart_get_fd(). Run one
+ * transaction per sensor at a time. Reactors are not thread-safe, use one per
+ * thread and give each sensor to one of them.
+ */
+
+#ifndef SPS30_CORO_HPP
+#define SPS30_CORO_HPP
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sensirion_shdlc.h"
+#include "sps30.h"
+#include "sps30_frames.h"
+
+namespace sps30 {
+namespace coro {
+
+inline uint64_t now_us() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000 +
+           static_cast<uint64_t>(ts.tv_nsec) / 1000;
+}
+
+/**
+ * Where suspended transactions wait for their serial port to become readable.
+ * Implement it to run the sensors on an existing event loop, or use the
+ * EpollReactor.
+ */
+class Reactor {
+  public:
+    class Waiter {
+      public:
+        /* called once per wait_readable(), with timed_out set if the fd did
+         * not become readable in time */
+        virtual void ready(bool timed_out) = 0;
+
+      protected:
+        ~Waiter() = default;
+    };
+
+    /* call waiter->ready() once fd is readable or the timeout expired */
+    virtual void wait_readable(int fd, uint32_t timeout_us, Waiter* waiter) = 0;
+
+  protected:
+    ~Reactor() = default;
+};
+
+/**
+ * Reactor on an epoll instance, run it with run() or run_once() from a single
+ * thread.
+ */
+class EpollReactor final : public Reactor {
+  public:
+    EpollReactor() : epoll_fd_(epoll_create1(EPOLL_CLOEXEC)) {
+    }
+
+    ~EpollReactor() {
+        if (epoll_fd_ >= 0)
+            close(epoll_fd_);
+    }
+
+    EpollReactor(const EpollReactor&) = delete;
+    EpollReactor& operator=(const EpollReactor&) = delete;
+
+    bool valid() const {
+        return epoll_fd_ >= 0;
+    }
+
+    /* number of waiters which did not get ready yet */
+    size_t pending() const {
+        return pending_;
+    }
+
+    void wait_readable(int fd, uint32_t timeout_us, Waiter* waiter) override {
+        struct epoll_event event = {};
+        Entry& entry = entries_[fd];
+
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.fd = fd;
+        /* re-arm the one-shot registration, or add a new or reused fd */
+        if (!entry.registered ||
+            epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event)) {
+            if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) &&
+                errno != EEXIST) {
+                entries_.erase(fd);
+                waiter->ready(true);
+                return;
+            }
+            entry.registered = true;
+        }
+        entry.waiter = waiter;
+        entry.seq = ++seq_;
+        timers_.push(Timer{now_us() + timeout_us, fd, entry.seq});
+        ++pending_;
+    }
+
+    /**
+     * Wait for at most timeout_ms (-1 for the next event) and notify the
+     * waiters which got ready or timed out.
+     */
+    void run_once(int timeout_ms = -1) {
+        struct epoll_event events[64];
+        uint64_t now = now_us();
+        int n;
+
+        drop_stale_timers();
+        if (!timers_.empty()) {
+            int due_ms = timers_.top().deadline_us > now
+                             ? static_cast<int>(
+                                   (timers_.top().deadline_us - now + 999) /
+                                   1000)
+                             : 0;
+            if (timeout_ms < 0 || due_ms < timeout_ms)
+                timeout_ms = due_ms;
+        }
+
+        n = epoll_wait(epoll_fd_, events, 64, timeout_ms);
+        for (int i = 0; i < n; ++i)
+            notify(events[i].data.fd, 0, false);
+
+        now = now_us();
+        for (drop_stale_timers();
+             !timers_.empty() && timers_.top().deadline_us <= now;
+             drop_stale_timers()) {
+            Timer timer = timers_.top();
+            timers_.pop();
+            notify(timer.fd, timer.seq, true);
+        }
+    }
+
+    /* run until no transaction is waiting anymore */
+    void run() {
+        while (pending_)
+            run_once();
+    }
+
+  private:
+    struct Entry {
+        Waiter* waiter = nullptr;
+        uint64_t seq = 0;
+        bool registered = false;
+    };
+
+    struct Timer {
+        uint64_t deadline_us;
+        int fd;
+        uint64_t seq;
+
+        bool operator>(const Timer& other) const {
+            return deadline_us > other.deadline_us;
+        }
+    };
+
+    /* the waiter of fd, if it is still the one of the timer with seq */
+    void notify(int fd, uint64_t seq, bool timed_out) {
+        auto it = entries_.find(fd);
+        Waiter* waiter;
+
+        if (it == entries_.end() || !it->second.waiter ||
+            (seq && it->second.seq != seq))
+            return;
+        waiter = it->second.waiter;
+        it->second.waiter = nullptr;
+        --pending_;
+        /* may wait again or start another transaction */
+        waiter->ready(timed_out);
+    }
+
+    /* timers of waiters which got ready before their deadline */
+    void drop_stale_timers() {
+        while (!timers_.empty()) {
+            auto it = entries_.find(timers_.top().fd);
+            if (it != entries_.end() && it->second.waiter &&
+                it->second.seq == timers_.top().seq)
+                return;
+            timers_.pop();
+        }
+    }
+
+    int epoll_fd_;
+    size_t pending_ = 0;
+    uint64_t seq_ = 0;
+    std::unordered_map<int, Entry> entries_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>>
+        timers_;
+};
+
+/**
+ * Lazily started coroutine returning a T, awaitable from other coroutines.
+ * Start the outermost task with start() and check done() and result() once
+ * the reactor ran.
+ */
+template <typename T> class Task {
+  public:
+    struct promise_type {
+        std::optional<T> value;
+        std::coroutine_handle<> continuation;
+
+        Task get_return_object() {
+            return Task(
+                std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        auto final_suspend() noexcept {
+            struct Continue {
+                bool await_ready() noexcept {
+                    return false;
+                }
+                std::coroutine_handle<>
+                await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                    auto next = h.promise().continuation;
+                    return next ? next : std::noop_coroutine();
+                }
+                void await_resume() noexcept {
+                }
+            };
+            return Continue{};
+        }
+
+        void return_value(T v) {
+            value = std::move(v);
+        }
+
+        void unhandled_exception() {
+            std::terminate();
+        }
+    };
+
+    explicit Task(std::coroutine_handle<promise_type> handle)
+        : handle_(handle) {
+    }
+
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() {
+        if (handle_)
+            handle_.destroy();
+    }
+
+    void start() {
+        handle_.resume();
+    }
+
+    bool done() const {
+        return handle_.done();
+    }
+
+    T& result() {
+        return *handle_.promise().value;
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) {
+        handle_.promise().continuation = caller;
+        return handle_;
+    }
+
+    T await_resume() {
+        return std::move(*handle_.promise().value);
+    }
+
+  private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+/** The error code of a command as returned by the C API and its result */
+template <typename T> struct Result {
+    int16_t error;
+    T value;
+};
+
+/** Serial number, zero terminated */
+struct Serial {
+    char str[SPS30_MAX_SERIAL_LEN];
+};
+
+/**
+ * One SHDLC transaction on the serial port: transmits the frame when awaited
+ * and resumes the awaiting coroutine with Decode(status, header, data).
+ */
+template <typename Decode>
+class Transaction final : private Reactor::Waiter {
+  public:
+    Transaction(Reactor& reactor, int fd, enum sps30_frame_id id,
+                uint8_t max_data_len, bool wake_up = false)
+        : reactor_(reactor), fd_(fd), frame_(&sps30_frames[id]),
+          max_data_len_(max_data_len), wake_up_(wake_up) {
+    }
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle) {
+        /* the wake-up byte and command go out together */
+        static const uint8_t wake_up_byte = 0xff;
+        struct iovec iov[2];
+        int iovcnt = 0;
+        ssize_t len;
+
+        handle_ = handle;
+        if (wake_up_) {
+            iov[iovcnt].iov_base = const_cast<uint8_t*>(&wake_up_byte);
+            iov[iovcnt++].iov_len = 1;
+        }
+        iov[iovcnt].iov_base = const_cast<uint8_t*>(frame_->bytes);
+        iov[iovcnt++].iov_len = frame_->len;
+
+        sensirion_shdlc_rx_decoder_init(&decoder_, max_data_len_, &header_,
+                                        data_);
+        len = writev(fd_, iov, iovcnt);
+        if (len != static_cast<ssize_t>(frame_->len + wake_up_)) {
+            status_ = len < 0 ? -1 : SENSIRION_SHDLC_ERR_TX_INCOMPLETE;
+            return false;
+        }
+
+        deadline_us_ = now_us() + sps30_cmd_timeout_us(frame_->cmd);
+        reactor_.wait_readable(fd_, sps30_cmd_timeout_us(frame_->cmd), this);
+        return true;
+    }
+
+    auto await_resume() {
+        return Decode()(status_, header_, data_);
+    }
+
+  private:
+    void ready(bool timed_out) override {
+        uint64_t now;
+
+        if (timed_out) {
+            status_ = rx_len_ ? SENSIRION_SHDLC_ERR_MISSING_STOP
+                              : SENSIRION_SHDLC_ERR_MISSING_START;
+        } else if (!receive()) {
+            now = now_us();
+            reactor_.wait_readable(
+                fd_,
+                deadline_us_ > now ? static_cast<uint32_t>(deadline_us_ - now)
+                                   : 0,
+                this);
+            return;
+        }
+        handle_.resume();
+    }
+
+    /* feed the received bytes to the decoder, true once the status is set */
+    bool receive() {
+        uint8_t buf[256];
+        uint16_t consumed;
+        ssize_t len;
+        int16_t ret;
+
+        len = read(fd_, buf, sizeof(buf));
+        if (len < 0 && (errno == EAGAIN || errno == EINTR))
+            return false;
+        if (len <= 0) {
+            /* read error or hang-up */
+            status_ = -1;
+            return true;
+        }
+        rx_len_ += static_cast<uint16_t>(len);
+        ret = sensirion_shdlc_rx_decode(&decoder_, static_cast<uint16_t>(len),
+                                        buf, &consumed);
+        if (ret == SENSIRION_SHDLC_RX_INCOMPLETE)
+            return false;
+        status_ = ret;
+        return true;
+    }
+
+    Reactor& reactor_;
+    int fd_;
+    const struct sps30_frame* frame_;
+    uint8_t max_data_len_;
+    bool wake_up_;
+    std::coroutine_handle<> handle_;
+    uint64_t deadline_us_ = 0;
+    struct sensirion_shdlc_rx_decoder decoder_;
+    struct sensirion_shdlc_rx_header header_ = {};
+    uint8_t data_[SPS30_MEASUREMENT_LEN];
+    uint16_t rx_len_ = 0;
+    int16_t status_ = 0;
+};
+
+namespace decode {
+
+/* commands whose response state is not reported, like in sps30.c */
+struct Status {
+    int16_t operator()(int16_t status, const sensirion_shdlc_rx_header&,
+                       const uint8_t*) const {
+        return status;
+    }
+};
+
+struct Measurement {
+    Result<sps30_measurement> operator()(int16_t status,
+                                         const sensirion_shdlc_rx_header& h,
+                                         const uint8_t* data) const {
+        Result<sps30_measurement> r = {status, {}};
+
+        if (!status)
+            r.error = sps30_decode_measurement(&h, data, &r.value);
+        return r;
+    }
+};
+
+struct SerialNumber {
+    Result<Serial> operator()(int16_t status,
+                              const sensirion_shdlc_rx_header& h,
+                              const uint8_t* data) const {
+        Result<Serial> r = {status, {}};
+
+        if (!status)
+            r.error = sps30_decode_serial(&h, data, r.value.str);
+        return r;
+    }
+};
+
+struct MeasurementU16 {
+    Result<sps30_measurement_u16> operator()(int16_t status,
+                                             const sensirion_shdlc_rx_header& h,
+                                             const uint8_t* data) const {
+        Result<sps30_measurement_u16> r = {status, {}};
+
+        if (!status)
+            r.error = sps30_decode_measurement_u16(&h, data, &r.value);
+        return r;
+    }
+};
+
+struct FanCleaningInterval {
+    Result<uint32_t> operator()(int16_t status,
+                                const sensirion_shdlc_rx_header& h,
+                                const uint8_t* data) const {
+        Result<uint32_t> r = {status, 0};
+
+        if (status)
+            return r;
+        r.value = sensirion_bytes_to_uint32_t(data);
+        if (h.state)
+            r.error = static_cast<int16_t>(SPS30_ERR_STATE_MASK | h.state);
+        return r;
+    }
+};
+
+struct Version {
+    Result<sps30_version_information>
+    operator()(int16_t status, const sensirion_shdlc_rx_header& h,
+               const uint8_t* data) const {
+        Result<sps30_version_information> r = {status, {}};
+
+        if (!status)
+            r.error = sps30_decode_version(&h, data, &r.value);
+        return r;
+    }
+};
+
+}  // namespace decode
+
+/**
+ * An SPS30 on a serial port, the awaitable counterparts of the functions in
+ * sps30.h. Each awaitable must be awaited exactly once.
+ */
+class Sensor {
+  public:
+    Sensor(Reactor& reactor, int fd) : reactor_(reactor), fd_(fd) {
+    }
+
+    /* SPS30_MEASUREMENT_FORMAT_FLOAT or SPS30_MEASUREMENT_FORMAT_UINT16 */
+    Transaction<decode::Status>
+    start_measurement(uint8_t format = SPS30_MEASUREMENT_FORMAT_FLOAT) {
+        return {reactor_, fd_,
+                format == SPS30_MEASUREMENT_FORMAT_UINT16
+                    ? SPS30_FRAME_START_MEASUREMENT_UINT16
+                    : SPS30_FRAME_START_MEASUREMENT,
+                0};
+    }
+
+    Transaction<decode::Status> stop_measurement() {
+        return {reactor_, fd_, SPS30_FRAME_STOP_MEASUREMENT, 0};
+    }
+
+    Transaction<decode::Measurement> read_measurement() {
+        return {reactor_, fd_, SPS30_FRAME_READ_MEASUREMENT,
+                SPS30_MEASUREMENT_LEN};
+    }
+
+    Transaction<decode::MeasurementU16> read_measurement_u16() {
+        return {reactor_, fd_, SPS30_FRAME_READ_MEASUREMENT,
+                SPS30_MEASUREMENT_U16_LEN};
+    }
+
+    Transaction<decode::Status> sleep() {
+        return {reactor_, fd_, SPS30_FRAME_SLEEP, 0};
+    }
+
+    Transaction<decode::Status> wake_up() {
+        return {reactor_, fd_, SPS30_FRAME_WAKE_UP, 0, true};
+    }
+
+    Transaction<decode::FanCleaningInterval>
+    get_fan_auto_cleaning_interval() {
+        return {reactor_, fd_, SPS30_FRAME_GET_FAN_CLEAN_INTV, 4};
+    }
+
+    Transaction<decode::Status> start_manual_fan_cleaning() {
+        return {reactor_, fd_, SPS30_FRAME_START_FAN_CLEANING, 0};
+    }
+
+    Transaction<decode::SerialNumber> get_serial() {
+        return {reactor_, fd_, SPS30_FRAME_GET_SERIAL, SPS30_MAX_SERIAL_LEN};
+    }
+
+    Transaction<decode::Version> read_version() {
+        return {reactor_, fd_, SPS30_FRAME_READ_VERSION, SPS30_VERSION_LEN};
+    }
+
+    Transaction<decode::Status> reset() {
+        return {reactor_, fd_, SPS30_FRAME_RESET, 0};
+    }
+
+    int fd() const {
+        return fd_;
+    }
+
+  private:
+    Reactor& reactor_;
+    int fd_;
+};
+
+}  // namespace coro
+}  // namespace sps30
+
+#endif /* SPS30_CORO_HPP */
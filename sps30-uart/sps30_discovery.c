@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <glob.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "sensirion_uart_linux.h"
+#include "sps30_discovery.h"
+
+/* a device probed by its own thread on its own port */
+struct sps30_discovery_probe {
+    pthread_t thread;
+    char path[SENSIRION_UART_MAX_PATH_LEN];
+    char serial[SPS30_MAX_SERIAL_LEN];
+    uint8_t port;
+    int16_t ret;
+};
+
+struct sps30_discovery_probes {
+    uint8_t count;
+    struct sps30_discovery_probe probes[SENSIRION_UART_MAX_PORTS];
+};
+
+static void sps30_discovery_add(struct sps30_discovery_probes* probes,
+                                const char* path, dev_t* devices) {
+    struct stat st;
+    size_t len = strlen(path);
+    uint8_t i;
+
+    if (probes->count >= SENSIRION_UART_MAX_PORTS ||
+        len >= SENSIRION_UART_MAX_PATH_LEN || stat(path, &st) ||
+        !S_ISCHR(st.st_mode))
+        return;
+
+    /* the same device listed twice, e.g. /dev/serial0 and /dev/ttyAMA0 */
+    for (i = 0; i < probes->count; ++i) {
+        if (devices[i] == st.st_rdev)
+            return;
+    }
+    devices[probes->count] = st.st_rdev;
+    memcpy(probes->probes[probes->count].path, path, len + 1);
+    ++probes->count;
+}
+
+static int16_t sps30_discovery_enumerate(struct sps30_discovery_probes* probes,
+                                         const char* const* patterns) {
+    static const char* const default_patterns[] =
+        SPS30_DISCOVERY_DEFAULT_PATTERNS;
+    dev_t devices[SENSIRION_UART_MAX_PORTS];
+    glob_t paths;
+    size_t i;
+    int ret;
+
+    if (!patterns)
+        patterns = default_patterns;
+
+    probes->count = 0;
+    for (; *patterns; ++patterns) {
+        ret = glob(*patterns, 0, NULL, &paths);
+        if (ret == GLOB_NOMATCH)
+            continue;
+        if (ret)
+            return -1;
+        for (i = 0; i < paths.gl_pathc; ++i)
+            sps30_discovery_add(probes, paths.gl_pathv[i], devices);
+        globfree(&paths);
+    }
+    return 0;
+}
+
+static void* sps30_discovery_probe_thread(void* arg) {
+    struct sps30_discovery_probe* probe = (struct sps30_discovery_probe*)arg;
+    struct sps30_dev dev;
+
+    probe->ret = -1;
+    if (sensirion_uart_open_port(probe->port))
+        return NULL;
+
+    sps30_dev_init(&dev, &sensirion_uart_linux_ops,
+                   sensirion_uart_linux_port(probe->port));
+    probe->ret = sps30_probe_dev(&dev);
+    if (!probe->ret)
+        probe->ret = sps30_get_serial_dev(&dev, probe->serial);
+    if (probe->ret)
+        sensirion_uart_close_port(probe->port);
+    return NULL;
+}
+
+/* probe all devices at once on ports 0 and up */
+static void sps30_discovery_probe_all(struct sps30_discovery_probes* probes) {
+    struct sps30_discovery_probe* probe;
+    uint8_t started[SENSIRION_UART_MAX_PORTS];
+    uint8_t i;
+
+    for (i = 0; i < probes->count; ++i) {
+        probe = &probes->probes[i];
+        probe->port = i;
+        sensirion_uart_close_port(i);
+        sensirion_uart_set_port_path(i, probe->path);
+        started[i] = !pthread_create(&probe->thread, NULL,
+                                     sps30_discovery_probe_thread, probe);
+        if (!started[i])
+            sps30_discovery_probe_thread(probe);
+    }
+    for (i = 0; i < probes->count; ++i) {
+        if (started[i])
+            pthread_join(probes->probes[i].thread, NULL);
+    }
+}
+
+static void sps30_discovery_close(const struct sps30_discovery_probes* probes) {
+    uint8_t i;
+
+    for (i = 0; i < probes->count; ++i) {
+        if (!probes->probes[i].ret)
+            sensirion_uart_close_port(probes->probes[i].port);
+    }
+}
+
+/* load the cached sensors as probes, one "serial path" line each */
+static uint8_t sps30_discovery_load(struct sps30_discovery_probes* probes,
+                                    const char* cache_path) {
+    struct sps30_discovery_probe* probe;
+    char line[SPS30_MAX_SERIAL_LEN + SENSIRION_UART_MAX_PATH_LEN + 2];
+    char* sep;
+    FILE* f;
+
+    probes->count = 0;
+    f = fopen(cache_path, "r");
+    if (!f)
+        return 0;
+    while (probes->count < SENSIRION_UART_MAX_PORTS &&
+           fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\n")] = '\0';
+        sep = strchr(line, ' ');
+        if (!sep || (size_t)(sep - line) >= SPS30_MAX_SERIAL_LEN ||
+            strlen(sep + 1) >= SENSIRION_UART_MAX_PATH_LEN)
+            continue;
+        *sep = '\0';
+        probe = &probes->probes[probes->count++];
+        memcpy(probe->serial, line, (size_t)(sep - line) + 1);
+        memcpy(probe->path, sep + 1, strlen(sep + 1) + 1);
+    }
+    fclose(f);
+    return probes->count;
+}
+
+static void sps30_discovery_save(const struct sps30_discovery* discovery,
+                                 const char* cache_path) {
+    char tmp_path[4096];
+    uint8_t i;
+    FILE* f;
+
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", cache_path) >=
+        (int)sizeof(tmp_path))
+        return;
+    f = fopen(tmp_path, "w");
+    if (!f)
+        return;
+    for (i = 0; i < discovery->sensor_count; ++i)
+        fprintf(f, "%s %s\n", discovery->sensors[i].serial,
+                discovery->sensors[i].path);
+    /* replace the cache at once, a crash never leaves half a cache behind */
+    if (fclose(f) || rename(tmp_path, cache_path))
+        remove(tmp_path);
+}
+
+/* Probe the cached sensors.
+ * Return: 1 if all of them answered with their cached serial, 0 otherwise */
+static uint8_t sps30_discovery_verify(struct sps30_discovery_probes* probes) {
+    char serials[SENSIRION_UART_MAX_PORTS][SPS30_MAX_SERIAL_LEN];
+    uint8_t verified = 1;
+    uint8_t i;
+
+    for (i = 0; i < probes->count; ++i)
+        memcpy(serials[i], probes->probes[i].serial, SPS30_MAX_SERIAL_LEN);
+    sps30_discovery_probe_all(probes);
+    for (i = 0; i < probes->count; ++i) {
+        if (probes->probes[i].ret ||
+            strncmp(serials[i], probes->probes[i].serial,
+                    SPS30_MAX_SERIAL_LEN))
+            verified = 0;
+    }
+    if (!verified)
+        sps30_discovery_close(probes);
+    return verified;
+}
+
+int16_t sps30_discover(struct sps30_discovery* discovery,
+                       const char* const* patterns, const char* cache_path) {
+    struct sps30_discovery_probes probes;
+    struct sps30_discovery_sensor* sensor;
+    uint8_t i;
+
+    memset(discovery, 0, sizeof(*discovery));
+
+    if (cache_path && sps30_discovery_load(&probes, cache_path)) {
+        discovery->probe_count = probes.count;
+        discovery->from_cache = sps30_discovery_verify(&probes);
+    }
+    if (!discovery->from_cache) {
+        if (sps30_discovery_enumerate(&probes, patterns))
+            return -1;
+        discovery->probe_count += probes.count;
+        sps30_discovery_probe_all(&probes);
+    }
+
+    for (i = 0; i < probes.count; ++i) {
+        if (probes.probes[i].ret)
+            continue;
+        sensor = &discovery->sensors[discovery->sensor_count++];
+        memcpy(sensor->serial, probes.probes[i].serial, SPS30_MAX_SERIAL_LEN);
+        sensor->serial[SPS30_MAX_SERIAL_LEN - 1] = '\0';
+        memcpy(sensor->path, probes.probes[i].path, sizeof(sensor->path));
+        sensor->port = probes.probes[i].port;
+    }
+
+    if (cache_path && !discovery->from_cache)
+        sps30_discovery_save(discovery, cache_path);
+    return 0;
+}
+
+const struct sps30_discovery_sensor*
+sps30_discovery_find(const struct sps30_discovery* discovery,
+                     const char* serial) {
+    uint8_t i;
+
+    for (i = 0; i < discovery->sensor_count; ++i) {
+        if (!strncmp(discovery->sensors[i].serial, serial,
+                     SPS30_MAX_SERIAL_LEN))
+            return &discovery->sensors[i];
+    }
+    return NULL;
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SPS30_DISCOVERY_H
+#define SPS30_DISCOVERY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sensirion_arch_config.h"
+#include "sensirion_uart_linux.h"
+#include "sps30.h"
+
+/**
+ * Discovery of SPS30 sensors on Linux by serial number, for setups where the
+ * device paths change when sensors are replugged.
+ *
+ * All candidate devices are probed in parallel, one thread per device, so a
+ * scan takes about as long as probing a single device which does not answer.
+ * The result can be stored in a cache file, the next discovery then only
+ * verifies the cached sensors in a single parallel round and falls back to a
+ * full scan if any of them moved or disappeared.
+ */
+
+/** Device patterns scanned if none are given, see glob(3) */
+#define SPS30_DISCOVERY_DEFAULT_PATTERNS                                       \
+    { "/dev/ttyUSB*", "/dev/ttyACM*", "/dev/ttyAMA*", NULL }
+
+/**
+ * struct sps30_discovery_sensor - a discovered sensor
+ *
+ * @serial: Serial number of the sensor
+ * @path:   Device path it is attached to
+ * @port:   Open UART port of the sensor, select it with
+ *          sensirion_uart_select_port() or pass sensirion_uart_linux_port()
+ *          to sps30_dev_init()
+ */
+struct sps30_discovery_sensor {
+    char serial[SPS30_MAX_SERIAL_LEN];
+    char path[SENSIRION_UART_MAX_PATH_LEN];
+    uint8_t port;
+};
+
+/**
+ * struct sps30_discovery - result of sps30_discover()
+ *
+ * @sensor_count:   Number of sensors found
+ * @sensors:        The sensors found, in the order of the scanned devices
+ * @probe_count:    Number of devices probed
+ * @from_cache:     1 if the cached sensors were all verified and no devices
+ *                  were scanned, 0 otherwise
+ */
+struct sps30_discovery {
+    uint8_t sensor_count;
+    struct sps30_discovery_sensor sensors[SENSIRION_UART_MAX_PORTS];
+    uint8_t probe_count;
+    uint8_t from_cache;
+};
+
+/**
+ * sps30_discover() - find the SPS30 sensors attached to serial devices
+ *
+ * Probes the devices with sps30_probe() and sps30_get_serial() on UART ports
+ * 0 and up, which are closed first. The ports of sensors stay open, all other
+ * ports are closed. Devices matched by several patterns or links to the same
+ * device are probed once.
+ *
+ * @discovery:  Set to the sensors found
+ * @patterns:   NULL terminated list of device path patterns to scan, NULL for
+ *              SPS30_DISCOVERY_DEFAULT_PATTERNS
+ * @cache_path: File to verify first and to store the result in, NULL to scan
+ *              without a cache
+ * Return:      0 on success, -1 if the devices could not be enumerated
+ */
+int16_t sps30_discover(struct sps30_discovery* discovery,
+                       const char* const* patterns, const char* cache_path);
+
+/**
+ * sps30_discovery_find() - look up a sensor by its serial number
+ *
+ * Return:  The sensor or NULL if it was not discovered
+ */
+const struct sps30_discovery_sensor*
+sps30_discovery_find(const struct sps30_discovery* discovery,
+                     const char* serial);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPS30_DISCOVERY_H */
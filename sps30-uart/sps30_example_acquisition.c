@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>  // printf
+#include <math.h>   // roundf()
+#include <time.h>   // clock_gettime()
+#include <stdlib.h> // getenv()
+
+#include "sensirion_shdlc.h"
+#include "sensirion_uart.h"
+#include "sps30.h"
+#include "sps30_acquisition.h"
+
+/*
+ * Same as sps30_example_usage.c, but the measurements are read on a
+ * background thread at an exact 1s interval, see sps30_acquisition.h.
+ * Needs POSIX threads, build it with `make sps30_example_acquisition`.
+ */
+
+/**
+ * TO USE CONSOLE OUTPUT (PRINTF) AND WAIT (SLEEP) PLEASE ADAPT THEM TO YOUR
+ * PLATFORM
+ */
+//#define printf(...)
+
+int _round(float f) {
+    return (int) roundf(f);
+}
+
+int _roundK(float f) {
+    return (int) roundf(1000 * f); // preserve 3 fractional digits
+}
+
+struct sps30_measurement average_measurements(const struct sps30_measurement mm[], const int n) {
+    struct sps30_measurement m = { 0 }; // initialize all fields to zero
+    int valid_measurements = 0;
+
+    for (int i = 0; i < n; i++) {
+        if (mm[i].typical_particle_size > 0) { // valid measurement
+            valid_measurements += 1;
+            m.mc_1p0  += mm[i].mc_1p0;
+            m.mc_2p5  += mm[i].mc_2p5;
+            m.mc_4p0  += mm[i].mc_4p0;
+            m.mc_10p0 += mm[i].mc_10p0;
+            m.nc_0p5  += mm[i].nc_0p5;
+            m.nc_1p0  += mm[i].nc_1p0;
+            m.nc_2p5  += mm[i].nc_2p5;
+            m.nc_4p0  += mm[i].nc_4p0;
+            m.nc_10p0 += mm[i].nc_10p0;
+            m.typical_particle_size += mm[i].typical_particle_size;
+        }
+    }
+
+    if (valid_measurements == 0) {
+        m.typical_particle_size = -1;
+        return m; // return invalid measurement
+    }
+
+    m.mc_1p0  /= valid_measurements;
+    m.mc_2p5  /= valid_measurements;
+    m.mc_4p0  /= valid_measurements;
+    m.mc_10p0 /= valid_measurements;
+    m.nc_0p5  /= valid_measurements;
+    m.nc_1p0  /= valid_measurements;
+    m.nc_2p5  /= valid_measurements;
+    m.nc_4p0  /= valid_measurements;
+    m.nc_10p0 /= valid_measurements;
+    m.typical_particle_size /= valid_measurements;
+    return m;
+}
+
+/* measurements are read in the background, independent of the output */
+#define SAMPLE_INTERVAL_US 1000000
+/* no measurement for this long means the sensor is gone */
+#define SAMPLE_TIMEOUT_US (3 * SAMPLE_INTERVAL_US)
+
+static struct sps30_acq_sample ring[64];
+
+/* wall clock time in microseconds of a CLOCK_MONOTONIC time */
+static uint64_t wall_clock_us(uint64_t monotonic_us) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000 -
+           (sps30_timer_now_us() - monotonic_us);
+}
+
+/* retry delays while the sensor does not answer yet, e.g. during power up */
+#define PROBE_BACKOFF_MIN_US 10000
+#define PROBE_BACKOFF_MAX_US 1000000
+
+/**
+ * Wait for the UART to appear, e.g. when a USB serial adapter is plugged in,
+ * then probe the sensor with a growing backoff until it answers.
+ */
+void connect_sensor(void) {
+    uint32_t backoff_us = PROBE_BACKOFF_MIN_US;
+
+    for (;;) {
+        while (sensirion_uart_wait_device(PROBE_BACKOFF_MAX_US) != 0)
+            ; /* the device is not present, nothing to do */
+
+        if (sensirion_uart_open() != 0)
+            fprintf(stderr, "UART init failed\n");
+        else if (sps30_probe() == 0)
+            return;
+        else
+            fprintf(stderr, "SPS30 sensor probing failed\n");
+
+        sensirion_sleep_usec(backoff_us);
+        if (backoff_us < PROBE_BACKOFF_MAX_US)
+            backoff_us *= 2;
+    }
+}
+
+/* the sensor stopped answering, e.g. because it was unplugged */
+void reconnect_sensor(void) {
+    fprintf(stderr, "lost connection to the sensor, reconnecting\n");
+    sensirion_uart_close();
+    connect_sensor();
+}
+
+int main(int argc, const char* argv[]) {
+    char serial[SPS30_MAX_SERIAL_LEN];
+    const uint8_t AUTO_CLEAN_DAYS = 4;
+    int16_t ret;
+    const int NUM_SAMPLES = 60;
+    const int DEBUG = getenv("DEBUG") != NULL;
+    struct sps30_dev dev;
+    struct sps30_acq_config acq_config = {
+        SAMPLE_INTERVAL_US, SPS30_ACQ_DROP_OLDEST,
+        sizeof(ring) / sizeof(ring[0]), ring, NULL, NULL};
+
+    /* the acquisition thread talks to the sensor through its own device on
+     * the same UART, only while the main thread doesn't */
+    sps30_dev_init(&dev, &sensirion_uart_default_ops, NULL);
+
+    /* The main loop does not work without a sensor */
+    connect_sensor();
+    if (DEBUG) fprintf(stderr, "SPS30 sensor probing successful\n");
+
+    /* version and serial are read in a single round trip */
+    struct sps30_version_information version_information;
+    ret = sps30_read_device_info(serial, &version_information);
+    if (ret) {
+        fprintf(stderr, "error %d reading device information\n", ret);
+        version_information.firmware_major = 0;
+    } else if (DEBUG) {
+        fprintf(stderr, "FW: %u.%u HW: %u, SHDLC: %u.%u\n",
+           version_information.firmware_major,
+           version_information.firmware_minor,
+           version_information.hardware_revision,
+           version_information.shdlc_major,
+           version_information.shdlc_minor);
+        fprintf(stderr, "SPS30 Serial: %s\n", serial);
+    }
+
+    ret = sps30_set_fan_auto_cleaning_interval_days(AUTO_CLEAN_DAYS);
+    if (ret)
+        fprintf(stderr, "error %d setting the auto-clean interval\n", ret);
+
+    /* stdout to be line-buffered: we print measurement data to a pipe.
+     * This is strictly equivalent to: setvbuf(stdout, NULL, _IOLBF, 0) 
+     */
+    setlinebuf(stdout);
+
+    while (1) {
+        ret = sps30_start_measurement();
+        if (ret < 0) {
+            fprintf(stderr, "error starting measurement\n");
+            reconnect_sensor();
+            continue;
+        }
+
+        if (DEBUG) {
+	        fprintf(stderr, "measurements started\n");
+	        fprintf(stderr, "#"
+	                       "\tpm1.0"
+	                       "\tpm2.5"
+	                       "\tpm4.0"
+	                       "\tpm10.0"
+	                       "\tnc0.5"
+	                       "\tnc1.0"
+	                       "\tnc2.5"
+	                       "\tnc4.5"
+	                       "\tnc10.0"
+	                       "\ttps\n");        	
+        }
+
+        // collect a batch of measurements, then average them out
+        struct sps30_measurement batch[NUM_SAMPLES];
+        struct sps30_acq_sample samples[NUM_SAMPLES];
+        struct sps30_acquisition acq;
+        int reconnected = 0;
+        int n = 0;
+        uint32_t next_slot = 0;
+
+        if (sps30_acquisition_start(&acq, &dev, &acq_config) != 0) {
+            fprintf(stderr, "error starting the acquisition thread\n");
+            return 1;
+        }
+
+        while (n < NUM_SAMPLES) {
+            int count = sps30_acquisition_drain(&acq, &samples[n],
+                                                NUM_SAMPLES - n,
+                                                SAMPLE_TIMEOUT_US);
+            if (count == 0) {
+                fprintf(stderr, "no measurement for %us\n",
+                        SAMPLE_TIMEOUT_US / 1000000);
+                sps30_acquisition_stop(&acq);
+                if (sps30_probe() != 0) {
+                    /* start over as soon as the sensor is back */
+                    reconnect_sensor();
+                    reconnected = 1;
+                    break;
+                }
+                sps30_acquisition_start(&acq, &dev, &acq_config);
+                next_slot = 0;
+                continue;
+            }
+
+            for (int i = n; i < n + count; ++i) {
+                struct sps30_measurement* m = &samples[i].measurement;
+
+                /* the reads are on a fixed 1s grid, report the holes */
+                if (samples[i].slot != next_slot)
+                    fprintf(stderr, "%u measurement(s) missed\n",
+                            samples[i].slot - next_slot);
+                next_slot = samples[i].slot + 1;
+
+                if (SPS30_IS_ERR_STATE(samples[i].status)) {
+                    batch[i].typical_particle_size = -1;
+                    fprintf(stderr,
+                        "Chip state: %u - measurement #%d may not be accurate\n",
+                        SPS30_GET_ERR_STATE(samples[i].status), i);
+                    continue;
+                }
+                batch[i] = *m;
+                if (DEBUG)
+                    fprintf(stderr, "%d"
+                        "\t%0.2f"
+                        "\t%0.2f"
+                        "\t%0.2f"
+                        "\t%0.2f"
+                        "\t%0.2f"
+                        "\t%0.2f"
+                        "\t%0.2f"
+                        "\t%0.2f"
+                        "\t%0.2f"
+                        "\t%0.2f\n",
+                        i, m->mc_1p0, m->mc_2p5, m->mc_4p0, m->mc_10p0,
+                        m->nc_0p5, m->nc_1p0, m->nc_2p5, m->nc_4p0,
+                        m->nc_10p0, m->typical_particle_size);
+            }
+            n += count;
+        }
+
+        if (!reconnected)
+            sps30_acquisition_stop(&acq);
+        if (reconnected)
+            continue;
+
+        struct sps30_measurement m = average_measurements(batch, NUM_SAMPLES);
+        uint64_t t = wall_clock_us(samples[NUM_SAMPLES - 1].time_us);
+        if (m.typical_particle_size > 0) // valid measurement
+            printf("%llu.%06llu"
+                "\t%d"
+                "\t%d"
+                "\t%d"
+                "\t%d"
+                "\t%d"
+                "\t%d"
+                "\t%d"
+                "\t%d"
+                "\t%d"
+                "\t%d\n",
+                /* time the last measurement of the batch was received */
+                (unsigned long long)(t / 1000000),
+                (unsigned long long)(t % 1000000),
+                /* Round all measured values; fractional digits do not carry any valid information.
+                * See https://github.com/Sensirion/embedded-uart-sps/issues/77
+                */
+                _round(m.mc_1p0), _round(m.mc_2p5), _round(m.mc_4p0), _round(m.mc_10p0), _round(m.nc_0p5),
+                _round(m.nc_1p0), _round(m.nc_2p5), _round(m.nc_4p0), _round(m.nc_10p0),
+                _roundK(m.typical_particle_size));
+
+        /* Stop measurement for 1min to preserve power. Also enter sleep mode
+         * if the firmware version is >=2.0.
+         */
+        ret = sps30_stop_measurement();
+        if (ret) {
+            fprintf(stderr, "Stopping measurement failed\n");
+        }
+
+        if (version_information.firmware_major >= 2) {
+            ret = sps30_sleep();
+            if (ret) {
+                fprintf(stderr, "Entering sleep failed\n");
+            }
+        }
+
+        if (DEBUG) fprintf(stderr, "No measurements for 1 minute\n");
+        sensirion_sleep_usec(1000000 * 60);
+
+        if (version_information.firmware_major >= 2) {
+            ret = sps30_wake_up();
+            if (ret) {
+                fprintf(stderr, "Error %i waking up sensor\n", ret);
+            }
+        }
+    }
+
+    if (sensirion_uart_close() != 0)
+        fprintf(stderr, "failed to close UART\n");
+
+    return 0;
+}
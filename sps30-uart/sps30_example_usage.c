@@ -89,6 +89,41 @@ struct sps30_measurement average_measurements(const struct sps30_measurement mm[
     return m;
 }
 
+/* retry delays while the sensor does not answer yet, e.g. during power up */
+#define PROBE_BACKOFF_MIN_US 10000
+#define PROBE_BACKOFF_MAX_US 1000000
+
+/**
+ * Wait for the UART to appear, e.g. when a USB serial adapter is plugged in,
+ * then probe the sensor with a growing backoff until it answers.
+ */
+void connect_sensor(void) {
+    uint32_t backoff_us = PROBE_BACKOFF_MIN_US;
+
+    for (;;) {
+        while (sensirion_uart_wait_device(PROBE_BACKOFF_MAX_US) != 0)
+            ; /* the device is not present, nothing to do */
+
+        if (sensirion_uart_open() != 0)
+            fprintf(stderr, "UART init failed\n");
+        else if (sps30_probe() == 0)
+            return;
+        else
+            fprintf(stderr, "SPS30 sensor probing failed\n");
+
+        sensirion_sleep_usec(backoff_us);
+        if (backoff_us < PROBE_BACKOFF_MAX_US)
+            backoff_us *= 2;
+    }
+}
+
+/* the sensor stopped answering, e.g. because it was unplugged */
+void reconnect_sensor(void) {
+    fprintf(stderr, "lost connection to the sensor, reconnecting\n");
+    sensirion_uart_close();
+    connect_sensor();
+}
+
 int main(int argc, const char* argv[]) {
     char serial[SPS30_MAX_SERIAL_LEN];
     const uint8_t AUTO_CLEAN_DAYS = 4;
@@ -96,40 +131,26 @@ int main(int argc, const char* argv[]) {
     const int NUM_SAMPLES = 60;
     const int DEBUG = getenv("DEBUG") != NULL;
 
-    while (sensirion_uart_open() != 0) {
-        fprintf(stderr, "UART init failed\n");
-        sensirion_sleep_usec(1000000); /* sleep for 1s */
-    }
-
-    /* Busy loop for initialization, because the main loop does not work without
-     * a sensor.
-     */
-    while (sps30_probe() != 0) {
-        fprintf(stderr, "SPS30 sensor probing failed\n");
-        sensirion_sleep_usec(1000000); /* sleep for 1s */
-    }
+    /* The main loop does not work without a sensor */
+    connect_sensor();
     if (DEBUG) fprintf(stderr, "SPS30 sensor probing successful\n");
 
+    /* version and serial are read in a single round trip */
     struct sps30_version_information version_information;
-    ret = sps30_read_version(&version_information);
+    ret = sps30_read_device_info(serial, &version_information);
     if (ret) {
-        fprintf(stderr, "error %d reading version information\n", ret);
-    } else {
-        if (DEBUG)
-            fprintf(stderr, "FW: %u.%u HW: %u, SHDLC: %u.%u\n",
-               version_information.firmware_major,
-               version_information.firmware_minor,
-               version_information.hardware_revision,
-               version_information.shdlc_major,
-               version_information.shdlc_minor);
+        fprintf(stderr, "error %d reading device information\n", ret);
+        version_information.firmware_major = 0;
+    } else if (DEBUG) {
+        fprintf(stderr, "FW: %u.%u HW: %u, SHDLC: %u.%u\n",
+           version_information.firmware_major,
+           version_information.firmware_minor,
+           version_information.hardware_revision,
+           version_information.shdlc_major,
+           version_information.shdlc_minor);
+        fprintf(stderr, "SPS30 Serial: %s\n", serial);
     }
 
-    ret = sps30_get_serial(serial);
-    if (ret)
-        fprintf(stderr, "error %d reading serial\n", ret);
-    else
-        if (DEBUG) fprintf(stderr, "SPS30 Serial: %s\n", serial);
-
     ret = sps30_set_fan_auto_cleaning_interval_days(AUTO_CLEAN_DAYS);
     if (ret)
         fprintf(stderr, "error %d setting the auto-clean interval\n", ret);
@@ -143,8 +164,8 @@ int main(int argc, const char* argv[]) {
         ret = sps30_start_measurement();
         if (ret < 0) {
             fprintf(stderr, "error starting measurement\n");
-            sensirion_sleep_usec(1000000); /* sleep for 1s */
-            break;
+            reconnect_sensor();
+            continue;
         }
 
         if (DEBUG) {
@@ -164,6 +185,7 @@ int main(int argc, const char* argv[]) {
 
         // collect a batch of measurements, then average them out
         struct sps30_measurement batch[NUM_SAMPLES];
+        int reconnected = 0;
 
         for (int i = 0; i < NUM_SAMPLES; ++i) {
             sensirion_sleep_usec(1000000); /* sleep for 1s */
@@ -174,6 +196,12 @@ int main(int argc, const char* argv[]) {
             if (ret < 0) {
                 batch[i].typical_particle_size = -1;
                 fprintf(stderr, "error reading measurement #%d\n", i);
+                if (sps30_probe() != 0) {
+                    /* start over as soon as the sensor is back */
+                    reconnect_sensor();
+                    reconnected = 1;
+                    break;
+                }
             } else if (SPS30_IS_ERR_STATE(ret)) {
                 batch[i].typical_particle_size = -1;
                 fprintf(stderr,
@@ -199,6 +227,9 @@ int main(int argc, const char* argv[]) {
             }
         }
 
+        if (reconnected)
+            continue;
+
         struct sps30_measurement m = average_measurements(batch, NUM_SAMPLES);
         if (m.typical_particle_size > 0) // valid measurement
             printf("%ld" 
@@ -0,0 +1,27 @@
+/* THIS FILE IS AUTOGENERATED from sps30_frames.hpp, run `make frames` */
+#include "sps30_frames.h"
+
+const struct sps30_frame sps30_frames[SPS30_FRAME_COUNT] = {
+    /* SPS30_FRAME_START_MEASUREMENT */
+    {0x00, 8, {0x7e, 0x00, 0x00, 0x02, 0x01, 0x03, 0xf9, 0x7e}},
+    /* SPS30_FRAME_START_MEASUREMENT_UINT16 */
+    {0x00, 8, {0x7e, 0x00, 0x00, 0x02, 0x01, 0x05, 0xf7, 0x7e}},
+    /* SPS30_FRAME_STOP_MEASUREMENT */
+    {0x01, 6, {0x7e, 0x00, 0x01, 0x00, 0xfe, 0x7e}},
+    /* SPS30_FRAME_READ_MEASUREMENT */
+    {0x03, 6, {0x7e, 0x00, 0x03, 0x00, 0xfc, 0x7e}},
+    /* SPS30_FRAME_SLEEP */
+    {0x10, 6, {0x7e, 0x00, 0x10, 0x00, 0xef, 0x7e}},
+    /* SPS30_FRAME_WAKE_UP */
+    {0x11, 7, {0x7e, 0x00, 0x7d, 0x31, 0x00, 0xee, 0x7e}},
+    /* SPS30_FRAME_GET_FAN_CLEAN_INTV */
+    {0x80, 8, {0x7e, 0x00, 0x80, 0x01, 0x00, 0x7d, 0x5e, 0x7e}},
+    /* SPS30_FRAME_START_FAN_CLEANING */
+    {0x56, 6, {0x7e, 0x00, 0x56, 0x00, 0xa9, 0x7e}},
+    /* SPS30_FRAME_GET_SERIAL */
+    {0xd0, 7, {0x7e, 0x00, 0xd0, 0x01, 0x03, 0x2b, 0x7e}},
+    /* SPS30_FRAME_READ_VERSION */
+    {0xd1, 6, {0x7e, 0x00, 0xd1, 0x00, 0x2e, 0x7e}},
+    /* SPS30_FRAME_RESET */
+    {0xd3, 6, {0x7e, 0x00, 0xd3, 0x00, 0x2c, 0x7e}},
+};
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SPS30_FRAMES_H
+#define SPS30_FRAMES_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "sensirion_arch_config.h"
+
+/**
+ * Precomputed SHDLC frames of the SPS30 commands with constant data.
+ *
+ * The frames in sps30_frames.c are generated from sps30_frames.hpp at compile
+ * time, run `make frames` in sps30-uart/ to update them.
+ */
+
+/** fits frames with up to two data bytes, all stuffed */
+#define SPS30_FRAME_MAX_LEN 14
+
+enum sps30_frame_id {
+    SPS30_FRAME_START_MEASUREMENT,
+    SPS30_FRAME_START_MEASUREMENT_UINT16,
+    SPS30_FRAME_STOP_MEASUREMENT,
+    SPS30_FRAME_READ_MEASUREMENT,
+    SPS30_FRAME_SLEEP,
+    SPS30_FRAME_WAKE_UP,
+    SPS30_FRAME_GET_FAN_CLEAN_INTV,
+    SPS30_FRAME_START_FAN_CLEANING,
+    SPS30_FRAME_GET_SERIAL,
+    SPS30_FRAME_READ_VERSION,
+    SPS30_FRAME_RESET,
+    SPS30_FRAME_COUNT
+};
+
+struct sps30_frame {
+    uint8_t cmd;
+    uint8_t len;
+    uint8_t bytes[SPS30_FRAME_MAX_LEN];
+};
+
+extern const struct sps30_frame sps30_frames[SPS30_FRAME_COUNT];
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPS30_FRAMES_H */
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * SHDLC frames of the SPS30 commands with constant data, encoded at compile
+ * time. Requires C++14.
+ */
+
+#ifndef SPS30_FRAMES_HPP
+#define SPS30_FRAMES_HPP
+
+#include "sensirion_shdlc_frame.hpp"
+
+namespace sps30 {
+namespace frames {
+
+using sensirion::shdlc::frame;
+
+constexpr uint8_t addr = 0x00;
+
+/* 0x03: Big-endian IEEE754 float values */
+constexpr auto start_measurement = frame(addr, 0x00, 0x01, 0x03);
+/* 0x05: Big-endian unsigned 16-bit integer values */
+constexpr auto start_measurement_uint16 = frame(addr, 0x00, 0x01, 0x05);
+constexpr auto stop_measurement = frame(addr, 0x01);
+constexpr auto read_measurement = frame(addr, 0x03);
+constexpr auto sleep = frame(addr, 0x10);
+constexpr auto wake_up = frame(addr, 0x11);
+constexpr auto get_fan_clean_interval = frame(addr, 0x80, 0x00);
+constexpr auto start_fan_cleaning = frame(addr, 0x56);
+constexpr auto get_serial = frame(addr, 0xd0, 0x03);
+constexpr auto read_version = frame(addr, 0xd1);
+constexpr auto reset = frame(addr, 0xd3);
+
+}  // namespace frames
+}  // namespace sps30
+
+#endif /* SPS30_FRAMES_HPP */
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Generates the C table of precomputed frames in sps30_frames.c from the
+ * constexpr frames in sps30_frames.hpp, see `make frames`.
+ */
+
+#include "sps30_frames.h"
+#include "sps30_frames.hpp"
+#include <stdio.h>
+
+struct entry {
+    const char* id;
+    uint8_t cmd;
+    uint16_t len;
+    const uint8_t* bytes;
+};
+
+template <size_t MaxLen>
+static entry make_entry(const char* id,
+                        const sensirion::shdlc::Frame<MaxLen>& frame) {
+    static_assert(MaxLen <= SPS30_FRAME_MAX_LEN,
+                  "frame exceeds SPS30_FRAME_MAX_LEN");
+    return {id, frame.cmd, frame.len, frame.bytes};
+}
+
+#define ENTRY(id, frame) table[id] = make_entry(#id, sps30::frames::frame)
+
+int main(void) {
+    entry table[SPS30_FRAME_COUNT] = {};
+    int i;
+    int j;
+
+    ENTRY(SPS30_FRAME_START_MEASUREMENT, start_measurement);
+    ENTRY(SPS30_FRAME_START_MEASUREMENT_UINT16, start_measurement_uint16);
+    ENTRY(SPS30_FRAME_STOP_MEASUREMENT, stop_measurement);
+    ENTRY(SPS30_FRAME_READ_MEASUREMENT, read_measurement);
+    ENTRY(SPS30_FRAME_SLEEP, sleep);
+    ENTRY(SPS30_FRAME_WAKE_UP, wake_up);
+    ENTRY(SPS30_FRAME_GET_FAN_CLEAN_INTV, get_fan_clean_interval);
+    ENTRY(SPS30_FRAME_START_FAN_CLEANING, start_fan_cleaning);
+    ENTRY(SPS30_FRAME_GET_SERIAL, get_serial);
+    ENTRY(SPS30_FRAME_READ_VERSION, read_version);
+    ENTRY(SPS30_FRAME_RESET, reset);
+
+    printf("/* THIS FILE IS AUTOGENERATED from sps30_frames.hpp, run `make "
+           "frames` */\n");
+    printf("#include \"sps30_frames.h\"\n\n");
+    printf("const struct sps30_frame sps30_frames[SPS30_FRAME_COUNT] = {\n");
+    for (i = 0; i < SPS30_FRAME_COUNT; ++i) {
+        if (!table[i].id) {
+            fprintf(stderr, "No frame for sps30_frame_id %d\n", i);
+            return 1;
+        }
+        printf("    /* %s */\n", table[i].id);
+        printf("    {0x%02x, %u, {", table[i].cmd, table[i].len);
+        for (j = 0; j < table[i].len; ++j)
+            printf(j ? ", 0x%02x" : "0x%02x", table[i].bytes[j]);
+        printf("}},\n");
+    }
+    printf("};\n");
+    return 0;
+}
@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE /* pthread_setaffinity_np() */
+#endif
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sps30_scheduler.h"
+
+enum sps30_sched_state {
+    SPS30_SCHED_WAKE_UP,
+    SPS30_SCHED_START,
+    SPS30_SCHED_READ,
+    SPS30_SCHED_STOP,
+    SPS30_SCHED_SLEEP,
+    SPS30_SCHED_IDLE,
+};
+
+static uint8_t
+sps30_sched_first_state(const struct sps30_sched_config* config) {
+    return config->use_sleep ? SPS30_SCHED_WAKE_UP : SPS30_SCHED_START;
+}
+
+/* send the sensor's current command and advance its state on success */
+static int16_t sps30_sched_step(const struct sps30_sched_config* config,
+                                struct sps30_sched_sensor* sensor) {
+    int16_t ret;
+
+    switch (sensor->state) {
+        case SPS30_SCHED_WAKE_UP:
+            ret = sps30_wake_up_dev(sensor->dev);
+            if (!ret)
+                sensor->state = SPS30_SCHED_START;
+            return ret;
+
+        case SPS30_SCHED_START:
+            ret = sps30_start_measurement_dev(sensor->dev);
+            if (!ret) {
+                sensor->state = SPS30_SCHED_READ;
+                sensor->count = 0;
+            }
+            return ret;
+
+        case SPS30_SCHED_READ:
+            ret = sps30_read_measurement_dev(sensor->dev, &sensor->measurement);
+            if (ret == SPS30_ERR_NOT_ENOUGH_DATA)
+                return 0; /* no new measurement yet */
+            if (ret)
+                return ret;
+            sensor->measurement_valid = 1;
+            if (config->samples && ++sensor->count >= config->samples)
+                sensor->state = SPS30_SCHED_STOP;
+            return 0;
+
+        case SPS30_SCHED_STOP:
+            ret = sps30_stop_measurement_dev(sensor->dev);
+            if (!ret) {
+                sensor->state =
+                    config->use_sleep ? SPS30_SCHED_SLEEP : SPS30_SCHED_IDLE;
+                sensor->count = 0;
+            }
+            return ret;
+
+        case SPS30_SCHED_SLEEP:
+            ret = sps30_sleep_dev(sensor->dev);
+            if (!ret)
+                sensor->state = SPS30_SCHED_IDLE;
+            return ret;
+
+        default:
+            if (++sensor->count >= config->idle_cycles)
+                sensor->state = sps30_sched_first_state(config);
+            return 0;
+    }
+}
+
+static void sps30_sched_run_sensor(const struct sps30_sched_config* config,
+                                   struct sps30_sched_sensor* sensor) {
+    uint8_t tries = 0;
+
+    sensor->measurement_valid = 0;
+    do {
+        sensor->status = sps30_sched_step(config, sensor);
+    } while (sensor->status && tries++ < config->max_retries);
+}
+
+/* take a sensor of the given cycle from the head of the own shard or the tail
+ * of another one, return its index or -1 when all shards are empty */
+static int32_t sps30_sched_take(struct sps30_scheduler* sched, uint8_t worker,
+                                uint32_t cycle) {
+    struct sps30_sched_worker* shard;
+    int32_t sensor = -1;
+    uint8_t i;
+
+    for (i = 0; i < sched->worker_count && sensor < 0; ++i) {
+        shard = &sched->workers[(worker + i) % sched->worker_count];
+        pthread_mutex_lock(&shard->lock);
+        if (shard->cycle == cycle && shard->head != shard->tail) {
+            if (i == 0)
+                sensor = shard->sensors[shard->head++];
+            else
+                sensor = shard->sensors[--shard->tail];
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+    if (sensor >= 0 && i > 1)
+        __atomic_fetch_add(&sched->steals, 1, __ATOMIC_RELAXED);
+    return sensor;
+}
+
+static void* sps30_sched_worker(void* arg) {
+    struct sps30_sched_worker* self = (struct sps30_sched_worker*)arg;
+    struct sps30_scheduler* sched = self->sched;
+    uint8_t worker = (uint8_t)(self - sched->workers);
+    struct sps30_sched_sensor* sensor;
+    uint32_t cycle = 0;
+    uint16_t done;
+    uint16_t failed;
+    int32_t i;
+
+    for (;;) {
+        pthread_mutex_lock(&sched->lock);
+        while (!sched->stop && sched->cycle == cycle)
+            pthread_cond_wait(&sched->cycle_cond, &sched->lock);
+        if (sched->stop) {
+            pthread_mutex_unlock(&sched->lock);
+            return NULL;
+        }
+        cycle = sched->cycle;
+        pthread_mutex_unlock(&sched->lock);
+
+        done = 0;
+        failed = 0;
+        while ((i = sps30_sched_take(sched, worker, cycle)) >= 0) {
+            sensor = &sched->sensors[i];
+            sps30_sched_run_sensor(&sched->config, sensor);
+            ++done;
+            if (sensor->status)
+                ++failed;
+        }
+
+        pthread_mutex_lock(&sched->lock);
+        sched->remaining -= done;
+        sched->failed += failed;
+        if (!sched->remaining)
+            pthread_cond_signal(&sched->done_cond);
+        pthread_mutex_unlock(&sched->lock);
+    }
+}
+
+static void sps30_sched_pin(pthread_t thread, uint8_t worker) {
+#ifdef __linux__
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t cpus;
+
+    if (cores < 1)
+        return;
+    CPU_ZERO(&cpus);
+    CPU_SET((size_t)(worker % cores), &cpus);
+    /* pinning is an optimization only, keep running unpinned if it fails */
+    pthread_setaffinity_np(thread, sizeof(cpus), &cpus);
+#endif
+}
+
+static void sps30_sched_stop_workers(struct sps30_scheduler* sched,
+                                     uint8_t count) {
+    uint8_t i;
+
+    pthread_mutex_lock(&sched->lock);
+    sched->stop = 1;
+    pthread_cond_broadcast(&sched->cycle_cond);
+    pthread_mutex_unlock(&sched->lock);
+
+    for (i = 0; i < count; ++i)
+        pthread_join(sched->workers[i].thread, NULL);
+}
+
+/* destroy the locks of the first lock_count workers and of the scheduler */
+static void sps30_sched_destroy_locks(struct sps30_scheduler* sched,
+                                      uint8_t lock_count) {
+    uint8_t i;
+
+    for (i = 0; i < lock_count; ++i)
+        pthread_mutex_destroy(&sched->workers[i].lock);
+    pthread_cond_destroy(&sched->done_cond);
+    pthread_cond_destroy(&sched->cycle_cond);
+    pthread_mutex_destroy(&sched->lock);
+}
+
+int16_t sps30_scheduler_init(struct sps30_scheduler* sched,
+                             const struct sps30_sched_config* config,
+                             uint8_t worker_count, uint16_t sensor_count,
+                             struct sps30_sched_sensor* sensors) {
+    uint16_t i;
+    uint8_t w;
+
+    if (!worker_count || worker_count > SPS30_SCHED_MAX_WORKERS ||
+        sensor_count > SPS30_SCHED_MAX_SENSORS)
+        return -1;
+
+    memset(sched, 0, sizeof(*sched));
+    sched->config = *config;
+    sched->sensor_count = sensor_count;
+    sched->sensors = sensors;
+    sched->worker_count = worker_count;
+    pthread_mutex_init(&sched->lock, NULL);
+    pthread_cond_init(&sched->cycle_cond, NULL);
+    pthread_cond_init(&sched->done_cond, NULL);
+
+    for (i = 0; i < sensor_count; ++i) {
+        sensors[i].measurement_valid = 0;
+        sensors[i].status = 0;
+        sensors[i].state = sps30_sched_first_state(config);
+        sensors[i].count = 0;
+    }
+
+    for (w = 0; w < worker_count; ++w) {
+        sched->workers[w].sched = sched;
+        pthread_mutex_init(&sched->workers[w].lock, NULL);
+        if (pthread_create(&sched->workers[w].thread, NULL, sps30_sched_worker,
+                           &sched->workers[w])) {
+            /* join the workers started so far */
+            sps30_sched_stop_workers(sched, w);
+            sps30_sched_destroy_locks(sched, w + 1);
+            return -1;
+        }
+        sps30_sched_pin(sched->workers[w].thread, w);
+    }
+    return 0;
+}
+
+uint16_t sps30_scheduler_run_cycle(struct sps30_scheduler* sched) {
+    struct sps30_sched_worker* shard;
+    uint16_t failed;
+    uint16_t i;
+    uint8_t w;
+
+    for (w = 0; w < sched->worker_count; ++w) {
+        shard = &sched->workers[w];
+        pthread_mutex_lock(&shard->lock);
+        shard->cycle = sched->cycle + 1;
+        shard->head = 0;
+        shard->tail = 0;
+        for (i = w; i < sched->sensor_count; i += sched->worker_count)
+            shard->sensors[shard->tail++] = i;
+        pthread_mutex_unlock(&shard->lock);
+    }
+
+    pthread_mutex_lock(&sched->lock);
+    sched->remaining = sched->sensor_count;
+    sched->failed = 0;
+    ++sched->cycle;
+    pthread_cond_broadcast(&sched->cycle_cond);
+    while (sched->remaining)
+        pthread_cond_wait(&sched->done_cond, &sched->lock);
+    failed = sched->failed;
+    pthread_mutex_unlock(&sched->lock);
+
+    return failed;
+}
+
+void sps30_scheduler_destroy(struct sps30_scheduler* sched) {
+    sps30_sched_stop_workers(sched, sched->worker_count);
+    sps30_sched_destroy_locks(sched, sched->worker_count);
+}
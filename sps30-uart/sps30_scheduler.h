@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SPS30_SCHEDULER_H
+#define SPS30_SCHEDULER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <pthread.h>
+
+#include "sensirion_arch_config.h"
+#include "sps30.h"
+
+#define SPS30_SCHED_MAX_WORKERS 16
+#define SPS30_SCHED_MAX_SENSORS 256
+
+/**
+ * Acquisition scheduler for POSIX systems: runs the measurement cycle of many
+ * sensors on a pool of worker threads pinned to CPU cores.
+ *
+ * Each sensor goes through wake up, start measurement, a number of reads,
+ * stop measurement, sleep and a number of idle cycles, one command per call
+ * of sps30_scheduler_run_cycle(). The sensors are split into one shard per
+ * worker and a worker which has finished its own shard takes the pending
+ * sensors of the other shards, so a slow or retrying sensor only delays its
+ * own command.
+ */
+
+/**
+ * struct sps30_sched_config - measurement cycle of the scheduled sensors
+ *
+ * @samples:        Number of measurements read before the measurement is
+ *                  stopped, 0 to measure continuously
+ * @idle_cycles:    Number of cycles between stopping and restarting the
+ *                  measurement
+ * @use_sleep:      Send the sensors to sleep while idle (firmware >= 2.0)
+ * @max_retries:    Number of times a failed command is repeated within the
+ *                  same cycle
+ */
+struct sps30_sched_config {
+    uint16_t samples;
+    uint16_t idle_cycles;
+    uint8_t use_sleep;
+    uint8_t max_retries;
+};
+
+/**
+ * struct sps30_sched_sensor - a scheduled sensor and its latest result
+ *
+ * Set dev before sps30_scheduler_init(), the other fields are updated by the
+ * scheduler and may only be read between calls of
+ * sps30_scheduler_run_cycle().
+ *
+ * @dev:                Initialized device, see sps30_dev_init()
+ * @measurement:        Latest measurement
+ * @measurement_valid:  1 if a measurement was read in the last cycle
+ * @status:             Result of the last command, 0 on success
+ */
+struct sps30_sched_sensor {
+    struct sps30_dev* dev;
+    struct sps30_measurement measurement;
+    uint8_t measurement_valid;
+    int16_t status;
+
+    uint8_t state;
+    uint16_t count;
+};
+
+/* a worker thread and its shard of sensors */
+struct sps30_sched_worker {
+    struct sps30_scheduler* sched;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    uint32_t cycle;
+    uint16_t head;
+    uint16_t tail;
+    uint16_t sensors[SPS30_SCHED_MAX_SENSORS];
+};
+
+/**
+ * struct sps30_scheduler - the scheduler, all fields are private except for
+ * the statistics
+ *
+ * @steals:     Number of sensors handled by a worker other than the one of
+ *              their shard since the scheduler was initialized
+ */
+struct sps30_scheduler {
+    struct sps30_sched_config config;
+    uint16_t sensor_count;
+    struct sps30_sched_sensor* sensors;
+    uint8_t worker_count;
+    struct sps30_sched_worker workers[SPS30_SCHED_MAX_WORKERS];
+
+    pthread_mutex_t lock;
+    pthread_cond_t cycle_cond;
+    pthread_cond_t done_cond;
+    uint32_t cycle;
+    uint16_t remaining;
+    uint16_t failed;
+    uint8_t stop;
+
+    uint32_t steals;
+};
+
+/**
+ * sps30_scheduler_init() - start the worker threads
+ *
+ * Worker i is pinned to CPU core i modulo the number of online cores and
+ * sensor i is assigned to the shard of worker i modulo worker_count.
+ *
+ * @sched:          Scheduler to initialize
+ * @config:         Measurement cycle, copied
+ * @worker_count:   Number of worker threads, 1 to SPS30_SCHED_MAX_WORKERS
+ * @sensor_count:   Number of sensors, at most SPS30_SCHED_MAX_SENSORS
+ * @sensors:        Sensors, must stay valid until the scheduler is destroyed
+ * Return:          0 on success, -1 on invalid arguments or when the threads
+ *                  could not be started
+ */
+int16_t sps30_scheduler_init(struct sps30_scheduler* sched,
+                             const struct sps30_sched_config* config,
+                             uint8_t worker_count, uint16_t sensor_count,
+                             struct sps30_sched_sensor* sensors);
+
+/**
+ * sps30_scheduler_run_cycle() - run the next command of all sensors
+ *
+ * Returns when all sensors have completed their command. Call it once per
+ * measurement interval, i.e. every second.
+ *
+ * @sched:  Initialized scheduler
+ * Return:  Number of sensors whose command failed
+ */
+uint16_t sps30_scheduler_run_cycle(struct sps30_scheduler* sched);
+
+/**
+ * sps30_scheduler_destroy() - stop the worker threads
+ *
+ * The sensors are left in their current state.
+ */
+void sps30_scheduler_destroy(struct sps30_scheduler* sched);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPS30_SCHEDULER_H */
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <time.h>
+
+#include <unistd.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#elif defined(_POSIX_CLOCK_SELECTION) && _POSIX_CLOCK_SELECTION > 0
+/* pthread_condattr_setclock() is part of clock selection */
+#include <pthread.h>
+#else
+#error "sps30_timer.c needs Linux or POSIX clock selection, macOS has neither"
+#endif
+
+#include "sps30_timer.h"
+
+static void sps30_timer_timespec(uint64_t time_us, struct timespec* ts) {
+    ts->tv_sec = (time_t)(time_us / 1000000);
+    ts->tv_nsec = (long)(time_us % 1000000) * 1000;
+}
+
+uint64_t sps30_timer_now_us(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + (uint64_t)ts.tv_nsec / 1000;
+}
+
+uint64_t sps30_timer_slot_us(const struct sps30_timer* timer, uint32_t slot) {
+    return timer->start_us + (uint64_t)slot * timer->interval_us;
+}
+
+/* return the latest of the due slots and count the others as skipped */
+static uint32_t sps30_timer_take(struct sps30_timer* timer, uint64_t due) {
+    uint64_t slot = timer->next_slot + due - 1;
+
+    if (due > 1)
+        __atomic_fetch_add(&timer->skipped, (uint32_t)(due - 1),
+                           __ATOMIC_RELAXED);
+    timer->next_slot = slot + 1;
+    return (uint32_t)slot;
+}
+
+#ifdef __linux__
+
+int16_t sps30_timer_init(struct sps30_timer* timer, uint32_t interval_us,
+                         uint64_t start_us) {
+    struct itimerspec its;
+
+    if (!interval_us)
+        return -1;
+
+    timer->start_us = start_us;
+    timer->interval_us = interval_us;
+    timer->next_slot = 0;
+    timer->skipped = 0;
+
+    timer->timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (timer->timer_fd < 0)
+        return -1;
+    timer->cancel_fd = eventfd(0, EFD_CLOEXEC);
+    if (timer->cancel_fd < 0)
+        goto err_timer;
+
+    /* the kernel counts the expirations of the absolute deadlines, a start
+     * in the past expires at once and reports the slots since then, only 0
+     * would disarm the timer */
+    sps30_timer_timespec(start_us ? start_us : 1, &its.it_value);
+    sps30_timer_timespec(interval_us, &its.it_interval);
+    if (timerfd_settime(timer->timer_fd, TFD_TIMER_ABSTIME, &its, NULL))
+        goto err_cancel;
+    return 0;
+
+err_cancel:
+    close(timer->cancel_fd);
+err_timer:
+    close(timer->timer_fd);
+    return -1;
+}
+
+int16_t sps30_timer_wait(struct sps30_timer* timer, uint32_t* slot) {
+    struct pollfd fds[2];
+    uint64_t due;
+
+    fds[0].fd = timer->timer_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = timer->cancel_fd;
+    fds[1].events = POLLIN;
+
+    for (;;) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        /* the cancel event is never read, it stays pending */
+        if (fds[1].revents)
+            return -1;
+        if (read(timer->timer_fd, &due, sizeof(due)) == sizeof(due))
+            break;
+        if (errno != EAGAIN && errno != EINTR)
+            return -1;
+    }
+
+    *slot = sps30_timer_take(timer, due);
+    return 0;
+}
+
+void sps30_timer_cancel(struct sps30_timer* timer) {
+    uint64_t one = 1;
+
+    if (write(timer->cancel_fd, &one, sizeof(one)) != sizeof(one))
+        return;
+}
+
+void sps30_timer_destroy(struct sps30_timer* timer) {
+    close(timer->cancel_fd);
+    close(timer->timer_fd);
+}
+
+#else /* __linux__ */
+
+int16_t sps30_timer_init(struct sps30_timer* timer, uint32_t interval_us,
+                         uint64_t start_us) {
+    pthread_condattr_t attr;
+
+    if (!interval_us)
+        return -1;
+
+    timer->start_us = start_us;
+    timer->interval_us = interval_us;
+    timer->next_slot = 0;
+    timer->skipped = 0;
+    timer->cancelled = 0;
+
+    pthread_mutex_init(&timer->lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&timer->cond, &attr);
+    pthread_condattr_destroy(&attr);
+    return 0;
+}
+
+int16_t sps30_timer_wait(struct sps30_timer* timer, uint32_t* slot) {
+    uint64_t deadline =
+        timer->start_us + timer->next_slot * timer->interval_us;
+    struct timespec ts;
+    uint64_t now;
+    uint8_t cancelled;
+
+    sps30_timer_timespec(deadline, &ts);
+    pthread_mutex_lock(&timer->lock);
+    while (!timer->cancelled &&
+           pthread_cond_timedwait(&timer->cond, &timer->lock, &ts) !=
+               ETIMEDOUT)
+        ;
+    cancelled = timer->cancelled;
+    pthread_mutex_unlock(&timer->lock);
+    if (cancelled)
+        return -1;
+
+    now = sps30_timer_now_us();
+    if (now < deadline)
+        now = deadline;
+    *slot = sps30_timer_take(
+        timer, (now - timer->start_us) / timer->interval_us + 1 -
+                   timer->next_slot);
+    return 0;
+}
+
+void sps30_timer_cancel(struct sps30_timer* timer) {
+    pthread_mutex_lock(&timer->lock);
+    timer->cancelled = 1;
+    pthread_cond_broadcast(&timer->cond);
+    pthread_mutex_unlock(&timer->lock);
+}
+
+void sps30_timer_destroy(struct sps30_timer* timer) {
+    pthread_cond_destroy(&timer->cond);
+    pthread_mutex_destroy(&timer->lock);
+}
+
+#endif /* __linux__ */
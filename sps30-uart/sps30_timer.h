@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2021, Sensirion AG
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ *   this list of conditions and the following disclaimer in the documentation
+ *   and/or other materials provided with the distribution.
+ *
+ * * Neither the name of Sensirion AG nor the names of its
+ *   contributors may be used to endorse or promote products derived from
+ *   this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SPS30_TIMER_H
+#define SPS30_TIMER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef __linux__
+#include <pthread.h>
+#endif
+
+#include "sensirion_arch_config.h"
+
+/**
+ * Periodic timer on absolute CLOCK_MONOTONIC deadlines: slot n is due at
+ * start_us + n * interval_us, no matter how long the work between two waits
+ * takes, so a sampling loop does not drift. A timerfd on Linux, a condition
+ * variable on CLOCK_MONOTONIC on other systems with POSIX clock selection.
+ * macOS lacks the latter and is not supported.
+ *
+ * Slots which passed while the caller was busy are not caught up: the wait
+ * returns the latest due slot and counts the ones in between as skipped, so
+ * the gaps in the slot numbers are exactly the missed samples.
+ */
+
+/**
+ * struct sps30_timer - the timer, all fields are private except for the
+ * statistics
+ *
+ * @start_us:       CLOCK_MONOTONIC time of slot 0
+ * @interval_us:    Time between two slots
+ * @skipped:        Number of slots which passed without a wait returning them
+ */
+struct sps30_timer {
+    uint64_t start_us;
+    uint32_t interval_us;
+    uint64_t next_slot;
+#ifdef __linux__
+    int timer_fd;
+    int cancel_fd;
+#else
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    uint8_t cancelled;
+#endif
+
+    uint32_t skipped;
+};
+
+/**
+ * sps30_timer_now_us() - current CLOCK_MONOTONIC time in microseconds
+ */
+uint64_t sps30_timer_now_us(void);
+
+/**
+ * sps30_timer_init() - start a periodic timer
+ *
+ * @timer:          Timer to initialize
+ * @interval_us:    Time between two slots, greater than 0
+ * @start_us:       CLOCK_MONOTONIC time of slot 0, e.g.
+ *                  sps30_timer_now_us() + interval_us
+ * Return:          0 on success, -1 on invalid arguments or when the timer
+ *                  could not be created
+ */
+int16_t sps30_timer_init(struct sps30_timer* timer, uint32_t interval_us,
+                         uint64_t start_us);
+
+/**
+ * sps30_timer_wait() - wait for the next slot
+ *
+ * Returns immediately if a slot is already due.
+ *
+ * @timer:  Initialized timer
+ * @slot:   Receives the number of the latest due slot
+ * Return:  0 when a slot is due, -1 when the timer was cancelled
+ */
+int16_t sps30_timer_wait(struct sps30_timer* timer, uint32_t* slot);
+
+/**
+ * sps30_timer_slot_us() - CLOCK_MONOTONIC time a slot is due
+ */
+uint64_t sps30_timer_slot_us(const struct sps30_timer* timer, uint32_t slot);
+
+/**
+ * sps30_timer_cancel() - make the current and all further waits return -1
+ *
+ * May be called from any thread.
+ */
+void sps30_timer_cancel(struct sps30_timer* timer);
+
+/**
+ * sps30_timer_destroy() - release the timer, no wait may be in progress
+ */
+void sps30_timer_destroy(struct sps30_timer* timer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPS30_TIMER_H */
@@ -0,0 +1,421 @@
+/*
+ * Microbenchmarks of the SHDLC framing, run with `make bench`
+ */
+#include "sensirion_shdlc.h"
+#include "sensirion_uart.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_ITERATIONS 100000
+#define BENCH_RUNS 7
+
+extern "C" {
+
+int16_t sensirion_uart_select_port(uint8_t port) {
+    return 0;
+}
+
+int16_t sensirion_uart_open() {
+    return 0;
+}
+
+int16_t sensirion_uart_close() {
+    return 0;
+}
+
+int16_t sensirion_uart_tx(uint16_t data_len, const uint8_t* data) {
+    return (int16_t)data_len;
+}
+
+int16_t sensirion_uart_txv(uint8_t iovcnt,
+                           const struct sensirion_uart_iovec* iov) {
+    uint16_t len = 0;
+
+    while (iovcnt--)
+        len += (iov++)->len;
+    return (int16_t)len;
+}
+
+/* received bytes are served from memory */
+static const uint8_t* rx_bytes;
+static uint16_t rx_len;
+static uint16_t rx_pos;
+
+int16_t sensirion_uart_rx(uint16_t max_data_len, uint8_t* data) {
+    uint16_t len = rx_len - rx_pos;
+
+    if (len > max_data_len)
+        len = max_data_len;
+    memcpy(data, &rx_bytes[rx_pos], len);
+    rx_pos += len;
+    return (int16_t)len;
+}
+
+int16_t sensirion_uart_rx_timeout(uint16_t max_data_len, uint8_t* data,
+                                  uint32_t timeout_us) {
+    return sensirion_uart_rx(max_data_len, data);
+}
+
+void sensirion_sleep_usec(uint32_t useconds) {
+}
+
+}  // extern "C"
+
+static volatile uint32_t sink;
+
+/* The encoder before the single-pass rewrite: checksum pass, then each part
+ * of the frame is stuffed separately with a per-byte switch */
+static uint8_t baseline_crc(uint8_t header_sum, uint8_t data_len,
+                            const uint8_t* data) {
+    header_sum += data_len;
+
+    while (data_len--)
+        header_sum += *(data++);
+
+    return ~header_sum;
+}
+
+static uint16_t baseline_stuff_data(uint8_t data_len, const uint8_t* data,
+                                    uint8_t* stuffed_data) {
+    uint16_t output_data_len = 0;
+    uint8_t c;
+
+    while (data_len--) {
+        c = *(data++);
+        switch (c) {
+            case 0x11:
+            case 0x13:
+            case 0x7d:
+            case 0x7e:
+                *(stuffed_data++) = 0x7d;
+                *(stuffed_data++) = c ^ (1 << 5);
+                output_data_len += 2;
+                break;
+            default:
+                *(stuffed_data++) = c;
+                output_data_len += 1;
+        }
+    }
+    return output_data_len;
+}
+
+static uint16_t baseline_encode(uint8_t addr, uint8_t cmd, uint8_t data_len,
+                                const uint8_t* data, uint8_t* frame) {
+    uint16_t len = 0;
+    uint8_t crc;
+
+    crc = baseline_crc(addr + cmd, data_len, data);
+
+    frame[len++] = 0x7e;
+    len += baseline_stuff_data(1, &addr, frame + len);
+    len += baseline_stuff_data(1, &cmd, frame + len);
+    len += baseline_stuff_data(1, &data_len, frame + len);
+    len += baseline_stuff_data(data_len, data, frame + len);
+    len += baseline_stuff_data(1, &crc, frame + len);
+    frame[len++] = 0x7e;
+    return len;
+}
+
+typedef uint16_t (*encode_fn)(uint8_t addr, uint8_t cmd, uint8_t data_len,
+                              const uint8_t* data, uint8_t* frame);
+
+/* best of BENCH_RUNS runs in ns per frame */
+static double bench_encode(encode_fn encode, const uint8_t* data) {
+    uint8_t frame[SENSIRION_SHDLC_MAX_TX_FRAME_SIZE];
+    double best = 0;
+    uint32_t i;
+    int run;
+
+    for (run = 0; run < BENCH_RUNS; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (i = 0; i < BENCH_ITERATIONS; ++i) {
+            sink += encode(0x00, 0x80, 255, data, frame);
+            sink += frame[i & 0xff];
+        }
+        std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        if (run == 0 || elapsed.count() < best)
+            best = elapsed.count();
+    }
+    return best / BENCH_ITERATIONS;
+}
+
+static void bench_encoders(const char* name, const uint8_t* data) {
+    double baseline = bench_encode(baseline_encode, data);
+    double fused = bench_encode(sensirion_shdlc_encode, data);
+
+    printf("encode 255 bytes, %-14s %8.1f ns %8.1f ns %6.2fx\n", name,
+           baseline, fused, baseline / fused);
+}
+
+/* a UART port which accepts everything without looking at it, so only the
+ * framing is measured */
+static int16_t noop_tx(void* ctx, uint16_t data_len, const uint8_t* data) {
+    return (int16_t)data_len;
+}
+
+static int16_t noop_txv(void* ctx, uint8_t iovcnt,
+                        const struct sensirion_uart_iovec* iov) {
+    uint16_t len = 0;
+
+    while (iovcnt--)
+        len += (iov++)->len;
+    return (int16_t)len;
+}
+
+static const struct sensirion_uart_ops noop_ops = {noop_tx, noop_txv, NULL};
+
+/* The transmitter before the scatter/gather rewrite: encode the whole frame
+ * into a buffer, then send it */
+static int16_t baseline_tx_dev(struct sensirion_shdlc_dev* dev, uint8_t addr,
+                               uint8_t cmd, uint8_t data_len,
+                               const uint8_t* data) {
+    uint8_t frame[SENSIRION_SHDLC_MAX_TX_FRAME_SIZE];
+    uint16_t len;
+
+    len = baseline_encode(addr, cmd, data_len, data, frame);
+    return sensirion_shdlc_tx_raw_dev(dev, len, frame);
+}
+
+typedef int16_t (*tx_fn)(struct sensirion_shdlc_dev* dev, uint8_t addr,
+                         uint8_t cmd, uint8_t data_len, const uint8_t* data);
+
+/* best of BENCH_RUNS runs in ns per frame */
+static double bench_tx(tx_fn tx, const uint8_t* data) {
+    struct sensirion_shdlc_dev dev;
+    double best = 0;
+    uint32_t i;
+    int run;
+
+    sensirion_shdlc_dev_init(&dev, &noop_ops, NULL);
+    for (run = 0; run < BENCH_RUNS; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (i = 0; i < BENCH_ITERATIONS; ++i)
+            sink += (uint32_t)tx(&dev, 0x00, 0x80, 255, data);
+        std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        if (run == 0 || elapsed.count() < best)
+            best = elapsed.count();
+    }
+    return best / BENCH_ITERATIONS;
+}
+
+static void bench_transmitters(const char* name, const uint8_t* data) {
+    double baseline = bench_tx(baseline_tx_dev, data);
+    double current = bench_tx(sensirion_shdlc_tx_dev, data);
+
+    printf("transmit 255 bytes, %-12s %8.1f ns %8.1f ns %6.2fx\n", name,
+           baseline, current, baseline / current);
+}
+
+/* The receiver before the streaming decoder: read the whole frame into a
+ * frame buffer, then un-stuff header and data byte by byte */
+static uint8_t baseline_check_unstuff(uint8_t data) {
+    return data == 0x7d;
+}
+
+static uint8_t baseline_unstuff_byte(uint8_t data) {
+    switch (data) {
+        case 0x31:
+            return 0x11;
+        case 0x33:
+            return 0x13;
+        case 0x5d:
+            return 0x7d;
+        case 0x5e:
+            return 0x7e;
+        default:
+            return data;
+    }
+}
+
+static int16_t baseline_rx(uint8_t max_data_len,
+                           struct sensirion_shdlc_rx_header* rxh,
+                           uint8_t* data) {
+    int16_t len;
+    uint16_t i;
+    uint8_t rx_frame[2 + (5 + 255) * 2];
+    uint8_t* rx_header = (uint8_t*)rxh;
+    uint8_t j;
+    uint8_t crc;
+    uint8_t unstuff_next;
+
+    len = sensirion_uart_rx(2 + (5 + (uint16_t)max_data_len) * 2, rx_frame);
+    if (len < 1 || rx_frame[0] != 0x7e)
+        return SENSIRION_SHDLC_ERR_MISSING_START;
+
+    for (unstuff_next = 0, i = 1, j = 0; j < sizeof(*rxh) && i < len - 2; ++i) {
+        if (unstuff_next) {
+            rx_header[j++] = baseline_unstuff_byte(rx_frame[i]);
+            unstuff_next = 0;
+        } else {
+            unstuff_next = baseline_check_unstuff(rx_frame[i]);
+            if (!unstuff_next)
+                rx_header[j++] = rx_frame[i];
+        }
+    }
+    if (j != sizeof(*rxh) || unstuff_next)
+        return SENSIRION_SHDLC_ERR_ENCODING_ERROR;
+
+    if (max_data_len < rxh->data_len)
+        return SENSIRION_SHDLC_ERR_FRAME_TOO_LONG;
+
+    for (unstuff_next = 0, j = 0; j < rxh->data_len && i < len - 2; ++i) {
+        if (unstuff_next) {
+            data[j++] = baseline_unstuff_byte(rx_frame[i]);
+            unstuff_next = 0;
+        } else {
+            unstuff_next = baseline_check_unstuff(rx_frame[i]);
+            if (!unstuff_next)
+                data[j++] = rx_frame[i];
+        }
+    }
+
+    if (unstuff_next || j < rxh->data_len)
+        return SENSIRION_SHDLC_ERR_ENCODING_ERROR;
+
+    crc = rx_frame[i++];
+    if (baseline_check_unstuff(crc))
+        crc = baseline_unstuff_byte(rx_frame[i++]);
+
+    if (baseline_crc(rxh->addr + rxh->cmd + rxh->state, rxh->data_len, data) !=
+        crc)
+        return SENSIRION_SHDLC_ERR_CRC_MISMATCH;
+
+    if (i >= len || rx_frame[i] != 0x7e)
+        return SENSIRION_SHDLC_ERR_MISSING_STOP;
+
+    return 0;
+}
+
+typedef int16_t (*rx_fn)(uint8_t max_data_len,
+                         struct sensirion_shdlc_rx_header* rxh, uint8_t* data);
+
+/* best of BENCH_RUNS runs in ns per frame */
+static double bench_rx(rx_fn rx, const uint8_t* frame, uint16_t frame_len) {
+    struct sensirion_shdlc_rx_header header;
+    uint8_t data[255];
+    double best = 0;
+    uint32_t i;
+    int run;
+
+    rx_bytes = frame;
+    rx_len = frame_len;
+    for (run = 0; run < BENCH_RUNS; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (i = 0; i < BENCH_ITERATIONS; ++i) {
+            rx_pos = 0;
+            sink += (uint32_t)rx(sizeof(data), &header, data);
+            sink += data[i & 0xff];
+        }
+        std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        if (run == 0 || elapsed.count() < best)
+            best = elapsed.count();
+    }
+    return best / BENCH_ITERATIONS;
+}
+
+static void bench_receivers(const char* name, const uint8_t* data,
+                            uint8_t data_len) {
+    uint8_t frame[SENSIRION_SHDLC_MAX_TX_FRAME_SIZE + 2];
+    uint16_t frame_len;
+    double baseline;
+    double current;
+
+    /* a response frame has the extra state byte in the header, encode it as
+     * part of the command byte and patch it in afterwards */
+    frame_len = sensirion_shdlc_encode(0x00, 0x03, data_len, data, frame);
+    memmove(&frame[4], &frame[3], frame_len - 3u);
+    frame[3] = 0x00;
+    ++frame_len;
+
+    baseline = bench_rx(baseline_rx, frame, frame_len);
+    current = bench_rx(sensirion_shdlc_rx, frame, frame_len);
+    printf("decode %3u bytes, %-13s %8.1f ns %8.1f ns %6.2fx\n", data_len,
+           name, baseline, current, baseline / current);
+}
+
+/* best of BENCH_RUNS runs in ns per measurement of ten floats */
+static double bench_floats(bool bulk, const uint8_t* bytes) {
+    float values[10];
+    double best = 0;
+    uint32_t i;
+    uint8_t j;
+    int run;
+
+    for (run = 0; run < BENCH_RUNS; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (i = 0; i < BENCH_ITERATIONS; ++i) {
+            if (bulk) {
+                sensirion_be32_array_to_float(10, bytes, values);
+            } else {
+                for (j = 0; j < 10; ++j)
+                    values[j] = sensirion_bytes_to_float(&bytes[j * 4]);
+            }
+            sink += (uint32_t)values[i % 10];
+        }
+        std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        if (run == 0 || elapsed.count() < best)
+            best = elapsed.count();
+    }
+    return best / BENCH_ITERATIONS;
+}
+
+static void bench_float_conversion(void) {
+    uint8_t bytes[40];
+    double baseline;
+    double current;
+    uint8_t i;
+
+    for (i = 0; i < 10; ++i)
+        sensirion_float_to_bytes(i * 1.5f, &bytes[i * 4]);
+
+    baseline = bench_floats(false, bytes);
+    current = bench_floats(true, bytes);
+    printf("convert 10 floats, %-13s %8.1f ns %8.1f ns %6.2fx\n",
+           "measurement", baseline, current, baseline / current);
+}
+
+int main(void) {
+    uint8_t data[255];
+    uint16_t i;
+
+    printf("%-38s %11s %11s %7s\n", "", "baseline", "current", "speedup");
+
+    for (i = 0; i < sizeof(data); ++i)
+        data[i] = (uint8_t)(0x80 | i);
+    bench_encoders("no escapes", data);
+    bench_transmitters("no escapes", data);
+
+    srand(1);
+    for (i = 0; i < sizeof(data); ++i)
+        data[i] = (uint8_t)rand();
+    bench_encoders("random", data);
+    bench_transmitters("random", data);
+
+    memset(data, 0x7e, sizeof(data));
+    bench_encoders("all escapes", data);
+    bench_transmitters("all escapes", data);
+
+    for (i = 0; i < sizeof(data); ++i)
+        data[i] = (uint8_t)(0x80 | i);
+    bench_receivers("no escapes", data, 255);
+    bench_receivers("no escapes", data, 40);
+
+    srand(1);
+    for (i = 0; i < sizeof(data); ++i)
+        data[i] = (uint8_t)rand();
+    bench_receivers("random", data, 255);
+    bench_receivers("random", data, 40);
+
+    memset(data, 0x7e, sizeof(data));
+    bench_receivers("all escapes", data, 255);
+
+    bench_float_conversion();
+
+    return 0;
+}
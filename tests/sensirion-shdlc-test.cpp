@@ -0,0 +1,549 @@
+#include "sensirion_shdlc.h"
+#include "sensirion_test_setup.h"
+#include "sensirion_uart_fake.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* read version response: data 03 01 00 07 00 02 00 */
+static const uint8_t version_frame[] = {0x7e, 0x00, 0xd1, 0x00, 0x07,
+                                        0x03, 0x01, 0x00, 0x07, 0x00,
+                                        0x02, 0x00, 0x1a, 0x7e};
+
+/* response with data 11 7e, both stuffed, and a checksum of 0x7d (stuffed) */
+static const uint8_t stuffed_frame[] = {0x7e, 0x00, 0xf1, 0x00, 0x02, 0x7d,
+                                        0x31, 0x7d, 0x5e, 0x7d, 0x5d, 0x7e};
+
+TEST_GROUP (SHDLC_Test) {
+    void setup() {
+        fake_uart_reset();
+    }
+};
+
+TEST (SHDLC_Test, rx_single_chunk) {
+    struct sensirion_shdlc_rx_header header;
+    uint8_t data[7];
+
+    fake_uart_rx_feed(version_frame, sizeof(version_frame),
+                      sizeof(version_frame));
+    CHECK_ZERO(sensirion_shdlc_rx(sizeof(data), &header, data));
+    CHECK_EQUAL(0xd1, header.cmd);
+    CHECK_EQUAL(7, header.data_len);
+    CHECK_EQUAL(0x07, data[3]);
+    CHECK_EQUAL(sizeof(version_frame), fake_rx_pos);
+}
+
+TEST (SHDLC_Test, rx_partial_chunks) {
+    struct sensirion_shdlc_rx_header header;
+    uint8_t data[7];
+    uint16_t chunk_size;
+
+    for (chunk_size = 1; chunk_size < sizeof(version_frame); ++chunk_size) {
+        fake_uart_rx_feed(version_frame, sizeof(version_frame), chunk_size);
+        CHECK_ZERO(sensirion_shdlc_rx(sizeof(data), &header, data));
+        CHECK_EQUAL(7, header.data_len);
+        CHECK_EQUAL(0x02, data[5]);
+    }
+}
+
+TEST (SHDLC_Test, rx_unstuffing_across_chunks) {
+    struct sensirion_shdlc_rx_header header;
+    uint8_t data[2];
+    uint16_t chunk_size;
+
+    for (chunk_size = 1; chunk_size <= sizeof(stuffed_frame); ++chunk_size) {
+        fake_uart_rx_feed(stuffed_frame, sizeof(stuffed_frame), chunk_size);
+        CHECK_ZERO(sensirion_shdlc_rx(sizeof(data), &header, data));
+        CHECK_EQUAL(2, header.data_len);
+        CHECK_EQUAL(0x11, data[0]);
+        CHECK_EQUAL(0x7e, data[1]);
+    }
+}
+
+TEST (SHDLC_Test, rx_keeps_bytes_past_frame) {
+    struct sensirion_shdlc_rx_header header;
+    uint8_t frames[2 * sizeof(stuffed_frame)];
+    uint8_t data[2];
+
+    /* short frames are received in one read, bytes read beyond the end of
+     * the frame are kept for the next one */
+    memcpy(frames, stuffed_frame, sizeof(stuffed_frame));
+    memcpy(&frames[sizeof(stuffed_frame)], stuffed_frame,
+           sizeof(stuffed_frame));
+    fake_uart_rx_feed(frames, sizeof(frames), sizeof(frames));
+    CHECK_ZERO(sensirion_shdlc_rx(sizeof(data), &header, data));
+    CHECK_EQUAL(1, fake_rx_calls);
+    CHECK_EQUAL(0x7e, data[1]);
+    data[1] = 0;
+    CHECK_ZERO(sensirion_shdlc_rx(sizeof(data), &header, data));
+    CHECK_EQUAL(1, fake_rx_calls);
+    CHECK_EQUAL(0x7e, data[1]);
+}
+
+TEST (SHDLC_Test, rx_errors) {
+    struct sensirion_shdlc_rx_header header;
+    uint8_t frame[sizeof(version_frame)];
+    uint8_t data[7];
+
+    fake_uart_rx_feed(version_frame, 0, 1);
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_MISSING_START,
+                sensirion_shdlc_rx(sizeof(data), &header, data));
+
+    fake_uart_rx_feed(&version_frame[1], sizeof(version_frame) - 1, 4);
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_MISSING_START,
+                sensirion_shdlc_rx(sizeof(data), &header, data));
+
+    fake_uart_rx_feed(version_frame, sizeof(version_frame), 4);
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_FRAME_TOO_LONG,
+                sensirion_shdlc_rx(sizeof(data) - 1, &header, data));
+
+    memcpy(frame, version_frame, sizeof(frame));
+    frame[6] ^= 0x01;
+    fake_uart_rx_feed(frame, sizeof(frame), 3);
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_CRC_MISMATCH,
+                sensirion_shdlc_rx(sizeof(data), &header, data));
+
+    fake_uart_rx_feed(version_frame, sizeof(version_frame) - 1, 5);
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_MISSING_STOP,
+                sensirion_shdlc_rx(sizeof(data), &header, data));
+}
+
+TEST (SHDLC_Test, rx_decode_consumed) {
+    struct sensirion_shdlc_rx_decoder decoder;
+    struct sensirion_shdlc_rx_header header;
+    uint8_t frames[2 * sizeof(version_frame)];
+    uint8_t data[7];
+    uint16_t consumed;
+
+    memcpy(frames, version_frame, sizeof(version_frame));
+    memcpy(&frames[sizeof(version_frame)], version_frame,
+           sizeof(version_frame));
+
+    sensirion_shdlc_rx_decoder_init(&decoder, sizeof(data), &header, data);
+    CHECK_EQUAL(SENSIRION_SHDLC_RX_INCOMPLETE,
+                sensirion_shdlc_rx_decode(&decoder, 5, frames, &consumed));
+    CHECK_EQUAL(5, consumed);
+    CHECK_ZERO(sensirion_shdlc_rx_decode(&decoder, sizeof(frames) - 5,
+                                         &frames[5], &consumed));
+    CHECK_EQUAL(sizeof(version_frame) - 5, consumed);
+}
+
+/* straightforward byte-by-byte frame encoding to check against */
+static uint16_t reference_frame(const uint8_t* raw, uint16_t raw_len,
+                                uint8_t* frame) {
+    uint8_t sum = 0;
+    uint8_t c;
+    uint16_t len = 0;
+    uint16_t i;
+
+    frame[len++] = 0x7e;
+    for (i = 0; i <= raw_len; ++i) {
+        c = i < raw_len ? raw[i] : (uint8_t)~sum;
+        sum += c;
+        if (c == 0x11 || c == 0x13 || c == 0x7d || c == 0x7e) {
+            frame[len++] = 0x7d;
+            frame[len++] = c ^ 0x20;
+        } else {
+            frame[len++] = c;
+        }
+    }
+    frame[len++] = 0x7e;
+    return len;
+}
+
+static uint16_t reference_encode(uint8_t addr, uint8_t cmd, uint8_t data_len,
+                                 const uint8_t* data, uint8_t* frame) {
+    uint8_t raw[3 + 255];
+
+    raw[0] = addr;
+    raw[1] = cmd;
+    raw[2] = data_len;
+    memcpy(&raw[3], data, data_len);
+    return reference_frame(raw, 3u + data_len, frame);
+}
+
+static uint16_t reference_response(uint8_t cmd, uint8_t data_len,
+                                   const uint8_t* data, uint8_t* frame) {
+    uint8_t raw[4 + 255];
+
+    raw[0] = 0x00;
+    raw[1] = cmd;
+    raw[2] = 0x00;
+    raw[3] = data_len;
+    memcpy(&raw[4], data, data_len);
+    return reference_frame(raw, 4u + data_len, frame);
+}
+
+TEST (SHDLC_Test, tx_frame) {
+    const uint8_t start_measurement[] = {0x7e, 0x00, 0x00, 0x02, 0x01,
+                                         0x03, 0xf9, 0x7e};
+    const uint8_t data[] = {0x01, 0x03};
+
+    CHECK_ZERO(sensirion_shdlc_tx(0x00, 0x00, sizeof(data), data));
+    CHECK_EQUAL(sizeof(start_measurement), fake_tx_len);
+    MEMCMP_EQUAL(start_measurement, fake_tx_buf, sizeof(start_measurement));
+}
+
+TEST (SHDLC_Test, tx_frame_stuffed) {
+    /* data and checksum (0x7e) need stuffing */
+    const uint8_t expected[] = {0x7e, 0x00, 0xef, 0x02, 0x7d, 0x33,
+                                0x7d, 0x5d, 0x7d, 0x5e, 0x7e};
+    const uint8_t data[] = {0x13, 0x7d};
+
+    CHECK_ZERO(sensirion_shdlc_tx(0x00, 0xef, sizeof(data), data));
+    CHECK_EQUAL(sizeof(expected), fake_tx_len);
+    MEMCMP_EQUAL(expected, fake_tx_buf, sizeof(expected));
+}
+
+TEST (SHDLC_Test, tx_matches_reference) {
+    uint8_t data[255];
+    uint8_t expected[SENSIRION_SHDLC_MAX_TX_FRAME_SIZE];
+    uint16_t expected_len;
+    uint16_t data_len;
+    uint16_t i;
+
+    srand(3);
+    for (data_len = 0; data_len <= sizeof(data); ++data_len) {
+        for (i = 0; i < data_len; ++i)
+            data[i] = (uint8_t)rand();
+        fake_uart_reset();
+        CHECK_ZERO(sensirion_shdlc_tx(0x00, 0x80, (uint8_t)data_len, data));
+        expected_len = reference_encode(0x00, 0x80, (uint8_t)data_len, data,
+                                        expected);
+        CHECK_EQUAL(expected_len, fake_tx_len);
+        MEMCMP_EQUAL(expected, fake_tx_buf, expected_len);
+    }
+
+    /* frames without escapes go out in a single call, data is not copied */
+    memset(data, 0x42, sizeof(data));
+    fake_uart_reset();
+    CHECK_ZERO(sensirion_shdlc_tx(0x00, 0x80, sizeof(data), data));
+    CHECK_EQUAL(1, fake_tx_calls);
+
+    /* only data full of escapes needs several calls */
+    memset(data, 0x7e, sizeof(data));
+    fake_uart_reset();
+    CHECK_ZERO(sensirion_shdlc_tx(0x00, 0x80, sizeof(data), data));
+    expected_len =
+        reference_encode(0x00, 0x80, sizeof(data), data, expected);
+    CHECK_EQUAL(expected_len, fake_tx_len);
+    MEMCMP_EQUAL(expected, fake_tx_buf, expected_len);
+}
+
+/* the iovecs run out while stuffed bytes are pending in the copy buffer */
+TEST (SHDLC_Test, tx_all_iovecs) {
+    uint8_t data[255];
+    uint8_t expected[SENSIRION_SHDLC_MAX_TX_FRAME_SIZE];
+    uint16_t expected_len;
+    uint16_t len = 0;
+    uint8_t i;
+
+    memset(data, 0x41, sizeof(data));
+    for (i = 0; i < 7; ++i) {
+        len += 8; /* sent by reference */
+        data[len++] = 0x7e;
+    }
+    len += 8;
+    data[len++] = 0x11;
+    memset(&data[len], 0x7d, 12);
+
+    CHECK_ZERO(sensirion_shdlc_tx(0x00, 0x80, sizeof(data), data));
+    expected_len = reference_encode(0x00, 0x80, sizeof(data), data, expected);
+    CHECK_EQUAL(expected_len, fake_tx_len);
+    MEMCMP_EQUAL(expected, fake_tx_buf, expected_len);
+    CHECK(fake_tx_calls > 1);
+}
+
+TEST (SHDLC_Test, xcv_batch) {
+    struct sensirion_shdlc_batch_cmd cmds[3];
+    uint8_t frames[2 * sizeof(version_frame) + sizeof(stuffed_frame)];
+    uint8_t version[7];
+    uint8_t stuffed[2];
+
+    /* responses arrive in a different order than the commands were sent,
+     * the one to 0xd1 is a leftover that doesn't belong to the batch */
+    memcpy(frames, version_frame, sizeof(version_frame));
+    memcpy(&frames[sizeof(version_frame)], stuffed_frame,
+           sizeof(stuffed_frame));
+    memcpy(&frames[sizeof(version_frame) + sizeof(stuffed_frame)],
+           version_frame, sizeof(version_frame));
+    fake_uart_rx_feed(frames, sizeof(frames), 5);
+
+    memset(cmds, 0, sizeof(cmds));
+    cmds[0].cmd = 0xf1;
+    cmds[0].max_rx_data_len = sizeof(stuffed);
+    cmds[0].rx_data = stuffed;
+    cmds[1].cmd = 0xd1;
+    cmds[1].max_rx_data_len = sizeof(version);
+    cmds[1].rx_data = version;
+    CHECK_ZERO(sensirion_shdlc_xcv_batch(0x00, 2, cmds, 1000));
+    CHECK_EQUAL(2, fake_tx_calls);
+    CHECK_ZERO(cmds[0].status);
+    CHECK_EQUAL(0x7e, stuffed[1]);
+    CHECK_ZERO(cmds[1].status);
+    CHECK_EQUAL(0x07, version[3]);
+
+    /* only the leftover response to 0xd1 is left */
+    cmds[2].cmd = 0x03;
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_MISSING_START,
+                sensirion_shdlc_xcv_batch(0x00, 3, cmds, 1000));
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_NO_DATA, cmds[0].status);
+    CHECK_ZERO(cmds[1].status);
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_NO_DATA, cmds[2].status);
+}
+
+TEST (SHDLC_Test, xcv_batch_corrupted_response) {
+    struct sensirion_shdlc_batch_cmd cmds[3];
+    struct sensirion_shdlc_rx_header header;
+    uint8_t frames[64];
+    uint16_t len;
+    uint8_t version[7];
+    uint8_t stuffed[2];
+
+    /* the response to 0xd1 in the middle of the batch has a broken checksum */
+    memcpy(frames, stuffed_frame, sizeof(stuffed_frame));
+    len = sizeof(stuffed_frame);
+    memcpy(&frames[len], version_frame, sizeof(version_frame));
+    len += sizeof(version_frame);
+    frames[len - 2] ^= 0x01;
+    len += fake_encode_response(0x03, 0, 0, NULL, &frames[len]);
+    fake_uart_rx_feed(frames, len, 5);
+
+    memset(cmds, 0, sizeof(cmds));
+    cmds[0].cmd = 0xf1;
+    cmds[0].max_rx_data_len = sizeof(stuffed);
+    cmds[0].rx_data = stuffed;
+    cmds[1].cmd = 0xd1;
+    cmds[1].max_rx_data_len = sizeof(version);
+    cmds[1].rx_data = version;
+    cmds[2].cmd = 0x03;
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_CRC_MISMATCH,
+                sensirion_shdlc_xcv_batch(0x00, 3, cmds, 1000));
+    CHECK_ZERO(cmds[0].status);
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_NO_DATA, cmds[1].status);
+    CHECK_ZERO(cmds[2].status);
+
+    /* no response is left behind for the next transaction */
+    CHECK_EQUAL(len, fake_rx_pos);
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_MISSING_START,
+                sensirion_shdlc_xcv(0x00, 0x03, 0, NULL, 0, &header, NULL));
+}
+
+TEST (SHDLC_Test, xcv_raw) {
+    const uint8_t read_version[] = {0x7e, 0x00, 0xd1, 0x00, 0x2e, 0x7e};
+    struct sensirion_shdlc_rx_header header;
+    uint8_t data[7];
+
+    fake_uart_rx_feed(version_frame, sizeof(version_frame), 4);
+    CHECK_ZERO(sensirion_shdlc_xcv_raw(sizeof(read_version), read_version,
+                                       sizeof(data), &header, data, 1000));
+    CHECK_EQUAL(sizeof(read_version), fake_tx_len);
+    MEMCMP_EQUAL(read_version, fake_tx_buf, sizeof(read_version));
+    CHECK_EQUAL(0xd1, header.cmd);
+    CHECK_EQUAL(0x02, data[5]);
+}
+
+TEST (SHDLC_Test, encode_matches_reference) {
+    const uint8_t specials[] = {0x11, 0x13, 0x7d, 0x7e};
+    uint8_t data[255];
+    uint8_t frame[SENSIRION_SHDLC_MAX_TX_FRAME_SIZE];
+    uint8_t expected[SENSIRION_SHDLC_MAX_TX_FRAME_SIZE];
+    uint16_t len;
+    uint16_t expected_len;
+    uint16_t data_len;
+    uint16_t i;
+
+    srand(42);
+    for (data_len = 0; data_len <= sizeof(data); ++data_len) {
+        /* without escapes, with random bytes and with a single escape */
+        for (i = 0; i < data_len; ++i)
+            data[i] = (uint8_t)(0x80 | rand());
+        len = sensirion_shdlc_encode(0x00, 0x03, (uint8_t)data_len, data,
+                                     frame);
+        expected_len = reference_encode(0x00, 0x03, (uint8_t)data_len, data,
+                                        expected);
+        CHECK_EQUAL(expected_len, len);
+        MEMCMP_EQUAL(expected, frame, len);
+
+        for (i = 0; i < data_len; ++i)
+            data[i] = (uint8_t)rand();
+        len = sensirion_shdlc_encode(0x00, 0x80, (uint8_t)data_len, data,
+                                     frame);
+        expected_len = reference_encode(0x00, 0x80, (uint8_t)data_len, data,
+                                        expected);
+        CHECK_EQUAL(expected_len, len);
+        MEMCMP_EQUAL(expected, frame, len);
+
+        if (data_len) {
+            memset(data, 0x42, data_len);
+            data[rand() % data_len] =
+                specials[(size_t)rand() % sizeof(specials)];
+            len = sensirion_shdlc_encode(0x7e, 0x11, (uint8_t)data_len, data,
+                                         frame);
+            expected_len = reference_encode(0x7e, 0x11, (uint8_t)data_len,
+                                            data, expected);
+            CHECK_EQUAL(expected_len, len);
+            MEMCMP_EQUAL(expected, frame, len);
+        }
+    }
+}
+
+TEST (SHDLC_Test, rx_long_frames) {
+    const uint8_t specials[] = {0x11, 0x13, 0x7d, 0x7e};
+    struct sensirion_shdlc_rx_header header;
+    uint8_t frame[2 + (5 + 255) * 2];
+    uint8_t expected[255];
+    uint8_t data[255];
+    uint16_t frame_len;
+    uint16_t chunk_size;
+    uint16_t i;
+    int round;
+
+    srand(7);
+    for (round = 0; round < 20; ++round) {
+        /* long runs without escapes (SIMD/word path) with some escapes */
+        for (i = 0; i < sizeof(expected); ++i)
+            expected[i] = (uint8_t)(0x80 | rand());
+        for (i = 0; i < round; ++i)
+            expected[(size_t)rand() % sizeof(expected)] =
+                specials[(size_t)rand() % sizeof(specials)];
+        frame_len = reference_response(0x03, sizeof(expected), expected, frame);
+
+        for (chunk_size = 1; chunk_size <= frame_len; chunk_size += 13) {
+            memset(data, 0, sizeof(data));
+            fake_uart_rx_feed(frame, frame_len, chunk_size);
+            CHECK_ZERO(sensirion_shdlc_rx(sizeof(data), &header, data));
+            CHECK_EQUAL(sizeof(expected), header.data_len);
+            MEMCMP_EQUAL(expected, data, sizeof(expected));
+            CHECK_EQUAL(frame_len, fake_rx_pos);
+        }
+    }
+}
+
+TEST (SHDLC_Test, rx_resync_noise) {
+    const uint8_t noise[] = {0xff, 0x00, 0x13, 0x7d};
+    struct sensirion_shdlc_rx_header header;
+    uint8_t frame[sizeof(noise) + sizeof(version_frame)];
+    uint8_t data[7];
+    uint16_t chunk_size;
+    uint32_t resyncs;
+
+    memcpy(frame, noise, sizeof(noise));
+    memcpy(&frame[sizeof(noise)], version_frame, sizeof(version_frame));
+
+    for (chunk_size = 1; chunk_size <= sizeof(frame); ++chunk_size) {
+        resyncs = sensirion_shdlc_rx_resync_count();
+        fake_uart_rx_feed(frame, sizeof(frame), chunk_size);
+        CHECK_ZERO(sensirion_shdlc_rx(sizeof(data), &header, data));
+        CHECK_EQUAL(0x07, data[3]);
+        CHECK_EQUAL(sizeof(frame), fake_rx_pos);
+        CHECK_EQUAL(resyncs + 1, sensirion_shdlc_rx_resync_count());
+    }
+}
+
+TEST (SHDLC_Test, rx_resync_truncated_frame) {
+    struct sensirion_shdlc_rx_header header;
+    uint8_t stream[2 + (5 + 40) * 2 + 2 * sizeof(version_frame)];
+    uint8_t expected[40];
+    uint8_t data[40];
+    uint16_t len;
+    uint16_t chunk_size;
+    uint32_t resyncs;
+
+    /* a measurement response cut off after three data bytes, e.g. by a
+     * sensor reset, followed by two complete frames */
+    memset(expected, 0x42, sizeof(expected));
+    reference_response(0x03, sizeof(expected), expected, stream);
+    len = 8;
+    memcpy(&stream[len], version_frame, sizeof(version_frame));
+    len += sizeof(version_frame);
+    memcpy(&stream[len], stuffed_frame, sizeof(stuffed_frame));
+    len += sizeof(stuffed_frame);
+
+    for (chunk_size = 1; chunk_size <= len; ++chunk_size) {
+        resyncs = sensirion_shdlc_rx_resync_count();
+        fake_uart_rx_feed(stream, len, chunk_size);
+        CHECK_ZERO(sensirion_shdlc_rx(sizeof(data), &header, data));
+        CHECK_EQUAL(0xd1, header.cmd);
+        CHECK_EQUAL(0x07, data[3]);
+        CHECK_EQUAL(resyncs + 1, sensirion_shdlc_rx_resync_count());
+
+        /* bytes read beyond the first frame are not lost */
+        CHECK_ZERO(sensirion_shdlc_rx(sizeof(data), &header, data));
+        CHECK_EQUAL(0xf1, header.cmd);
+        CHECK_EQUAL(0x7e, data[1]);
+        CHECK_EQUAL(len, fake_rx_pos);
+    }
+}
+
+/* a port which receives a noise byte every 40ms, on a virtual clock */
+struct noise_port {
+    uint32_t now_us;
+    uint16_t noise_count;
+};
+
+static int16_t noise_port_rx_timeout(void* ctx, uint16_t max_data_len,
+                                     uint8_t* data, uint32_t timeout_us) {
+    struct noise_port* port = (struct noise_port*)ctx;
+    uint32_t next = (port->now_us / 40000 + 1) * 40000;
+
+    /* the noise stops eventually so that the test fails instead of hanging */
+    if (port->noise_count == 100 || next - port->now_us > timeout_us) {
+        port->now_us += timeout_us;
+        return 0;
+    }
+    port->now_us = next;
+    ++port->noise_count;
+    data[0] = 0x00;
+    return 1;
+}
+
+static uint32_t noise_port_time_usec(void* ctx) {
+    return ((struct noise_port*)ctx)->now_us;
+}
+
+static const struct sensirion_uart_ops noise_port_ops = {
+    NULL,
+    NULL,
+    noise_port_rx_timeout,
+    noise_port_time_usec,
+};
+
+TEST (SHDLC_Test, rx_timeout_noise) {
+    struct noise_port port = {1000, 0};
+    struct sensirion_shdlc_dev dev;
+    struct sensirion_shdlc_rx_header header;
+
+    /* noise doesn't extend the time limit */
+    sensirion_shdlc_dev_init(&dev, &noise_port_ops, &port);
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_MISSING_START,
+                sensirion_shdlc_rx_timeout_dev(&dev, 0, &header, NULL, 100000));
+    CHECK(port.now_us - 1000 <= 100000);
+    CHECK_EQUAL(2, port.noise_count);
+}
+
+TEST (SHDLC_Test, be32_array_to_float) {
+    uint8_t bytes[37 * 4];
+    uint8_t in_place[37 * 4];
+    float values[37];
+    float expected;
+    uint16_t count;
+    uint16_t i;
+
+    srand(7);
+    for (i = 0; i < sizeof(bytes); ++i)
+        bytes[i] = (uint8_t)rand();
+
+    for (count = 0; count <= 37; ++count) {
+        memset(values, 0, sizeof(values));
+        sensirion_be32_array_to_float(count, bytes, values);
+        memcpy(in_place, bytes, sizeof(bytes));
+        sensirion_be32_array_to_float(count, in_place, (float*)in_place);
+        for (i = 0; i < count; ++i) {
+            expected = sensirion_bytes_to_float(&bytes[i * 4]);
+            MEMCMP_EQUAL(&expected, &values[i], sizeof(expected));
+            MEMCMP_EQUAL(&expected, &in_place[i * 4], sizeof(expected));
+        }
+        if (count < 37)
+            CHECK_EQUAL(0.0f, values[count]);
+    }
+}
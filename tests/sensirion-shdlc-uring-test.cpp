@@ -0,0 +1,150 @@
+#include "sensirion_shdlc.h"
+#include "sensirion_shdlc_uring.h"
+#include "sensirion_test_setup.h"
+#include "sensirion_uart.h"
+#include "sensirion_uart_fake.h"
+#include "sensirion_uart_linux.h"
+#include "sensirion_uart_pty.h"
+#include "sps30.h"
+#include "sps30_frames.h"
+#include <string.h>
+#include <thread>
+#include <unistd.h>
+
+#define TEST_PORTS 6
+
+/* pseudo terminal master of each port, the HAL opens the slave side */
+static int masters[TEST_PORTS];
+static struct sensirion_shdlc_uring loop;
+static struct sensirion_shdlc_uring_port ports[TEST_PORTS];
+static uint8_t rx_data[TEST_PORTS][SPS30_MEASUREMENT_LEN];
+
+/* encode a measurement response with mc_1p0 = port, return its length */
+static uint16_t encode_response(uint8_t port, uint8_t* frame) {
+    uint8_t data[SPS30_MEASUREMENT_LEN];
+
+    memset(data, 0, sizeof(data));
+    sensirion_float_to_bytes((float)port, data);
+    return fake_encode_response(0x03, 0x00, sizeof(data), data, frame);
+}
+
+/* check the request received on a port */
+static void check_request(uint8_t port) {
+    const struct sps30_frame* request =
+        &sps30_frames[SPS30_FRAME_READ_MEASUREMENT];
+    uint8_t frame[SENSIRION_SHDLC_MAX_TX_FRAME_SIZE];
+
+    CHECK_EQUAL(request->len, read(masters[port], frame, sizeof(frame)));
+    MEMCMP_EQUAL(request->bytes, frame, request->len);
+}
+
+/* answer a read measurement request on a port with mc_1p0 = port */
+static void respond(uint8_t port) {
+    uint8_t frame[SENSIRION_SHDLC_MAX_TX_FRAME_SIZE + 1];
+    uint16_t len;
+
+    check_request(port);
+    len = encode_response(port, frame);
+
+    /* in two parts to exercise the incremental decoding */
+    CHECK_EQUAL(5, write(masters[port], frame, 5));
+    usleep(1000);
+    CHECK_EQUAL(len - 5, write(masters[port], &frame[5], len - 5u));
+}
+
+TEST_GROUP (SHDLC_Uring_Test) {
+    void setup() {
+        const struct sps30_frame* request =
+            &sps30_frames[SPS30_FRAME_READ_MEASUREMENT];
+        uint8_t port;
+
+        CHECK_ZERO(sensirion_shdlc_uring_init(&loop, TEST_PORTS));
+        for (port = 0; port < TEST_PORTS; ++port) {
+            masters[port] = pty_open_port(port);
+            CHECK_TRUE(masters[port] >= 0);
+
+            ports[port].fd = sensirion_uart_get_fd();
+            ports[port].tx_frame_len = request->len;
+            ports[port].tx_frame = request->bytes;
+            ports[port].max_rx_data_len = SPS30_MEASUREMENT_LEN;
+            ports[port].rx_data = rx_data[port];
+        }
+    }
+
+    void teardown() {
+        uint8_t port;
+
+        sensirion_shdlc_uring_close(&loop);
+        for (port = 0; port < TEST_PORTS; ++port) {
+            sensirion_uart_select_port(port);
+            sensirion_uart_close();
+            close(masters[port]);
+        }
+    }
+};
+
+TEST (SHDLC_Uring_Test, responses_in_any_order) {
+    struct sps30_measurement m;
+    uint8_t port;
+
+    /* the sensors answer in reverse order */
+    std::thread sensors([] {
+        for (uint8_t p = TEST_PORTS; p--;)
+            respond(p);
+    });
+    CHECK_ZERO(sensirion_shdlc_uring_xcv(&loop, TEST_PORTS, ports, 1000000));
+    sensors.join();
+
+    for (port = 0; port < TEST_PORTS; ++port) {
+        CHECK_ZERO(ports[port].status);
+        CHECK_ZERO(sps30_decode_measurement(&ports[port].rx_header,
+                                            rx_data[port], &m));
+        DOUBLES_EQUAL(port, m.mc_1p0, 0.0);
+    }
+}
+
+TEST (SHDLC_Uring_Test, missing_response) {
+    uint8_t port;
+
+    /* all but the last sensor answer */
+    std::thread sensors([] {
+        for (uint8_t p = 0; p < TEST_PORTS - 1; ++p)
+            respond(p);
+    });
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_MISSING_START,
+                sensirion_shdlc_uring_xcv(&loop, TEST_PORTS, ports, 50000));
+    sensors.join();
+
+    for (port = 0; port < TEST_PORTS - 1; ++port)
+        CHECK_ZERO(ports[port].status);
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_MISSING_START,
+                ports[TEST_PORTS - 1].status);
+}
+
+TEST (SHDLC_Uring_Test, one_submission_per_sweep) {
+    uint8_t frame[SENSIRION_SHDLC_MAX_TX_FRAME_SIZE + 1];
+    uint8_t port;
+
+    /* all responses are ready as soon as the requests went out */
+    for (port = 0; port < TEST_PORTS; ++port)
+        CHECK_TRUE(write(masters[port], frame,
+                         encode_response(port, frame)) > 0);
+
+    CHECK_ZERO(sensirion_shdlc_uring_xcv(&loop, TEST_PORTS, ports, 1000000));
+    for (port = 0; port < TEST_PORTS; ++port) {
+        check_request(port);
+        CHECK_ZERO(ports[port].status);
+    }
+    CHECK_TRUE(loop.enters < TEST_PORTS);
+}
+
+TEST (SHDLC_Uring_Test, too_many_ports) {
+    CHECK_EQUAL(-1, sensirion_shdlc_uring_xcv(&loop, TEST_PORTS + 1, ports,
+                                              1000));
+}
+
+/* a closed instance, e.g. after io_uring_enter() failed, is not used */
+TEST (SHDLC_Uring_Test, closed_instance) {
+    sensirion_shdlc_uring_close(&loop);
+    CHECK_EQUAL(-1, sensirion_shdlc_uring_xcv(&loop, TEST_PORTS, ports, 1000));
+}
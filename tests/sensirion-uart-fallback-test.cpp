@@ -0,0 +1,110 @@
+#include "sensirion_shdlc.h"
+#include "sensirion_test_setup.h"
+#include "sensirion_uart.h"
+#include <string.h>
+
+/*
+ * Tests of the default implementations of the optional UART HAL functions
+ * against a HAL which does not implement them
+ */
+
+static uint8_t rx_buf[64];
+static uint16_t rx_len;
+static uint16_t rx_pos;
+static uint8_t tx_buf[64];
+static uint16_t tx_len;
+static uint16_t tx_calls;
+static uint32_t slept_us;
+
+extern "C" {
+
+int16_t sensirion_uart_select_port(uint8_t port) {
+    return 0;
+}
+
+int16_t sensirion_uart_open() {
+    return 0;
+}
+
+int16_t sensirion_uart_close() {
+    return 0;
+}
+
+int16_t sensirion_uart_tx(uint16_t data_len, const uint8_t* data) {
+    memcpy(&tx_buf[tx_len], data, data_len);
+    tx_len += data_len;
+    ++tx_calls;
+    return (int16_t)data_len;
+}
+
+int16_t sensirion_uart_rx(uint16_t max_data_len, uint8_t* data) {
+    uint16_t len = rx_len - rx_pos;
+
+    if (len > max_data_len)
+        len = max_data_len;
+    memcpy(data, &rx_buf[rx_pos], len);
+    rx_pos += len;
+    return (int16_t)len;
+}
+
+void sensirion_sleep_usec(uint32_t useconds) {
+    slept_us += useconds;
+}
+
+}  // extern "C"
+
+TEST_GROUP (UART_Fallback_Test) {
+    void setup() {
+        rx_len = 0;
+        rx_pos = 0;
+        tx_len = 0;
+        tx_calls = 0;
+        slept_us = 0;
+    }
+};
+
+TEST (UART_Fallback_Test, txv) {
+    const uint8_t bytes[] = {0xff, 0x7e, 0x00, 0x7d, 0x31, 0x00, 0xee, 0x7e};
+    struct sensirion_uart_iovec iov[2] = {{bytes, 1}, {&bytes[1], 7}};
+
+    CHECK_EQUAL(sizeof(bytes), sensirion_uart_txv(2, iov));
+    CHECK_EQUAL(2, tx_calls);
+    CHECK_EQUAL(sizeof(bytes), tx_len);
+    MEMCMP_EQUAL(bytes, tx_buf, sizeof(bytes));
+}
+
+TEST (UART_Fallback_Test, rx_timeout) {
+    uint8_t data[4];
+
+    CHECK_ZERO(sensirion_uart_rx_timeout(sizeof(data), data, 10000));
+    CHECK(slept_us >= 10000);
+    CHECK(slept_us <= 11000);
+
+    rx_buf[0] = 0x42;
+    rx_len = 1;
+    slept_us = 0;
+    CHECK_EQUAL(1, sensirion_uart_rx_timeout(sizeof(data), data, 10000));
+    CHECK_EQUAL(0x42, data[0]);
+    CHECK_EQUAL(0, slept_us);
+}
+
+TEST (UART_Fallback_Test, wait_device) {
+    CHECK_ZERO(sensirion_uart_wait_device(1000000));
+    CHECK_EQUAL(0, slept_us);
+}
+
+TEST (UART_Fallback_Test, xcv) {
+    const uint8_t tx_frame[] = {0x7e, 0x00, 0x03, 0x00, 0xfc, 0x7e};
+    const uint8_t rx_frame[] = {0x7e, 0x00, 0x03, 0x00, 0x01, 0x2a, 0xd1, 0x7e};
+    struct sensirion_shdlc_rx_header header;
+    struct sensirion_uart_iovec iov = {tx_frame, sizeof(tx_frame)};
+    uint8_t data;
+
+    memcpy(rx_buf, rx_frame, sizeof(rx_frame));
+    rx_len = sizeof(rx_frame);
+    CHECK_ZERO(sensirion_shdlc_xcv_rawv(1, &iov, 1, &header, &data,
+                                        SENSIRION_SHDLC_RX_TIMEOUT_US));
+    MEMCMP_EQUAL(tx_frame, tx_buf, sizeof(tx_frame));
+    CHECK_EQUAL(1, header.data_len);
+    CHECK_EQUAL(0x2a, data);
+}
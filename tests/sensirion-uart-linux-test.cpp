@@ -0,0 +1,272 @@
+#include "sensirion_shdlc.h"
+#include "sensirion_test_setup.h"
+#include "sensirion_uart.h"
+#include "sensirion_uart_linux.h"
+#include "sensirion_uart_pty.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+
+#define TEST_PORTS 3
+
+/* pseudo terminal master of each port, the HAL opens the slave side */
+static int masters[TEST_PORTS];
+
+TEST_GROUP (UART_Linux_Test) {
+    void setup() {
+        uint8_t port;
+
+        for (port = 0; port < TEST_PORTS; ++port) {
+            masters[port] = pty_open_port(port);
+            CHECK_TRUE(masters[port] >= 0);
+        }
+    }
+
+    void teardown() {
+        uint8_t port;
+
+        for (port = 0; port < TEST_PORTS; ++port) {
+            sensirion_uart_select_port(port);
+            sensirion_uart_close();
+            close(masters[port]);
+        }
+    }
+};
+
+TEST (UART_Linux_Test, ports_are_independent) {
+    uint8_t buf[8];
+    uint8_t port;
+
+    for (port = 0; port < TEST_PORTS; ++port) {
+        CHECK_ZERO(sensirion_uart_select_port(port));
+        CHECK_EQUAL(1, sensirion_uart_tx(1, &port));
+    }
+    for (port = 0; port < TEST_PORTS; ++port) {
+        CHECK_EQUAL(1, read(masters[port], buf, sizeof(buf)));
+        CHECK_EQUAL(port, buf[0]);
+    }
+
+    CHECK_EQUAL(2, write(masters[1], "\x7e\x7e", 2));
+    CHECK_ZERO(sensirion_uart_select_port(0));
+    CHECK_ZERO(sensirion_uart_rx_timeout(sizeof(buf), buf, 1000));
+    CHECK_ZERO(sensirion_uart_select_port(1));
+    CHECK_EQUAL(2, sensirion_uart_rx_timeout(sizeof(buf), buf, 100000));
+}
+
+TEST (UART_Linux_Test, rx_never_blocks) {
+    struct sensirion_shdlc_rx_header header;
+    struct timespec start;
+    struct timespec end;
+    uint8_t buf[8];
+    long elapsed_ms;
+
+    /* nothing to receive: rx returns at once, rx_timeout after the timeout */
+    CHECK_ZERO(sensirion_uart_select_port(0));
+    CHECK_ZERO(sensirion_uart_rx(sizeof(buf), buf));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    CHECK_ZERO(sensirion_uart_rx_timeout(sizeof(buf), buf, 20000));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    elapsed_ms = (end.tv_sec - start.tv_sec) * 1000 +
+                 (end.tv_nsec - start.tv_nsec) / 1000000;
+    CHECK_TRUE(elapsed_ms >= 19);
+    CHECK_TRUE(elapsed_ms < 500);
+
+    /* a partial frame arrives and the sensor stops responding */
+    CHECK_EQUAL(3, write(masters[0], "\x7e\x00\x03", 3));
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_MISSING_STOP,
+                sensirion_shdlc_rx_timeout(0, &header, NULL, 20000));
+}
+
+TEST (UART_Linux_Test, invalid_ports) {
+    char long_path[SENSIRION_UART_MAX_PATH_LEN + 1];
+
+    memset(long_path, 'a', sizeof(long_path) - 1);
+    long_path[sizeof(long_path) - 1] = '\0';
+
+    CHECK_EQUAL(-1, sensirion_uart_select_port(SENSIRION_UART_MAX_PORTS));
+    CHECK_EQUAL(-1, sensirion_uart_set_port_path(SENSIRION_UART_MAX_PORTS,
+                                                 "/dev/null"));
+    CHECK_EQUAL(-1, sensirion_uart_set_port_path(TEST_PORTS, long_path));
+    CHECK_EQUAL(-1, sensirion_uart_set_port_path(TEST_PORTS, ""));
+
+    /* no path registered */
+    CHECK_ZERO(sensirion_uart_select_port(TEST_PORTS));
+    CHECK_EQUAL(-1, sensirion_uart_open());
+    CHECK_EQUAL(-1, sensirion_uart_get_fd());
+    CHECK_EQUAL(-1, sensirion_uart_tx(1, (const uint8_t*)"x"));
+}
+
+/* stable links of USB serial adapters are often longer than 80 characters */
+TEST (UART_Linux_Test, long_by_id_path) {
+    char dir[] = "/tmp/sensirion-uart-by-id-XXXXXX";
+    char tty[SENSIRION_UART_MAX_PATH_LEN];
+    char link[SENSIRION_UART_MAX_PATH_LEN];
+    uint8_t c;
+
+    CHECK_TRUE(mkdtemp(dir) != NULL);
+    CHECK_ZERO(ptsname_r(masters[0], tty, sizeof(tty)));
+    snprintf(link, sizeof(link),
+             "%s/usb-Prolific_Technology_Inc._USB-Serial_Controller_"
+             "ABCDEF0123-if00-port0",
+             dir);
+    CHECK_ZERO(symlink(tty, link));
+
+    CHECK_TRUE(strlen(link) > 82);
+    CHECK_ZERO(sensirion_uart_set_port_path(TEST_PORTS, link));
+    CHECK_ZERO(sensirion_uart_select_port(TEST_PORTS));
+    CHECK_ZERO(sensirion_uart_open());
+    CHECK_EQUAL(1, sensirion_uart_tx(1, (const uint8_t*)"x"));
+    CHECK_EQUAL(1, read(masters[0], &c, 1));
+    CHECK_EQUAL('x', c);
+    CHECK_ZERO(sensirion_uart_close());
+
+    unlink(link);
+    rmdir(dir);
+}
+
+TEST (UART_Linux_Test, reentrant_ops) {
+    const uint8_t frame[] = {0x7e, 0x00, 0x03, 0x00, 0xfc, 0x7e};
+    struct sensirion_shdlc_dev devs[TEST_PORTS];
+    struct sensirion_shdlc_rx_header header;
+    uint8_t buf[8];
+    uint8_t port;
+
+    CHECK_TRUE(sensirion_uart_linux_port(SENSIRION_UART_MAX_PORTS) == NULL);
+
+    for (port = 0; port < TEST_PORTS; ++port) {
+        sensirion_shdlc_dev_init(&devs[port], &sensirion_uart_linux_ops,
+                                 sensirion_uart_linux_port(port));
+        CHECK_ZERO(sensirion_shdlc_tx_raw_dev(&devs[port], sizeof(frame),
+                                              frame));
+    }
+    for (port = 0; port < TEST_PORTS; ++port) {
+        CHECK_EQUAL(sizeof(frame), read(masters[port], buf, sizeof(buf)));
+        MEMCMP_EQUAL(frame, buf, sizeof(frame));
+    }
+
+    /* a response on port 2 is only seen by its device */
+    CHECK_EQUAL(7, write(masters[2], "\x7e\x00\x03\x00\x00\xfc\x7e", 7));
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_MISSING_START,
+                sensirion_shdlc_rx_timeout_dev(&devs[1], 0, &header, NULL,
+                                               1000));
+    CHECK_ZERO(sensirion_shdlc_rx_timeout_dev(&devs[2], 0, &header, NULL,
+                                              100000));
+    CHECK_EQUAL(0x03, header.cmd);
+}
+
+/* SENSIRION_UART_USB_SERIAL_SYSFS points to a directory of fake adapters */
+static void write_latency_timer(const char* tty, const char* value) {
+    char path[256];
+    FILE* f;
+
+    snprintf(path, sizeof(path), "%s/%s", SENSIRION_UART_USB_SERIAL_SYSFS,
+             tty);
+    mkdir(SENSIRION_UART_USB_SERIAL_SYSFS, 0755);
+    mkdir(path, 0755);
+    strcat(path, "/latency_timer");
+    f = fopen(path, "w");
+    CHECK_TRUE(f != NULL);
+    fputs(value, f);
+    fclose(f);
+}
+
+static void remove_latency_timer(const char* tty) {
+    char path[256];
+
+    snprintf(path, sizeof(path), "%s/%s/latency_timer",
+             SENSIRION_UART_USB_SERIAL_SYSFS, tty);
+    unlink(path);
+    *strrchr(path, '/') = '\0';
+    rmdir(path);
+    rmdir(SENSIRION_UART_USB_SERIAL_SYSFS);
+}
+
+TEST (UART_Linux_Test, low_latency_settings) {
+    struct sensirion_uart_linux_settings settings;
+    char path[SENSIRION_UART_MAX_PATH_LEN];
+    const char* tty;
+
+    CHECK_ZERO(ptsname_r(masters[0], path, sizeof(path)));
+    tty = strrchr(path, '/') + 1;
+
+    /* pseudo terminals have neither serial flags nor a latency timer */
+    CHECK_ZERO(sensirion_uart_get_settings(0, &settings));
+    CHECK_ZERO(settings.low_latency);
+    CHECK_ZERO(settings.latency_timer_ms);
+    CHECK_EQUAL(SENSIRION_UART_LOW_LATENCY, settings.tx_drain);
+
+    /* the latency timer of an adapter is lowered on open */
+    write_latency_timer(tty, "16\n");
+    CHECK_ZERO(sensirion_uart_select_port(0));
+    CHECK_ZERO(sensirion_uart_set_low_latency(0, 1));
+    CHECK_ZERO(sensirion_uart_open());
+    CHECK_ZERO(sensirion_uart_get_settings(0, &settings));
+    CHECK_EQUAL(SENSIRION_UART_LATENCY_TIMER_MS, settings.latency_timer_ms);
+    CHECK_EQUAL(1, settings.tx_drain);
+    CHECK_EQUAL(1, sensirion_uart_tx(1, (const uint8_t*)"x"));
+
+    /* and left alone when disabled */
+    write_latency_timer(tty, "16\n");
+    CHECK_ZERO(sensirion_uart_set_low_latency(0, 0));
+    CHECK_ZERO(sensirion_uart_open());
+    CHECK_ZERO(sensirion_uart_get_settings(0, &settings));
+    CHECK_EQUAL(16, settings.latency_timer_ms);
+    CHECK_ZERO(settings.tx_drain);
+
+    remove_latency_timer(tty);
+    CHECK_ZERO(sensirion_uart_set_low_latency(0, SENSIRION_UART_LOW_LATENCY));
+    CHECK_EQUAL(-1,
+                sensirion_uart_set_low_latency(SENSIRION_UART_MAX_PORTS, 1));
+    CHECK_EQUAL(-1, sensirion_uart_get_settings(TEST_PORTS, &settings));
+}
+
+TEST (UART_Linux_Test, wait_device) {
+    char dir[] = "/tmp/sensirion-uart-wait-XXXXXX";
+    char path[SENSIRION_UART_MAX_PATH_LEN];
+    char link[SENSIRION_UART_MAX_PATH_LEN];
+    struct timespec start;
+    struct timespec end;
+    long elapsed_ms;
+
+    CHECK_TRUE(mkdtemp(dir) != NULL);
+    snprintf(path, sizeof(path), "%s/by-id/tty", dir);
+    snprintf(link, sizeof(link), "%s/by-id", dir);
+    CHECK_ZERO(sensirion_uart_set_port_path(TEST_PORTS, path));
+    CHECK_ZERO(sensirion_uart_select_port(TEST_PORTS));
+
+    /* an absent device times out */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    CHECK_EQUAL(-1, sensirion_uart_wait_device(20000));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    elapsed_ms = (end.tv_sec - start.tv_sec) * 1000 +
+                 (end.tv_nsec - start.tv_nsec) / 1000000;
+    CHECK_TRUE(elapsed_ms >= 20);
+
+    /* the device appears in a directory which doesn't exist yet */
+    std::thread plug([&]() {
+        usleep(20000);
+        mkdir(link, 0755);
+        usleep(20000);
+        close(open(path, O_CREAT | O_WRONLY, 0600));
+    });
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    CHECK_ZERO(sensirion_uart_wait_device(5000000));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    plug.join();
+    elapsed_ms = (end.tv_sec - start.tv_sec) * 1000 +
+                 (end.tv_nsec - start.tv_nsec) / 1000000;
+    CHECK_TRUE(elapsed_ms >= 40 && elapsed_ms < 1000);
+
+    /* present devices don't wait */
+    CHECK_ZERO(sensirion_uart_wait_device(0));
+
+    unlink(path);
+    rmdir(link);
+    rmdir(dir);
+}
@@ -0,0 +1,193 @@
+#include "sensirion_test_setup.h"
+#include "sensirion_uart.h"
+#include "sensirion_uart_capture.h"
+#include "sensirion_uart_linux.h"
+#include "sensirion_uart_pty.h"
+#include "sensirion_uart_replay.h"
+#include "sps30.h"
+#include "sps30_simulator.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MEASUREMENT_INTERVAL_US 10000
+#define RESPONSE_DELAY_US 5000
+#define CAPTURED_MEASUREMENTS 3
+
+static char capture_path[] = "/tmp/sensirion-uart-replay-XXXXXX";
+static struct sps30_measurement captured[CAPTURED_MEASUREMENTS];
+
+/* the sequence of commands which is captured and replayed */
+static void measure(struct sps30_dev* dev, struct sps30_measurement* m) {
+    uint8_t i;
+
+    CHECK_ZERO(sps30_start_measurement_dev(dev));
+    for (i = 0; i < CAPTURED_MEASUREMENTS; ++i) {
+        usleep(MEASUREMENT_INTERVAL_US);
+        CHECK_ZERO(sps30_read_measurement_dev(dev, &m[i]));
+    }
+    CHECK_ZERO(sps30_stop_measurement_dev(dev));
+}
+
+TEST_GROUP (Sensirion_UART_Replay_Test) {
+    struct sensirion_uart_replay replay;
+    struct sps30_dev dev;
+
+    void setup() {
+        /* slow responses in small chunks, as sent by a real sensor */
+        struct sps30_simulator_config config = {
+            RESPONSE_DELAY_US, MEASUREMENT_INTERVAL_US, 7, 300, 42};
+        struct sps30_simulator* simulator;
+        int fd;
+
+        memset(&replay, 0, sizeof(replay));
+        fd = mkstemp(capture_path);
+        CHECK_TRUE(fd >= 0);
+        close(fd);
+
+        simulator = sps30_simulator_start(&config);
+        CHECK_TRUE(simulator != NULL);
+        CHECK_ZERO(sensirion_uart_set_port_path(0, sps30_simulator_path(simulator)));
+        CHECK_ZERO(sensirion_uart_select_port(0));
+        CHECK_ZERO(sensirion_uart_open());
+
+        CHECK_ZERO(sensirion_uart_capture_start(capture_path));
+        sps30_dev_init(&dev, &sensirion_uart_linux_ops,
+                       sensirion_uart_linux_port(0));
+        measure(&dev, captured);
+        sensirion_uart_capture_stop();
+
+        sensirion_uart_close();
+        sps30_simulator_stop(simulator);
+    }
+
+    void teardown() {
+        sensirion_uart_replay_close(&replay);
+        unlink(capture_path);
+        strcpy(capture_path, "/tmp/sensirion-uart-replay-XXXXXX");
+    }
+
+    /* replay the captured sequence and measure the time it took */
+    void replay_measure(uint32_t speed,
+                        std::chrono::steady_clock::duration* elapsed) {
+        struct sps30_measurement m[CAPTURED_MEASUREMENTS];
+
+        CHECK_ZERO(sensirion_uart_replay_open(&replay, capture_path, 0, speed));
+        sps30_dev_init(&dev, &sensirion_uart_replay_ops, &replay);
+        auto start = std::chrono::steady_clock::now();
+        measure(&dev, m);
+        *elapsed = std::chrono::steady_clock::now() - start;
+
+        MEMCMP_EQUAL(captured, m, sizeof(m));
+        CHECK_ZERO(replay.tx_mismatches);
+        CHECK_ZERO(replay.rx_timeouts);
+        CHECK_TRUE(sensirion_uart_replay_done(&replay));
+        sensirion_uart_replay_close(&replay);
+    }
+};
+
+TEST (Sensirion_UART_Replay_Test, replay_is_identical) {
+    std::chrono::steady_clock::duration elapsed;
+
+    replay_measure(0, &elapsed);
+}
+
+TEST (Sensirion_UART_Replay_Test, replay_timing) {
+    std::chrono::steady_clock::duration original;
+    std::chrono::steady_clock::duration accelerated;
+
+    replay_measure(1, &original);
+    replay_measure(0, &accelerated);
+
+    /* the five responses are delayed as captured, unless accelerated */
+    CHECK_TRUE(original >=
+               std::chrono::microseconds(5 * RESPONSE_DELAY_US +
+                                         CAPTURED_MEASUREMENTS *
+                                             MEASUREMENT_INTERVAL_US));
+    CHECK_TRUE(accelerated + std::chrono::microseconds(4 * RESPONSE_DELAY_US) <
+               original);
+}
+
+TEST (Sensirion_UART_Replay_Test, unexpected_commands) {
+    struct sps30_version_information version;
+
+    CHECK_ZERO(sensirion_uart_replay_open(&replay, capture_path, 0, 0));
+    sps30_dev_init(&dev, &sensirion_uart_replay_ops, &replay);
+
+    /* the response to the start command was captured for a different one */
+    CHECK_TRUE(sps30_read_version_dev(&dev, &version) != 0);
+    CHECK_EQUAL(1, replay.tx_mismatches);
+
+    /* a port without traffic times out */
+    sensirion_uart_replay_close(&replay);
+    CHECK_ZERO(sensirion_uart_replay_open(&replay, capture_path, 1, 0));
+    sps30_dev_init(&dev, &sensirion_uart_replay_ops, &replay);
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_MISSING_START,
+                sps30_start_measurement_dev(&dev));
+    CHECK_TRUE(sensirion_uart_replay_done(&replay));
+}
+
+/* the records are written as a packed header, see sensirion_uart_capture.h */
+TEST (Sensirion_UART_Replay_Test, record_layout) {
+    const uint8_t data[] = {0x7e, 0x00, 0x03, 0x00, 0xfc, 0x7e};
+    uint8_t bytes[SENSIRION_UART_CAPTURE_MAGIC_LEN +
+                  SENSIRION_UART_CAPTURE_RECORD_SIZE + sizeof(data) + 1];
+    size_t len;
+    FILE* f;
+    int master;
+
+    /* a pseudo terminal without anything on the other end */
+    master = pty_open_port(2);
+    CHECK_TRUE(master >= 0);
+    CHECK_ZERO(sensirion_uart_capture_start(capture_path));
+    CHECK_EQUAL(sizeof(data), sensirion_uart_tx(sizeof(data), data));
+    sensirion_uart_capture_stop();
+    sensirion_uart_close();
+    CHECK_ZERO(sensirion_uart_select_port(0));
+    close(master);
+
+    f = fopen(capture_path, "rb");
+    CHECK_TRUE(f != NULL);
+    len = fread(bytes, 1, sizeof(bytes), f);
+    fclose(f);
+    CHECK_EQUAL(sizeof(bytes) - 1, len);
+    CHECK_EQUAL(12, SENSIRION_UART_CAPTURE_RECORD_SIZE);
+
+    /* len, type and port follow the 8 byte time */
+    CHECK_EQUAL(sizeof(data), bytes[SENSIRION_UART_CAPTURE_MAGIC_LEN + 8]);
+    CHECK_EQUAL(0, bytes[SENSIRION_UART_CAPTURE_MAGIC_LEN + 9]);
+    CHECK_EQUAL(SENSIRION_UART_CAPTURE_TX,
+                bytes[SENSIRION_UART_CAPTURE_MAGIC_LEN + 10]);
+    CHECK_EQUAL(2, bytes[SENSIRION_UART_CAPTURE_MAGIC_LEN + 11]);
+    MEMCMP_EQUAL(data,
+                 &bytes[SENSIRION_UART_CAPTURE_MAGIC_LEN +
+                        SENSIRION_UART_CAPTURE_RECORD_SIZE],
+                 sizeof(data));
+}
+
+TEST (Sensirion_UART_Replay_Test, invalid_captures) {
+    /* an RX record of 10 bytes on port 0 */
+    const uint8_t record[SENSIRION_UART_CAPTURE_RECORD_SIZE] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 10, 0, SENSIRION_UART_CAPTURE_RX, 0};
+    FILE* f;
+
+    CHECK_EQUAL(-1, sensirion_uart_replay_open(&replay, "/nonexistent", 0, 0));
+
+    /* a record without its data */
+    f = fopen(capture_path, "wb");
+    CHECK_TRUE(f != NULL);
+    fwrite(SENSIRION_UART_CAPTURE_MAGIC, SENSIRION_UART_CAPTURE_MAGIC_LEN, 1,
+           f);
+    fwrite(record, sizeof(record), 1, f);
+    fclose(f);
+    CHECK_EQUAL(-1, sensirion_uart_replay_open(&replay, capture_path, 0, 0));
+
+    /* no magic */
+    f = fopen(capture_path, "wb");
+    CHECK_TRUE(f != NULL);
+    fwrite(record, sizeof(record), 1, f);
+    fclose(f);
+    CHECK_EQUAL(-1, sensirion_uart_replay_open(&replay, capture_path, 0, 0));
+}
@@ -0,0 +1,158 @@
+/*
+ * Time to read a measurement from many sensors on the Linux UART HAL, one
+ * port after the other vs. the epoll and io_uring engines. The sensors are
+ * simulated on pseudo terminals, run with `make bench`
+ */
+#include "sensirion_shdlc.h"
+#include "sensirion_shdlc_epoll.h"
+#include "sensirion_shdlc_uring.h"
+#include "sensirion_uart.h"
+#include "sensirion_uart_fake.h"
+#include "sensirion_uart_linux.h"
+#include "sensirion_uart_pty.h"
+#include "sps30.h"
+#include "sps30_frames.h"
+#include <atomic>
+#include <chrono>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <unistd.h>
+
+#define BENCH_PORTS 16
+#define BENCH_SWEEPS 200
+
+static int masters[BENCH_PORTS];
+static std::atomic<bool> running;
+
+/* answer every request on any port with a measurement */
+static void simulate_sensors(void) {
+    struct pollfd pfds[BENCH_PORTS];
+    uint8_t data[SPS30_MEASUREMENT_LEN];
+    uint8_t response[SENSIRION_SHDLC_MAX_TX_FRAME_SIZE + 1];
+    uint8_t request[64];
+    uint16_t len;
+    int i;
+
+    memset(data, 0, sizeof(data));
+    len = fake_encode_response(0x03, 0x00, sizeof(data), data, response);
+
+    for (i = 0; i < BENCH_PORTS; ++i) {
+        pfds[i].fd = masters[i];
+        pfds[i].events = POLLIN;
+    }
+    while (running) {
+        if (poll(pfds, BENCH_PORTS, 10) <= 0)
+            continue;
+        for (i = 0; i < BENCH_PORTS; ++i) {
+            if ((pfds[i].revents & POLLIN) &&
+                read(masters[i], request, sizeof(request)) > 0 &&
+                write(masters[i], response, len) != len)
+                abort();
+        }
+    }
+}
+
+static double sweep_sequential(struct sps30_dev* devs) {
+    struct sps30_measurement m;
+    int i;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int sweep = 0; sweep < BENCH_SWEEPS; ++sweep) {
+        for (i = 0; i < BENCH_PORTS; ++i) {
+            if (sps30_read_measurement_dev(&devs[i], &m))
+                abort();
+        }
+    }
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / BENCH_SWEEPS;
+}
+
+template <typename Loop, typename Port, typename Xcv>
+static double sweep_engine(Loop* loop, Port* ports, Xcv xcv) {
+    auto start = std::chrono::steady_clock::now();
+    for (int sweep = 0; sweep < BENCH_SWEEPS; ++sweep) {
+        if (xcv(loop, BENCH_PORTS, ports, 1000000))
+            abort();
+    }
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count() / BENCH_SWEEPS;
+}
+
+template <typename Port>
+static void setup_port(Port* port, int fd, uint8_t* rx_data) {
+    const struct sps30_frame* request =
+        &sps30_frames[SPS30_FRAME_READ_MEASUREMENT];
+
+    port->fd = fd;
+    port->tx_frame_len = request->len;
+    port->tx_frame = request->bytes;
+    port->max_rx_data_len = SPS30_MEASUREMENT_LEN;
+    port->rx_data = rx_data;
+}
+
+int main(void) {
+    static struct sensirion_shdlc_epoll_port epoll_ports[BENCH_PORTS];
+    static struct sensirion_shdlc_uring_port uring_ports[BENCH_PORTS];
+    static uint8_t rx_data[BENCH_PORTS][SPS30_MEASUREMENT_LEN];
+    struct sensirion_shdlc_epoll epoll_loop;
+    struct sensirion_shdlc_uring uring_loop;
+    struct sps30_dev devs[BENCH_PORTS];
+    double sequential;
+    double epoll;
+    double uring;
+    uint8_t i;
+
+    for (i = 0; i < BENCH_PORTS; ++i) {
+        masters[i] = pty_open_port(i);
+        if (masters[i] < 0)
+            return 1;
+        sps30_dev_init(&devs[i], &sensirion_uart_linux_ops,
+                       sensirion_uart_linux_port(i));
+    }
+
+    if (sensirion_shdlc_epoll_init(&epoll_loop) ||
+        sensirion_shdlc_uring_init(&uring_loop, BENCH_PORTS)) {
+        fprintf(stderr, "epoll or io_uring not available\n");
+        return 1;
+    }
+    for (i = 0; i < BENCH_PORTS; ++i) {
+        sensirion_uart_select_port(i);
+        setup_port(&epoll_ports[i], sensirion_uart_get_fd(), rx_data[i]);
+        setup_port(&uring_ports[i], sensirion_uart_get_fd(), rx_data[i]);
+        sensirion_shdlc_epoll_add(&epoll_loop, &epoll_ports[i]);
+    }
+
+    running = true;
+    std::thread sensors(simulate_sensors);
+
+    sequential = sweep_sequential(devs);
+    epoll = sweep_engine(&epoll_loop, epoll_ports, sensirion_shdlc_epoll_xcv);
+    uring = sweep_engine(&uring_loop, uring_ports, sensirion_shdlc_uring_xcv);
+
+    running = false;
+    sensors.join();
+
+    printf("%-38s %11s %11s\n", "", "us/sweep", "speedup");
+    printf("read %2u sensors, %-21s %11.1f %10.2fx\n", BENCH_PORTS,
+           "one after the other", sequential, 1.0);
+    printf("read %2u sensors, %-21s %11.1f %10.2fx\n", BENCH_PORTS, "epoll",
+           epoll, sequential / epoll);
+    printf("read %2u sensors, %-21s %11.1f %10.2fx\n", BENCH_PORTS, "io_uring",
+           uring, sequential / uring);
+    printf("io_uring_enter() calls per sweep: %.1f\n",
+           (double)uring_loop.enters / BENCH_SWEEPS);
+
+    sensirion_shdlc_uring_close(&uring_loop);
+    sensirion_shdlc_epoll_close(&epoll_loop);
+    for (i = 0; i < BENCH_PORTS; ++i) {
+        sensirion_uart_select_port(i);
+        sensirion_uart_close();
+        close(masters[i]);
+    }
+    return 0;
+}
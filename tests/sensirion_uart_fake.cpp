@@ -0,0 +1,174 @@
+#include "sensirion_uart_fake.h"
+#include "sensirion_shdlc.h"
+#include "sensirion_uart.h"
+#include <string.h>
+#include <unistd.h>
+
+uint8_t fake_rx_buf[1024];
+uint16_t fake_rx_len;
+uint16_t fake_rx_pos;
+uint16_t fake_rx_chunk_size;
+uint16_t fake_rx_calls;
+
+uint8_t fake_tx_buf[1024];
+uint16_t fake_tx_len;
+uint16_t fake_tx_calls;
+
+void fake_uart_rx_feed(const uint8_t* bytes, uint16_t len,
+                       uint16_t chunk_size) {
+    /* the default device reads ahead, those bytes are replaced as well */
+    sensirion_shdlc_default_dev()->rx_pending_len = 0;
+    memcpy(fake_rx_buf, bytes, len);
+    fake_rx_len = len;
+    fake_rx_pos = 0;
+    fake_rx_chunk_size = chunk_size;
+    fake_rx_calls = 0;
+}
+
+void fake_uart_rx_append(const uint8_t* bytes, uint16_t len) {
+    memcpy(&fake_rx_buf[fake_rx_len], bytes, len);
+    fake_rx_len += len;
+}
+
+void fake_uart_reset(void) {
+    sensirion_shdlc_default_dev()->rx_pending_len = 0;
+    fake_rx_len = 0;
+    fake_rx_pos = 0;
+    fake_rx_chunk_size = sizeof(fake_rx_buf);
+    fake_rx_calls = 0;
+    fake_tx_len = 0;
+    fake_tx_calls = 0;
+}
+
+static int16_t fake_sensor_tx(void* ctx, uint16_t data_len,
+                              const uint8_t* data) {
+    struct fake_sensor* sensor = (struct fake_sensor*)ctx;
+    uint8_t measurement[40];
+    uint16_t i = 0;
+    uint8_t cmd;
+
+    if (sensor->tx_delay_us)
+        usleep(sensor->tx_delay_us);
+
+    /* skip the wake-up byte, the command follows start and address */
+    while (i < data_len && data[i] != 0x7e)
+        ++i;
+    if (i + 3u > data_len)
+        return (int16_t)data_len;
+    cmd = data[i + 2];
+    if (cmd == 0x7d)
+        cmd = data[i + 3] ^ 0x20;
+    ++sensor->cmd_count[cmd];
+
+    sensor->rx_len = 0;
+    sensor->rx_pos = 0;
+    if (sensor->ignore_count) {
+        --sensor->ignore_count;
+        return (int16_t)data_len;
+    }
+    if (cmd == 0x03) {
+        ++sensor->measurements;
+        for (i = 0; i < 10; ++i)
+            sensirion_float_to_bytes(sensor->measurements,
+                                     &measurement[i * 4]);
+        sensor->rx_len = fake_encode_response(cmd, 0, sizeof(measurement),
+                                              measurement, sensor->rx_buf);
+    } else {
+        sensor->rx_len = fake_encode_response(cmd, 0, 0, NULL, sensor->rx_buf);
+    }
+    sensor->rx_pos = 0;
+    return (int16_t)data_len;
+}
+
+static int16_t fake_sensor_txv(void* ctx, uint8_t iovcnt,
+                               const struct sensirion_uart_iovec* iov) {
+    uint8_t frame[SENSIRION_SHDLC_MAX_TX_FRAME_SIZE + 1];
+    uint16_t len = 0;
+    uint8_t i;
+
+    for (i = 0; i < iovcnt; ++i) {
+        memcpy(&frame[len], iov[i].data, iov[i].len);
+        len += iov[i].len;
+    }
+    return fake_sensor_tx(ctx, len, frame);
+}
+
+static int16_t fake_sensor_rx_timeout(void* ctx, uint16_t max_data_len,
+                                      uint8_t* data, uint32_t timeout_us) {
+    struct fake_sensor* sensor = (struct fake_sensor*)ctx;
+    uint16_t len = sensor->rx_len - sensor->rx_pos;
+
+    if (len > max_data_len)
+        len = max_data_len;
+    memcpy(data, &sensor->rx_buf[sensor->rx_pos], len);
+    sensor->rx_pos += len;
+    return (int16_t)len;
+}
+
+const struct sensirion_uart_ops fake_sensor_ops = {
+    fake_sensor_tx,
+    fake_sensor_txv,
+    fake_sensor_rx_timeout,
+};
+
+extern "C" {
+
+int16_t sensirion_uart_select_port(uint8_t port) {
+    return 0;
+}
+
+int16_t sensirion_uart_open() {
+    return 0;
+}
+
+int16_t sensirion_uart_close() {
+    return 0;
+}
+
+int16_t sensirion_uart_tx(uint16_t data_len, const uint8_t* data) {
+    memcpy(&fake_tx_buf[fake_tx_len], data, data_len);
+    fake_tx_len += data_len;
+    ++fake_tx_calls;
+    return (int16_t)data_len;
+}
+
+int16_t sensirion_uart_txv(uint8_t iovcnt,
+                           const struct sensirion_uart_iovec* iov) {
+    uint16_t len = 0;
+    uint8_t i;
+
+    if (iovcnt > SENSIRION_UART_MAX_IOV)
+        return -1;
+    for (i = 0; i < iovcnt; ++i) {
+        memcpy(&fake_tx_buf[fake_tx_len + len], iov[i].data, iov[i].len);
+        len += iov[i].len;
+    }
+    fake_tx_len += len;
+    ++fake_tx_calls;
+    return (int16_t)len;
+}
+
+int16_t sensirion_uart_rx(uint16_t max_data_len, uint8_t* data) {
+    uint16_t len = fake_rx_len - fake_rx_pos;
+
+    if (len > max_data_len)
+        len = max_data_len;
+    if (len > fake_rx_chunk_size)
+        len = fake_rx_chunk_size;
+    memcpy(data, &fake_rx_buf[fake_rx_pos], len);
+    fake_rx_pos += len;
+    ++fake_rx_calls;
+    return (int16_t)len;
+}
+
+int16_t sensirion_uart_rx_timeout(uint16_t max_data_len, uint8_t* data,
+                                  uint32_t timeout_us) {
+    if (fake_rx_pos >= fake_rx_len)
+        return 0;
+    return sensirion_uart_rx(max_data_len, data);
+}
+
+void sensirion_sleep_usec(uint32_t useconds) {
+}
+
+}  // extern "C"
@@ -0,0 +1,57 @@
+#ifndef SENSIRION_UART_FAKE_H
+#define SENSIRION_UART_FAKE_H
+
+#include "sensirion_arch_config.h"
+#include "sensirion_uart.h"
+
+/*
+ * Fake UART HAL: sensirion_uart_rx() hands out the bytes in fake_rx_buf in
+ * chunks of at most fake_rx_chunk_size bytes per call, sensirion_uart_tx() and
+ * sensirion_uart_txv() record the transmitted bytes in fake_tx_buf.
+ */
+extern uint8_t fake_rx_buf[1024];
+extern uint16_t fake_rx_len;
+extern uint16_t fake_rx_pos;
+extern uint16_t fake_rx_chunk_size;
+extern uint16_t fake_rx_calls;
+
+extern uint8_t fake_tx_buf[1024];
+extern uint16_t fake_tx_len;
+extern uint16_t fake_tx_calls;
+
+/* queue bytes to be received, replacing any bytes not yet received, including
+ * those the default SHDLC device read ahead */
+void fake_uart_rx_feed(const uint8_t* bytes, uint16_t len,
+                       uint16_t chunk_size);
+
+/* queue bytes to be received after the bytes queued before */
+void fake_uart_rx_append(const uint8_t* bytes, uint16_t len);
+
+/* forget all transmitted and queued bytes */
+void fake_uart_reset(void);
+
+/* encode a response frame with the given data, return its length. Defined in
+ * sensirion_uart_fake_frame.cpp, which can be used without the fake HAL */
+uint16_t fake_encode_response(uint8_t cmd, uint8_t state, uint8_t data_len,
+                              const uint8_t* data, uint8_t* frame);
+
+/*
+ * Fake SPS30 for the reentrant API: answers each command frame transmitted
+ * through fake_sensor_ops with an empty response, except for read measurement
+ * which returns measurements with all values set to the number of
+ * measurements read so far. Each transmission takes at least tx_delay_us, the
+ * next ignore_count commands are left unanswered.
+ */
+struct fake_sensor {
+    uint32_t tx_delay_us;
+    uint16_t ignore_count;
+    uint8_t rx_buf[128];
+    uint16_t rx_len;
+    uint16_t rx_pos;
+    uint16_t cmd_count[256];
+    uint16_t measurements;
+};
+
+extern const struct sensirion_uart_ops fake_sensor_ops;
+
+#endif /* SENSIRION_UART_FAKE_H */
@@ -0,0 +1,36 @@
+#include "sensirion_uart_fake.h"
+#include <string.h>
+
+/* kept apart from the fake UART HAL so the tests on the Linux UART HAL can
+ * encode their responses too */
+
+uint16_t fake_encode_response(uint8_t cmd, uint8_t state, uint8_t data_len,
+                              const uint8_t* data, uint8_t* frame) {
+    uint8_t raw[4 + 255 + 1];
+    uint16_t len = 0;
+    uint16_t i;
+    uint8_t sum = 0;
+
+    raw[0] = 0x00;
+    raw[1] = cmd;
+    raw[2] = state;
+    raw[3] = data_len;
+    if (data_len)
+        memcpy(&raw[4], data, data_len);
+    for (i = 0; i < 4u + data_len; ++i)
+        sum += raw[i];
+    raw[i] = (uint8_t)~sum;
+
+    frame[len++] = 0x7e;
+    for (i = 0; i < 5u + data_len; ++i) {
+        if (raw[i] == 0x11 || raw[i] == 0x13 || raw[i] == 0x7d ||
+            raw[i] == 0x7e) {
+            frame[len++] = 0x7d;
+            frame[len++] = raw[i] ^ 0x20;
+        } else {
+            frame[len++] = raw[i];
+        }
+    }
+    frame[len++] = 0x7e;
+    return len;
+}
@@ -0,0 +1,33 @@
+#include "sensirion_uart_pty.h"
+#include "sensirion_uart.h"
+#include "sensirion_uart_linux.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+int pty_open(char* path, size_t path_size) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (master < 0)
+        return -1;
+    if (grantpt(master) || unlockpt(master) ||
+        ptsname_r(master, path, path_size)) {
+        close(master);
+        return -1;
+    }
+    return master;
+}
+
+int pty_open_port(uint8_t port) {
+    char path[SENSIRION_UART_MAX_PATH_LEN];
+    int master = pty_open(path, sizeof(path));
+
+    if (master < 0)
+        return -1;
+    if (sensirion_uart_set_port_path(port, path) ||
+        sensirion_uart_select_port(port) || sensirion_uart_open()) {
+        close(master);
+        return -1;
+    }
+    return master;
+}
@@ -0,0 +1,21 @@
+#ifndef SENSIRION_UART_PTY_H
+#define SENSIRION_UART_PTY_H
+
+#include "sensirion_arch_config.h"
+#include <stddef.h>
+
+/*
+ * Pseudo terminals standing in for serial ports: the test talks on the master
+ * side, the Linux UART HAL opens the slave side. Use fake_encode_response() of
+ * sensirion_uart_fake.h to answer on the master side.
+ */
+
+/* open a pseudo terminal and store the path of its slave side, return the
+ * master or -1 */
+int pty_open(char* path, size_t path_size);
+
+/* open a pseudo terminal as port of the Linux UART HAL, the port is selected
+ * and open afterwards. Return the master or -1 */
+int pty_open_port(uint8_t port);
+
+#endif /* SENSIRION_UART_PTY_H */
@@ -0,0 +1,211 @@
+#include "sensirion_test_setup.h"
+#include "sensirion_uart_fake.h"
+#include "sps30.h"
+#include "sps30_acquisition.h"
+#include <string.h>
+#include <unistd.h>
+
+#define INTERVAL_US 2000
+#define RING_SIZE 4
+
+static struct fake_sensor fake;
+static struct sps30_dev dev;
+static struct sps30_acquisition acq;
+static struct sps30_acq_sample ring[64];
+
+/* samples passed to the callback */
+static struct sps30_acq_sample received[1024];
+static uint16_t received_count;
+static uint16_t max_batch;
+static uint16_t batches;
+static uint32_t callback_delay_us;
+
+static void collect(const struct sps30_acq_sample* samples, uint16_t count,
+                    void* ctx) {
+    CHECK_TRUE(ctx == &acq);
+    if (count > max_batch)
+        max_batch = count;
+    ++batches;
+    if (received_count + count <= 1024) {
+        memcpy(&received[received_count], samples, count * sizeof(*samples));
+        received_count = (uint16_t)(received_count + count);
+    }
+    if (callback_delay_us)
+        usleep(callback_delay_us);
+}
+
+static void start(enum sps30_acq_overflow overflow, uint32_t ring_size,
+                  sps30_acq_callback callback) {
+    struct sps30_acq_config config = {INTERVAL_US, overflow, ring_size, ring,
+                                      callback, &acq};
+
+    CHECK_ZERO(sps30_acquisition_start(&acq, &dev, &config));
+}
+
+/* wait until the acquisition read more than the given number of measurements,
+ * independent of how the test threads are scheduled */
+static void wait_reads(uint32_t reads) {
+    uint32_t i;
+
+    for (i = 0; i < 1000; ++i) {
+        if (__atomic_load_n(&acq.reads, __ATOMIC_RELAXED) > reads)
+            return;
+        usleep(INTERVAL_US);
+    }
+    FAIL("no measurements read");
+}
+
+/* consecutive reads with the fake's values, each sample a single read */
+static void check_sequence(const struct sps30_acq_sample* samples,
+                           uint16_t count) {
+    uint16_t i;
+
+    for (i = 0; i < count; ++i) {
+        CHECK_EQUAL(samples[0].seq + i, samples[i].seq);
+        CHECK_EQUAL(1, samples[i].count);
+        CHECK_ZERO(samples[i].status);
+        CHECK_EQUAL((float)(samples[i].seq + 1), samples[i].measurement.mc_1p0);
+        if (i)
+            CHECK_TRUE(samples[i].time_us > samples[i - 1].time_us);
+    }
+}
+
+TEST_GROUP (SPS30_Acquisition_Test) {
+    void setup() {
+        memset(&fake, 0, sizeof(fake));
+        sps30_dev_init(&dev, &fake_sensor_ops, &fake);
+        received_count = 0;
+        max_batch = 0;
+        batches = 0;
+        callback_delay_us = 0;
+    }
+};
+
+TEST (SPS30_Acquisition_Test, drain_in_batches) {
+    struct sps30_acq_sample samples[40];
+    uint16_t count = 0;
+    uint64_t span;
+
+    start(SPS30_ACQ_DROP_OLDEST, 64, NULL);
+    while (count < 40)
+        count = (uint16_t)(count + sps30_acquisition_drain(
+                                       &acq, &samples[count],
+                                       (uint16_t)(40 - count), 100000));
+    sps30_acquisition_stop(&acq);
+
+    check_sequence(samples, count);
+    CHECK_EQUAL(0, samples[0].seq);
+    CHECK_ZERO(acq.dropped);
+    CHECK_ZERO(acq.errors);
+    /* reads are never closer than the interval on average, a late read
+     * does not move the following ones */
+    span = samples[39].time_us - samples[0].time_us;
+    CHECK_TRUE(span >= 39 * INTERVAL_US - 1000);
+}
+
+TEST (SPS30_Acquisition_Test, drop_oldest) {
+    struct sps30_acq_sample samples[RING_SIZE];
+    uint16_t count;
+
+    start(SPS30_ACQ_DROP_OLDEST, RING_SIZE, NULL);
+    wait_reads(2 * RING_SIZE);
+    count = sps30_acquisition_drain(&acq, samples, RING_SIZE, 0);
+    sps30_acquisition_stop(&acq);
+
+    /* the newest samples are kept */
+    CHECK_EQUAL(RING_SIZE, count);
+    check_sequence(samples, count);
+    CHECK_TRUE(acq.dropped > 0);
+    CHECK_TRUE(samples[0].seq >= acq.dropped);
+}
+
+TEST (SPS30_Acquisition_Test, block) {
+    struct sps30_acq_sample samples[RING_SIZE];
+    uint16_t count;
+
+    start(SPS30_ACQ_BLOCK, RING_SIZE, NULL);
+    wait_reads(RING_SIZE);
+    usleep(10 * INTERVAL_US);
+    /* the producer waits once the ring is full */
+    CHECK_EQUAL(RING_SIZE + 1, acq.reads);
+    count = sps30_acquisition_drain(&acq, samples, RING_SIZE, 0);
+    CHECK_EQUAL(RING_SIZE, count);
+    check_sequence(samples, count);
+    CHECK_EQUAL(0, samples[0].seq);
+
+    /* and continues as soon as there is room again */
+    count = sps30_acquisition_drain(&acq, samples, 1, 100000);
+    CHECK_EQUAL(1, count);
+    CHECK_EQUAL(RING_SIZE, samples[0].seq);
+    sps30_acquisition_stop(&acq);
+    CHECK_ZERO(acq.dropped);
+}
+
+TEST (SPS30_Acquisition_Test, aggregate) {
+    struct sps30_acq_sample samples[RING_SIZE];
+    uint16_t count;
+    uint32_t n;
+
+    start(SPS30_ACQ_AGGREGATE, RING_SIZE, NULL);
+    wait_reads(2 * RING_SIZE);
+    count = sps30_acquisition_drain(&acq, samples, RING_SIZE, 0);
+    CHECK_EQUAL(RING_SIZE, count);
+    check_sequence(samples, count);
+
+    /* the measurements which did not fit are averaged into one sample */
+    count = sps30_acquisition_drain(&acq, samples, 1, 100000);
+    sps30_acquisition_stop(&acq);
+    CHECK_EQUAL(1, count);
+    CHECK_EQUAL(RING_SIZE, samples[0].seq);
+    n = samples[0].count;
+    CHECK_TRUE(n > 1);
+    CHECK_TRUE(acq.aggregated >= n - 1);
+    /* the average of the values seq + 1 to seq + n */
+    DOUBLES_EQUAL(RING_SIZE + (n + 1) / 2.0, samples[0].measurement.mc_1p0,
+                  0.001);
+    CHECK_ZERO(acq.dropped);
+}
+
+TEST (SPS30_Acquisition_Test, slow_callback) {
+    /* the consumer takes three intervals per batch */
+    callback_delay_us = 3 * INTERVAL_US;
+    start(SPS30_ACQ_DROP_OLDEST, 64, collect);
+    wait_reads(20);
+    sps30_acquisition_stop(&acq);
+
+    /* the reads went on while the callback was busy, the samples piled up
+     * and arrived in batches */
+    CHECK_EQUAL(acq.reads, received_count);
+    CHECK_TRUE(batches < received_count);
+    CHECK_TRUE(max_batch > 1 && max_batch <= SPS30_ACQ_BATCH_SIZE);
+    check_sequence(received, received_count);
+    CHECK_ZERO(acq.dropped);
+}
+
+TEST (SPS30_Acquisition_Test, skipped_slots) {
+    uint16_t i;
+
+    /* every read takes two and a half intervals */
+    fake.tx_delay_us = 5 * INTERVAL_US / 2;
+    start(SPS30_ACQ_DROP_OLDEST, 64, collect);
+    wait_reads(5);
+    sps30_acquisition_stop(&acq);
+
+    /* the late slots are not caught up but recorded as gaps */
+    CHECK_EQUAL(acq.reads, received_count);
+    CHECK_TRUE(acq.timer.skipped >= received_count - 1u);
+    for (i = 1; i < received_count; ++i)
+        CHECK_TRUE(received[i].slot >= received[i - 1].slot + 2);
+    CHECK_EQUAL(received_count + acq.timer.skipped,
+                received[received_count - 1].slot + 1);
+}
+
+TEST (SPS30_Acquisition_Test, invalid_config) {
+    struct sps30_acq_config config = {INTERVAL_US, SPS30_ACQ_BLOCK, 3, ring,
+                                      NULL, NULL};
+
+    CHECK_EQUAL(-1, sps30_acquisition_start(&acq, &dev, &config));
+    config.ring_size = 4;
+    config.interval_us = 0;
+    CHECK_EQUAL(-1, sps30_acquisition_start(&acq, &dev, &config));
+}
@@ -0,0 +1,156 @@
+#include "sensirion_test_setup.h"
+#include "sensirion_uart.h"
+#include "sensirion_uart_linux.h"
+#include "sensirion_uart_pty.h"
+#include "sps30_coro.hpp"
+#include "sps30_simulator.h"
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_SENSORS 8
+#define TEST_RESPONSE_DELAY_US 20000
+#define TEST_COMMANDS 4
+
+using namespace sps30::coro;
+
+static struct sps30_simulator* simulators[TEST_SENSORS];
+
+static void open_simulator(uint8_t i, uint32_t response_delay_us, int* fd) {
+    struct sps30_simulator_config config = {response_delay_us, 10000, 0, 0, 42,
+                                            NULL};
+
+    simulators[i] = sps30_simulator_start(&config);
+    CHECK_TRUE(simulators[i] != NULL);
+    CHECK_ZERO(sensirion_uart_set_port_path(i, sps30_simulator_path(
+                                                   simulators[i])));
+    CHECK_ZERO(sensirion_uart_open_port(i));
+    CHECK_ZERO(sensirion_uart_select_port(i));
+    *fd = sensirion_uart_get_fd();
+}
+
+static Task<int16_t> command_sequence(Sensor& sensor,
+                                      struct sps30_measurement* m) {
+    int16_t error;
+
+    error = co_await sensor.wake_up();
+    if (error)
+        co_return error;
+    auto serial = co_await sensor.get_serial();
+    if (serial.error || !strlen(serial.value.str))
+        co_return serial.error ? serial.error : -1;
+    auto version = co_await sensor.read_version();
+    if (version.error || version.value.firmware_major != 2)
+        co_return version.error ? version.error : -1;
+    error = co_await sensor.start_measurement();
+    if (error)
+        co_return error;
+    /* no measurement yet */
+    auto early = co_await sensor.read_measurement();
+    if (early.error != SPS30_ERR_NOT_ENOUGH_DATA)
+        co_return -1;
+    usleep(10000);
+    auto measurement = co_await sensor.read_measurement();
+    if (measurement.error)
+        co_return measurement.error;
+    *m = measurement.value;
+    error = co_await sensor.stop_measurement();
+    if (error)
+        co_return error;
+    co_return co_await sensor.sleep();
+}
+
+static Task<int16_t> read_versions(Sensor& sensor) {
+    for (int i = 0; i < TEST_COMMANDS; ++i) {
+        auto version = co_await sensor.read_version();
+        if (version.error)
+            co_return version.error;
+    }
+    co_return 0;
+}
+
+static Task<int16_t> read_serial(Sensor& sensor) {
+    auto serial = co_await sensor.get_serial();
+    co_return serial.error;
+}
+
+TEST_GROUP (SPS30_Coro_Test) {
+    uint8_t sensors = 0;
+
+    void teardown() {
+        while (sensors--) {
+            sensirion_uart_close_port(sensors);
+            sps30_simulator_stop(simulators[sensors]);
+        }
+    }
+};
+
+TEST (SPS30_Coro_Test, command_sequence) {
+    struct sps30_measurement expected;
+    struct sps30_measurement m;
+    EpollReactor reactor;
+    int fd;
+
+    CHECK_TRUE(reactor.valid());
+    open_simulator(sensors++, 0, &fd);
+    Sensor sensor(reactor, fd);
+    auto task = command_sequence(sensor, &m);
+    task.start();
+    reactor.run();
+
+    CHECK_TRUE(task.done());
+    CHECK_ZERO(task.result());
+    sps30_simulator_last_measurement(simulators[0], &expected);
+    MEMCMP_EQUAL(&expected, &m, sizeof(m));
+    CHECK_EQUAL(1, sps30_simulator_command_count(simulators[0], 0x11));
+}
+
+TEST (SPS30_Coro_Test, concurrent_sensors) {
+    EpollReactor reactor;
+    std::vector<Sensor> sensor_list;
+    std::vector<Task<int16_t>> tasks;
+    int fd;
+
+    for (; sensors < TEST_SENSORS; ++sensors) {
+        open_simulator(sensors, TEST_RESPONSE_DELAY_US, &fd);
+        sensor_list.emplace_back(reactor, fd);
+    }
+    for (auto& sensor : sensor_list)
+        tasks.push_back(read_versions(sensor));
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto& task : tasks)
+        task.start();
+    reactor.run();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+    for (auto& task : tasks) {
+        CHECK_TRUE(task.done());
+        CHECK_ZERO(task.result());
+    }
+    /* the responses overlap, way faster than one sensor after another */
+    CHECK_TRUE(elapsed < TEST_SENSORS * TEST_COMMANDS *
+                             TEST_RESPONSE_DELAY_US / 2);
+}
+
+TEST (SPS30_Coro_Test, timeout) {
+    EpollReactor reactor;
+    int master;
+
+    /* a pseudo terminal nobody answers on */
+    master = pty_open_port(0);
+    CHECK_TRUE(master >= 0);
+
+    Sensor sensor(reactor, sensirion_uart_get_fd());
+    auto task = read_serial(sensor);
+    task.start();
+    reactor.run();
+
+    CHECK_TRUE(task.done());
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_MISSING_START, task.result());
+    sensirion_uart_close_port(0);
+    close(master);
+}
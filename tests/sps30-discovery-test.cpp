@@ -0,0 +1,142 @@
+#include "sensirion_test_setup.h"
+#include "sensirion_uart.h"
+#include "sensirion_uart_linux.h"
+#include "sensirion_uart_pty.h"
+#include "sps30.h"
+#include "sps30_discovery.h"
+#include "sps30_simulator.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_SENSORS 3
+#define TEST_SILENT_DEVICES 3
+
+static const char* const serials[TEST_SENSORS] = {
+    "TESTSERIAL000001", "TESTSERIAL000002", "TESTSERIAL000003"};
+
+static struct sps30_simulator* simulators[TEST_SENSORS];
+/* pseudo terminals of devices which never answer */
+static int silent_masters[TEST_SILENT_DEVICES];
+static char silent_paths[TEST_SILENT_DEVICES][SENSIRION_UART_MAX_PATH_LEN];
+static char cache_path[] = "/tmp/sps30-discovery-XXXXXX";
+
+static void start_simulator(uint8_t i) {
+    struct sps30_simulator_config config = {0, 10000, 0, 0, 42, serials[i]};
+
+    simulators[i] = sps30_simulator_start(&config);
+    CHECK_TRUE(simulators[i] != NULL);
+}
+
+static void check_sensors(const struct sps30_discovery* discovery) {
+    struct sps30_version_information version;
+    const struct sps30_discovery_sensor* sensor;
+    struct sps30_dev dev;
+    uint8_t i;
+
+    CHECK_EQUAL(TEST_SENSORS, discovery->sensor_count);
+    for (i = 0; i < TEST_SENSORS; ++i) {
+        sensor = sps30_discovery_find(discovery, serials[i]);
+        CHECK_TRUE(sensor != NULL);
+        STRCMP_EQUAL(sps30_simulator_path(simulators[i]), sensor->path);
+
+        /* the port of the sensor is open */
+        sps30_dev_init(&dev, &sensirion_uart_linux_ops,
+                       sensirion_uart_linux_port(sensor->port));
+        CHECK_ZERO(sps30_read_version_dev(&dev, &version));
+    }
+    CHECK_TRUE(sps30_discovery_find(discovery, "UNKNOWN") == NULL);
+}
+
+TEST_GROUP (SPS30_Discovery_Test) {
+    const char* patterns[TEST_SENSORS + TEST_SILENT_DEVICES + 3];
+
+    void setup() {
+        uint8_t n = 0;
+        uint8_t i;
+        int fd;
+
+        fd = mkstemp(cache_path);
+        CHECK_TRUE(fd >= 0);
+        close(fd);
+        unlink(cache_path);
+
+        for (i = 0; i < TEST_SILENT_DEVICES; ++i) {
+            silent_masters[i] =
+                pty_open(silent_paths[i], sizeof(silent_paths[i]));
+            CHECK_TRUE(silent_masters[i] >= 0);
+            patterns[n++] = silent_paths[i];
+        }
+        for (i = 0; i < TEST_SENSORS; ++i) {
+            start_simulator(i);
+            patterns[n++] = sps30_simulator_path(simulators[i]);
+        }
+        /* no match and a device listed twice */
+        patterns[n++] = "/nonexistent/tty*";
+        patterns[n++] = sps30_simulator_path(simulators[0]);
+        patterns[n] = NULL;
+    }
+
+    void teardown() {
+        uint8_t i;
+
+        for (i = 0; i < SENSIRION_UART_MAX_PORTS; ++i)
+            sensirion_uart_close_port(i);
+        for (i = 0; i < TEST_SENSORS; ++i)
+            sps30_simulator_stop(simulators[i]);
+        for (i = 0; i < TEST_SILENT_DEVICES; ++i)
+            close(silent_masters[i]);
+        unlink(cache_path);
+        strcpy(cache_path, "/tmp/sps30-discovery-XXXXXX");
+    }
+};
+
+TEST (SPS30_Discovery_Test, parallel_scan) {
+    struct sps30_discovery discovery;
+
+    auto start = std::chrono::steady_clock::now();
+    CHECK_ZERO(sps30_discover(&discovery, patterns, NULL));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    check_sensors(&discovery);
+    CHECK_EQUAL(TEST_SENSORS + TEST_SILENT_DEVICES, discovery.probe_count);
+    CHECK_ZERO(discovery.from_cache);
+    /* the silent devices time out at the same time, not one after another */
+    CHECK_TRUE(elapsed < std::chrono::milliseconds(300));
+}
+
+TEST (SPS30_Discovery_Test, cached_sensors_are_verified) {
+    struct sps30_discovery discovery;
+
+    CHECK_ZERO(sps30_discover(&discovery, patterns, cache_path));
+    CHECK_ZERO(discovery.from_cache);
+    CHECK_ZERO(access(cache_path, R_OK));
+
+    /* only the cached sensors are probed on the next start */
+    CHECK_ZERO(sps30_discover(&discovery, patterns, cache_path));
+    check_sensors(&discovery);
+    CHECK_EQUAL(1, discovery.from_cache);
+    CHECK_EQUAL(TEST_SENSORS, discovery.probe_count);
+}
+
+TEST (SPS30_Discovery_Test, moved_sensors_are_rescanned) {
+    struct sps30_discovery discovery;
+
+    CHECK_ZERO(sps30_discover(&discovery, patterns, cache_path));
+
+    /* replugging the second sensor gives it another device */
+    sps30_simulator_stop(simulators[1]);
+    start_simulator(1);
+    patterns[TEST_SILENT_DEVICES + 1] = sps30_simulator_path(simulators[1]);
+
+    CHECK_ZERO(sps30_discover(&discovery, patterns, cache_path));
+    check_sensors(&discovery);
+    CHECK_ZERO(discovery.from_cache);
+    CHECK_EQUAL(2 * TEST_SENSORS + TEST_SILENT_DEVICES, discovery.probe_count);
+
+    /* and the cache follows */
+    CHECK_ZERO(sps30_discover(&discovery, patterns, cache_path));
+    CHECK_EQUAL(1, discovery.from_cache);
+}
@@ -0,0 +1,133 @@
+/*
+ * Time to read a measurement with the C driver vs. the template driver,
+ * both on an in-memory UART answering every command with the same response,
+ * i.e. the per-transaction overhead of each driver. Run with `make bench`
+ */
+#include "sensirion_shdlc.h"
+#include "sensirion_uart.h"
+#include "sensirion_uart_mock.hpp"
+#include "sps30.h"
+#include "sps30.hpp"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_READS 100000
+#define BENCH_RUNS 7
+
+static volatile uint32_t sink;
+
+/* the C driver's UART: every transmission rewinds the response */
+struct memory_uart {
+    uint8_t response[128];
+    uint16_t len;
+    uint16_t pos;
+};
+
+static int16_t memory_tx(void* ctx, uint16_t data_len, const uint8_t* data) {
+    ((struct memory_uart*)ctx)->pos = 0;
+    sink += data[0];
+    return (int16_t)data_len;
+}
+
+static int16_t memory_txv(void* ctx, uint8_t iovcnt,
+                          const struct sensirion_uart_iovec* iov) {
+    uint16_t len = 0;
+
+    ((struct memory_uart*)ctx)->pos = 0;
+    while (iovcnt--)
+        len = (uint16_t)(len + (iov++)->len);
+    return (int16_t)len;
+}
+
+static int16_t memory_rx_timeout(void* ctx, uint16_t max_data_len,
+                                 uint8_t* data, uint32_t timeout_us) {
+    struct memory_uart* uart = (struct memory_uart*)ctx;
+    uint16_t len = (uint16_t)(uart->len - uart->pos);
+
+    if (len > max_data_len)
+        len = max_data_len;
+    memcpy(data, &uart->response[uart->pos], len);
+    uart->pos = (uint16_t)(uart->pos + len);
+    return (int16_t)len;
+}
+
+static const struct sensirion_uart_ops memory_uart_ops = {
+    memory_tx, memory_txv, memory_rx_timeout};
+
+static void check(int16_t ret, const char* what) {
+    if (ret) {
+        fprintf(stderr, "%s failed: %d\n", what, ret);
+        exit(1);
+    }
+}
+
+/* best of BENCH_RUNS runs in ns per measurement */
+static double bench_c(struct memory_uart* uart) {
+    struct sps30_measurement m;
+    struct sps30_dev dev;
+    double best = 0;
+    uint32_t i;
+    int run;
+
+    sps30_dev_init(&dev, &memory_uart_ops, uart);
+    for (run = 0; run < BENCH_RUNS; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (i = 0; i < BENCH_READS; ++i) {
+            check(sps30_read_measurement_dev(&dev, &m), "read measurement");
+            sink += (uint32_t)m.mc_2p5;
+        }
+        std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        if (run == 0 || elapsed.count() < best)
+            best = elapsed.count();
+    }
+    return best / BENCH_READS;
+}
+
+static double bench_template(const struct memory_uart* uart) {
+    sps30::Sps30<sensirion::uart::Mock<>> sensor;
+    struct sps30_measurement m;
+    double best = 0;
+    uint32_t i;
+    int run;
+
+    sensor.transport().respond(uart->len, uart->response);
+    sensor.transport().repeat(true);
+    for (run = 0; run < BENCH_RUNS; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (i = 0; i < BENCH_READS; ++i) {
+            check(sensor.read_measurement(m), "read measurement");
+            sink += (uint32_t)m.mc_2p5;
+        }
+        std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        if (run == 0 || elapsed.count() < best)
+            best = elapsed.count();
+    }
+    return best / BENCH_READS;
+}
+
+int main(void) {
+    sensirion::uart::Mock<> encoder;
+    struct memory_uart uart;
+    uint8_t data[SPS30_MEASUREMENT_LEN];
+    double c_ns;
+    double template_ns;
+    uint8_t i;
+
+    for (i = 0; i < 10; ++i)
+        sensirion_float_to_bytes(i * 1.5f, &data[i * 4]);
+    /* encode the response frame with the mock and take it from there */
+    encoder.respond_frame(0x00, 0x03, 0, sizeof(data), data);
+    uart.len = (uint16_t)encoder.rx(sizeof(uart.response), uart.response, 0);
+    uart.pos = 0;
+
+    c_ns = bench_c(&uart);
+    template_ns = bench_template(&uart);
+    printf("%-38s %11s %11s %7s\n", "", "C driver", "template", "speedup");
+    printf("%-38s %8.1f ns %8.1f ns %6.2fx\n", "read measurement, in memory",
+           c_ns, template_ns, c_ns / template_ns);
+    return 0;
+}
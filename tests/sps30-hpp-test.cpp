@@ -0,0 +1,201 @@
+#include "sensirion_shdlc.h"
+#include "sensirion_test_setup.h"
+#include "sensirion_uart.h"
+#include "sensirion_uart_linux.h"
+#include "sensirion_uart_mock.hpp"
+#include "sensirion_uart_transport.hpp"
+#include "sps30.h"
+#include "sps30.hpp"
+#include "sps30_frames.h"
+#include "sps30_simulator.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MEASUREMENT_INTERVAL_US 10000
+
+using sensirion::uart::Mock;
+using sensirion::uart::Pty;
+using sensirion::uart::Replay;
+
+/* a measurement with bytes which need stuffing */
+static void measurement_bytes(uint8_t* data) {
+    uint8_t i;
+
+    for (i = 0; i < 10; ++i)
+        sensirion_float_to_bytes(i * 1.5f + 0.25f, &data[i * 4]);
+    data[3] = 0x7e;
+    data[7] = 0x7d;
+    data[11] = 0x11;
+}
+
+TEST_GROUP (SPS30_Hpp_Mock_Test) {
+    sps30::Sps30<Mock<>> sensor;
+};
+
+TEST (SPS30_Hpp_Mock_Test, frames_match_c_driver) {
+    const struct sps30_frame* frame;
+    uint8_t expected[SENSIRION_SHDLC_MAX_TX_FRAME_SIZE];
+    const uint8_t data[] = {0x00, 0x00, 0x09, 0x3a, 0x80};
+    uint16_t len;
+
+    sensor.transport().repeat(true);
+    CHECK_TRUE(sensor.transport().respond_frame(0x00, 0x00, 0, 0, NULL));
+    CHECK_ZERO(sensor.start_measurement());
+    frame = &sps30_frames[SPS30_FRAME_START_MEASUREMENT];
+    CHECK_EQUAL(frame->len, sensor.transport().tx_len());
+    MEMCMP_EQUAL(frame->bytes, sensor.transport().tx_data(), frame->len);
+
+    CHECK_ZERO(sensor.wake_up());
+    frame = &sps30_frames[SPS30_FRAME_WAKE_UP];
+    CHECK_EQUAL(frame->len + 1, sensor.transport().tx_len());
+    CHECK_EQUAL(0xff, sensor.transport().tx_data()[0]);
+    MEMCMP_EQUAL(frame->bytes, &sensor.transport().tx_data()[1], frame->len);
+
+    CHECK_ZERO(sensor.set_fan_auto_cleaning_interval(0x93a80));
+    len = sensirion_shdlc_encode(0x00, 0x80, sizeof(data), data, expected);
+    CHECK_EQUAL(len, sensor.transport().tx_len());
+    MEMCMP_EQUAL(expected, sensor.transport().tx_data(), len);
+    CHECK_EQUAL(3, sensor.transport().tx_count());
+}
+
+TEST (SPS30_Hpp_Mock_Test, read_measurement) {
+    uint8_t data[SPS30_MEASUREMENT_LEN];
+    struct sensirion_shdlc_rx_header header = {0x00, 0x03, 0x00, sizeof(data)};
+    struct sps30_measurement expected;
+    struct sps30_measurement m;
+    const uint8_t noise[] = {0x00, 0x13};
+
+    measurement_bytes(data);
+    CHECK_ZERO(sps30_decode_measurement(&header, data, &expected));
+
+    /* noise in front of the frame is skipped */
+    sensor.transport().respond(sizeof(noise), noise);
+    sensor.transport().respond_frame(0x00, 0x03, 0, sizeof(data), data);
+    CHECK_ZERO(sensor.read_measurement(m));
+    MEMCMP_EQUAL(&expected, &m, sizeof(m));
+    CHECK_EQUAL(1, sensor.shdlc().resync_count());
+
+    /* the device state is reported with the data */
+    sensor.transport().clear();
+    sensor.transport().respond_frame(0x00, 0x03, 0x43, sizeof(data), data);
+    CHECK_EQUAL(SPS30_ERR_STATE_MASK | 0x43, sensor.read_measurement(m));
+    MEMCMP_EQUAL(&expected, &m, sizeof(m));
+
+    /* no data before the first measurement is ready */
+    sensor.transport().clear();
+    sensor.transport().respond_frame(0x00, 0x03, 0, 0, NULL);
+    CHECK_EQUAL(SPS30_ERR_NOT_ENOUGH_DATA, sensor.read_measurement(m));
+}
+
+TEST (SPS30_Hpp_Mock_Test, frame_errors) {
+    const uint8_t bad_crc[] = {0x7e, 0x00, 0xd1, 0x00, 0x00, 0x00, 0x7e};
+    const uint8_t no_stop[] = {0x7e, 0x00, 0xd1, 0x00, 0x00, 0x2e, 0x00};
+    const uint8_t serial[] = "TESTSERIAL";
+    const uint8_t float_data[SPS30_MEASUREMENT_LEN] = {0};
+    struct sps30_version_information version;
+    struct sps30_measurement_u16 m;
+
+    sensor.transport().respond(sizeof(bad_crc), bad_crc);
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_CRC_MISMATCH, sensor.read_version(version));
+
+    sensor.transport().clear();
+    sensor.transport().respond(sizeof(no_stop), no_stop);
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_MISSING_STOP, sensor.read_version(version));
+
+    sensor.transport().clear();
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_MISSING_START, sensor.read_version(version));
+
+    /* a float measurement doesn't fit the integer format */
+    sensor.transport().respond_frame(0x00, 0x03, 0, sizeof(float_data),
+                                      float_data);
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_FRAME_TOO_LONG,
+                sensor.read_measurement_u16(m));
+
+    /* a response arriving with the previous one is kept for the next read */
+    sensor.transport().clear();
+    sensor.transport().respond_frame(0x00, 0x10, 0, 0, NULL);
+    sensor.transport().respond_frame(0x00, 0xd0, 0, sizeof(serial), serial);
+    CHECK_ZERO(sensor.sleep());
+    char received[SPS30_MAX_SERIAL_LEN];
+    CHECK_ZERO(sensor.get_serial(received));
+    STRCMP_EQUAL("TESTSERIAL", received);
+}
+
+TEST_GROUP (SPS30_Hpp_Simulator_Test) {
+    struct sps30_simulator* simulator;
+
+    void setup() {
+        struct sps30_simulator_config config = {0, MEASUREMENT_INTERVAL_US, 0,
+                                                0, 42, NULL};
+
+        simulator = sps30_simulator_start(&config);
+        CHECK_TRUE(simulator != NULL);
+    }
+
+    void teardown() {
+        sps30_simulator_stop(simulator);
+    }
+};
+
+TEST (SPS30_Hpp_Simulator_Test, pty) {
+    sps30::Sps30<Pty> sensor(sps30_simulator_path(simulator));
+    struct sps30_version_information version;
+    struct sps30_measurement expected;
+    struct sps30_measurement m;
+    uint32_t interval;
+
+    CHECK_TRUE(sensor.transport().valid());
+    CHECK_ZERO(sensor.probe());
+    CHECK_ZERO(sensor.read_version(version));
+    CHECK_EQUAL(2, version.firmware_major);
+    CHECK_ZERO(sensor.set_fan_auto_cleaning_interval(12345));
+    CHECK_ZERO(sensor.get_fan_auto_cleaning_interval(interval));
+    CHECK_EQUAL(12345, interval);
+
+    /* the port moves with the driver */
+    sps30::Sps30<Pty> moved(std::move(sensor));
+    CHECK_FALSE(sensor.transport().valid());
+    CHECK_ZERO(moved.start_measurement());
+    usleep(MEASUREMENT_INTERVAL_US);
+    CHECK_ZERO(moved.read_measurement(m));
+    sps30_simulator_last_measurement(simulator, &expected);
+    MEMCMP_EQUAL(&expected, &m, sizeof(m));
+    CHECK_ZERO(moved.stop_measurement());
+    CHECK_ZERO(moved.sleep());
+    CHECK_ZERO(moved.wake_up());
+}
+
+TEST (SPS30_Hpp_Simulator_Test, replay) {
+    char capture_path[] = "/tmp/sps30-hpp-replay-XXXXXX";
+    struct sps30_measurement captured;
+    struct sps30_measurement m;
+    struct sps30_dev dev;
+    int fd;
+
+    fd = mkstemp(capture_path);
+    CHECK_TRUE(fd >= 0);
+    close(fd);
+
+    /* captured with the C driver, replayed with the template */
+    CHECK_ZERO(
+        sensirion_uart_set_port_path(0, sps30_simulator_path(simulator)));
+    CHECK_ZERO(sensirion_uart_open_port(0));
+    CHECK_ZERO(sensirion_uart_capture_start(capture_path));
+    sps30_dev_init(&dev, &sensirion_uart_linux_ops,
+                   sensirion_uart_linux_port(0));
+    CHECK_ZERO(sps30_start_measurement_dev(&dev));
+    usleep(MEASUREMENT_INTERVAL_US);
+    CHECK_ZERO(sps30_read_measurement_dev(&dev, &captured));
+    sensirion_uart_capture_stop();
+    sensirion_uart_close_port(0);
+
+    sps30::Sps30<Replay> sensor(capture_path, (uint8_t)0, 0u);
+    unlink(capture_path);
+    CHECK_TRUE(sensor.transport().valid());
+    CHECK_ZERO(sensor.start_measurement());
+    CHECK_ZERO(sensor.read_measurement(m));
+    MEMCMP_EQUAL(&captured, &m, sizeof(m));
+    CHECK_ZERO(sensor.transport().replay().tx_mismatches);
+    CHECK_TRUE(sensirion_uart_replay_done(&sensor.transport().replay()));
+}
@@ -0,0 +1,110 @@
+/*
+ * Time to read a measurement from a replayed capture, i.e. the cost of the
+ * driver and the SHDLC decoder without waiting for a sensor. The captures are
+ * recorded from the simulator, run with `make bench`
+ */
+#include "sensirion_uart.h"
+#include "sensirion_uart_linux.h"
+#include "sensirion_uart_replay.h"
+#include "sps30.h"
+#include "sps30_simulator.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define BENCH_READS 1000
+#define BENCH_RUNS 7
+#define MEASUREMENT_INTERVAL_US 1000
+
+static volatile uint32_t sink;
+
+static void check(int16_t ret, const char* what) {
+    if (ret) {
+        fprintf(stderr, "%s failed: %d\n", what, ret);
+        exit(1);
+    }
+}
+
+/* capture a measurement session with responses in chunks of the given size */
+static void capture(const char* path, uint16_t chunk_size) {
+    struct sps30_simulator_config config = {0, MEASUREMENT_INTERVAL_US,
+                                            chunk_size, 100, 42};
+    struct sps30_measurement m;
+    struct sps30_simulator* simulator;
+    struct sps30_dev dev;
+    uint32_t i;
+
+    simulator = sps30_simulator_start(&config);
+    if (!simulator)
+        check(-1, "simulator");
+    check(sensirion_uart_set_port_path(0, sps30_simulator_path(simulator)),
+          "set port path");
+    check(sensirion_uart_select_port(0), "select port");
+    check(sensirion_uart_open(), "open");
+    sps30_dev_init(&dev, &sensirion_uart_linux_ops,
+                   sensirion_uart_linux_port(0));
+
+    check(sensirion_uart_capture_start(path), "capture");
+    check(sps30_start_measurement_dev(&dev), "start measurement");
+    for (i = 0; i < BENCH_READS; ++i) {
+        usleep(MEASUREMENT_INTERVAL_US);
+        check(sps30_read_measurement_dev(&dev, &m), "read measurement");
+    }
+    check(sps30_stop_measurement_dev(&dev), "stop measurement");
+    sensirion_uart_capture_stop();
+
+    sensirion_uart_close();
+    sps30_simulator_stop(simulator);
+}
+
+/* best of BENCH_RUNS replays in ns per measurement */
+static double bench_replay(const char* path) {
+    struct sensirion_uart_replay replay;
+    struct sps30_measurement m;
+    struct sps30_dev dev;
+    double best = 0;
+    uint32_t i;
+    int run;
+
+    check(sensirion_uart_replay_open(&replay, path, 0, 0), "replay");
+    sps30_dev_init(&dev, &sensirion_uart_replay_ops, &replay);
+    for (run = 0; run < BENCH_RUNS; ++run) {
+        sensirion_uart_replay_rewind(&replay);
+        check(sps30_start_measurement_dev(&dev), "start measurement");
+        auto start = std::chrono::steady_clock::now();
+        for (i = 0; i < BENCH_READS; ++i) {
+            check(sps30_read_measurement_dev(&dev, &m), "read measurement");
+            sink += (uint32_t)m.mc_2p5;
+        }
+        std::chrono::duration<double, std::nano> elapsed =
+            std::chrono::steady_clock::now() - start;
+        check(sps30_stop_measurement_dev(&dev), "stop measurement");
+        if (run == 0 || elapsed.count() < best)
+            best = elapsed.count();
+    }
+    if (replay.tx_mismatches || !sensirion_uart_replay_done(&replay))
+        check(-1, "replay of the capture");
+    sensirion_uart_replay_close(&replay);
+    return best / BENCH_READS;
+}
+
+int main(void) {
+    static const uint16_t chunk_sizes[] = {0, 16, 1};
+    char path[] = "/tmp/sps30-replay-bench-XXXXXX";
+    unsigned i;
+    int fd;
+
+    fd = mkstemp(path);
+    if (fd < 0)
+        check(-1, "mkstemp");
+    close(fd);
+
+    for (i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); ++i) {
+        capture(path, chunk_sizes[i]);
+        printf("replay read measurement, %3u byte chunks %8.1f ns\n",
+               chunk_sizes[i], bench_replay(path));
+    }
+    unlink(path);
+    return 0;
+}
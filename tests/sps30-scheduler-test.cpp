@@ -0,0 +1,120 @@
+#include "sensirion_test_setup.h"
+#include "sensirion_uart_fake.h"
+#include "sps30.h"
+#include "sps30_scheduler.h"
+#include <string.h>
+
+#define TEST_SENSORS 16
+#define TEST_WORKERS 4
+
+static struct fake_sensor fakes[TEST_SENSORS];
+static struct sps30_dev devs[TEST_SENSORS];
+static struct sps30_sched_sensor sensors[TEST_SENSORS];
+static struct sps30_scheduler sched;
+static uint8_t sched_initialized;
+
+static void init_sensors(void) {
+    uint16_t i;
+
+    memset(fakes, 0, sizeof(fakes));
+    memset(sensors, 0, sizeof(sensors));
+    for (i = 0; i < TEST_SENSORS; ++i) {
+        sps30_dev_init(&devs[i], &fake_sensor_ops, &fakes[i]);
+        sensors[i].dev = &devs[i];
+    }
+}
+
+/* start the scheduler on the first sensor_count sensors */
+static int16_t init_scheduler(const struct sps30_sched_config* config,
+                              uint8_t worker_count, uint16_t sensor_count) {
+    int16_t ret;
+
+    ret = sps30_scheduler_init(&sched, config, worker_count, sensor_count,
+                               sensors);
+    if (ret == 0)
+        sched_initialized = 1;
+    return ret;
+}
+
+TEST_GROUP (SPS30_Scheduler_Test) {
+    void setup() {
+        init_sensors();
+        sched_initialized = 0;
+    }
+
+    void teardown() {
+        if (sched_initialized)
+            sps30_scheduler_destroy(&sched);
+    }
+};
+
+TEST (SPS30_Scheduler_Test, measurement_cycle) {
+    struct sps30_sched_config config = {2, 1, 1, 0};
+    uint16_t i;
+
+    CHECK_ZERO(init_scheduler(&config, TEST_WORKERS, TEST_SENSORS));
+
+    /* wake up, start, read, read, stop, sleep, idle, wake up */
+    for (i = 0; i < 8; ++i) {
+        CHECK_ZERO(sps30_scheduler_run_cycle(&sched));
+        CHECK_EQUAL(i == 2 || i == 3, sensors[0].measurement_valid);
+    }
+
+    for (i = 0; i < TEST_SENSORS; ++i) {
+        CHECK_EQUAL(2, fakes[i].cmd_count[0x11]);
+        CHECK_EQUAL(1, fakes[i].cmd_count[0x00]);
+        CHECK_EQUAL(2, fakes[i].cmd_count[0x03]);
+        CHECK_EQUAL(1, fakes[i].cmd_count[0x01]);
+        CHECK_EQUAL(1, fakes[i].cmd_count[0x10]);
+        CHECK_EQUAL(2.0f, sensors[i].measurement.mc_1p0);
+    }
+}
+
+TEST (SPS30_Scheduler_Test, failed_commands_are_retried) {
+    struct sps30_sched_config config = {0, 0, 0, 1};
+
+    CHECK_ZERO(init_scheduler(&config, TEST_WORKERS, TEST_SENSORS));
+
+    /* one retry within the cycle recovers a single lost response */
+    fakes[3].ignore_count = 1;
+    CHECK_ZERO(sps30_scheduler_run_cycle(&sched));
+    CHECK_EQUAL(2, fakes[3].cmd_count[0x00]);
+
+    /* the command is repeated in the next cycle when all retries failed */
+    fakes[5].ignore_count = 2;
+    CHECK_EQUAL(1, sps30_scheduler_run_cycle(&sched));
+    CHECK(sensors[5].status != 0);
+    CHECK_ZERO(sensors[5].measurement_valid);
+    CHECK_EQUAL(1, sensors[6].measurement_valid);
+    CHECK_ZERO(sps30_scheduler_run_cycle(&sched));
+    CHECK_EQUAL(1, sensors[5].measurement_valid);
+}
+
+TEST (SPS30_Scheduler_Test, idle_workers_steal) {
+    struct sps30_sched_config config = {0, 0, 0, 0};
+    uint16_t i;
+
+    /* all sensors of the first shard are slow */
+    for (i = 0; i < TEST_SENSORS; i += TEST_WORKERS)
+        fakes[i].tx_delay_us = 20000;
+
+    CHECK_ZERO(init_scheduler(&config, TEST_WORKERS, TEST_SENSORS));
+    for (i = 0; i < 3; ++i)
+        CHECK_ZERO(sps30_scheduler_run_cycle(&sched));
+
+    CHECK(sched.steals > 0);
+    for (i = 0; i < TEST_SENSORS; ++i) {
+        CHECK_EQUAL(1, fakes[i].cmd_count[0x00]);
+        CHECK_EQUAL(2, fakes[i].cmd_count[0x03]);
+    }
+}
+
+TEST (SPS30_Scheduler_Test, invalid_arguments) {
+    struct sps30_sched_config config = {0, 0, 0, 0};
+
+    CHECK_EQUAL(-1, init_scheduler(&config, 0, TEST_SENSORS));
+    CHECK_EQUAL(-1, init_scheduler(&config, SPS30_SCHED_MAX_WORKERS + 1,
+                                   TEST_SENSORS));
+    CHECK_ZERO(init_scheduler(&config, 1, 0));
+    CHECK_ZERO(sps30_scheduler_run_cycle(&sched));
+}
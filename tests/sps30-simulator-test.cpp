@@ -0,0 +1,123 @@
+#include "sensirion_shdlc.h"
+#include "sensirion_test_setup.h"
+#include "sensirion_uart.h"
+#include "sensirion_uart_linux.h"
+#include "sps30.h"
+#include "sps30_simulator.h"
+#include <chrono>
+#include <unistd.h>
+
+#define MEASUREMENT_INTERVAL_US 10000
+
+static struct sps30_simulator* simulator;
+
+static void start_simulator(const struct sps30_simulator_config* config) {
+    simulator = sps30_simulator_start(config);
+    CHECK_TRUE(simulator != NULL);
+    CHECK_ZERO(sensirion_uart_set_port_path(0, sps30_simulator_path(simulator)));
+    CHECK_ZERO(sensirion_uart_select_port(0));
+    CHECK_ZERO(sensirion_uart_open());
+}
+
+TEST_GROUP (SPS30_Simulator_Test) {
+    void setup() {
+        struct sps30_simulator_config config = {0, MEASUREMENT_INTERVAL_US, 0,
+                                                0, 42};
+
+        start_simulator(&config);
+    }
+
+    void teardown() {
+        sensirion_uart_close();
+        sps30_simulator_stop(simulator);
+    }
+};
+
+TEST (SPS30_Simulator_Test, measurement_float) {
+    struct sps30_measurement expected;
+    struct sps30_measurement m;
+
+    CHECK_ZERO(sps30_start_measurement());
+    /* no measurement yet */
+    CHECK_EQUAL(SPS30_ERR_NOT_ENOUGH_DATA, sps30_read_measurement(&m));
+
+    usleep(MEASUREMENT_INTERVAL_US);
+    CHECK_ZERO(sps30_read_measurement(&m));
+    sps30_simulator_last_measurement(simulator, &expected);
+    MEMCMP_EQUAL(&expected, &m, sizeof(m));
+    CHECK_TRUE(m.mc_1p0 <= m.mc_2p5 && m.mc_2p5 <= m.mc_4p0 &&
+               m.mc_4p0 <= m.mc_10p0);
+
+    CHECK_ZERO(sps30_stop_measurement());
+    /* the error state of a stopped sensor comes without data */
+    CHECK_EQUAL(SPS30_ERR_NOT_ENOUGH_DATA, sps30_read_measurement(&m));
+}
+
+TEST (SPS30_Simulator_Test, measurement_u16) {
+    struct sps30_measurement expected;
+    struct sps30_measurement_u16 m;
+
+    CHECK_ZERO(sps30_start_measurement_format(SPS30_MEASUREMENT_FORMAT_UINT16));
+    usleep(MEASUREMENT_INTERVAL_US);
+    CHECK_ZERO(sps30_read_measurement_u16(&m));
+    sps30_simulator_last_measurement(simulator, &expected);
+    CHECK_EQUAL((uint16_t)(expected.mc_2p5 + 0.5f), m.mc_2p5);
+    CHECK_EQUAL((uint16_t)(expected.nc_10p0 + 0.5f), m.nc_10p0);
+    CHECK_EQUAL((uint16_t)(expected.typical_particle_size * 1000 + 0.5f),
+                m.typical_particle_size);
+    CHECK_ZERO(sps30_stop_measurement());
+}
+
+TEST (SPS30_Simulator_Test, sleep_and_wake_up) {
+    struct sps30_version_information version;
+
+    CHECK_ZERO(sps30_sleep());
+    /* a sleeping sensor only reacts to the wake-up sequence */
+    CHECK_EQUAL(SENSIRION_SHDLC_ERR_MISSING_START, sps30_read_version(&version));
+    CHECK_ZERO(sps30_wake_up());
+    CHECK_ZERO(sps30_read_version(&version));
+    CHECK_EQUAL(2, version.firmware_major);
+    CHECK_EQUAL(1, sps30_simulator_command_count(simulator, 0x11));
+}
+
+TEST (SPS30_Simulator_Test, device_info_and_settings) {
+    struct sensirion_shdlc_rx_header header;
+    struct sps30_version_information version;
+    char serial[SPS30_MAX_SERIAL_LEN];
+    uint8_t days;
+
+    CHECK_ZERO(sps30_probe());
+    CHECK_ZERO(sps30_read_device_info(serial, &version));
+    STRCMP_EQUAL("SIMULATED0000001", serial);
+
+    CHECK_ZERO(sps30_set_fan_auto_cleaning_interval_days(3));
+    CHECK_ZERO(sps30_get_fan_auto_cleaning_interval_days(&days));
+    CHECK_EQUAL(3, days);
+
+    /* fan cleaning is only allowed while measuring */
+    CHECK_ZERO(sensirion_shdlc_xcv(0x00, 0x56, 0, NULL, 0, &header, NULL));
+    CHECK_EQUAL(0x43, header.state);
+    CHECK_ZERO(sps30_start_measurement());
+    CHECK_ZERO(sensirion_shdlc_xcv(0x00, 0x56, 0, NULL, 0, &header, NULL));
+    CHECK_ZERO(header.state);
+
+    /* the reset stops the measurement */
+    CHECK_ZERO(sps30_reset());
+    CHECK_ZERO(sensirion_shdlc_xcv(0x00, 0x01, 0, NULL, 0, &header, NULL));
+    CHECK_EQUAL(0x43, header.state);
+}
+
+TEST (SPS30_Simulator_Test, slow_chunked_responses) {
+    struct sps30_simulator_config config = {5000, MEASUREMENT_INTERVAL_US, 3,
+                                            1000, 42};
+    struct sps30_version_information version;
+
+    teardown();
+    start_simulator(&config);
+
+    auto start = std::chrono::steady_clock::now();
+    CHECK_ZERO(sps30_read_version(&version));
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    CHECK_TRUE(elapsed >= std::chrono::microseconds(5000));
+    CHECK_EQUAL(2, version.firmware_major);
+}
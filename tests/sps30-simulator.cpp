@@ -0,0 +1,40 @@
+/*
+ * Run an SPS30 simulator until interrupted, e.g. to try the example usage
+ * without a sensor: `make sps30-simulator && ./sps30-simulator [delay_us]`
+ * prints the device path to point SENSIRION_UART_TTYDEV at.
+ */
+#include "sps30_simulator.h"
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t running = 1;
+
+static void stop(int signal) {
+    running = 0;
+}
+
+int main(int argc, char* argv[]) {
+    struct sps30_simulator_config config = {0, 1000000, 0, 0, 1};
+    struct sps30_simulator* sim;
+
+    if (argc > 1)
+        config.response_delay_us = (uint32_t)strtoul(argv[1], NULL, 0);
+
+    sim = sps30_simulator_start(&config);
+    if (!sim) {
+        fprintf(stderr, "Can't open a pseudo terminal\n");
+        return 1;
+    }
+    printf("%s\n", sps30_simulator_path(sim));
+    fflush(stdout);
+
+    signal(SIGINT, stop);
+    signal(SIGTERM, stop);
+    while (running)
+        pause();
+
+    sps30_simulator_stop(sim);
+    return 0;
+}
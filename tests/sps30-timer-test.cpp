@@ -0,0 +1,76 @@
+#include "sensirion_test_setup.h"
+#include "sps30_timer.h"
+#include <pthread.h>
+#include <unistd.h>
+
+#define INTERVAL_US 2000
+
+static struct sps30_timer timer;
+
+static void* cancel_later(void* arg) {
+    usleep(10000);
+    sps30_timer_cancel((struct sps30_timer*)arg);
+    return NULL;
+}
+
+TEST_GROUP (SPS30_Timer_Test) {};
+
+TEST (SPS30_Timer_Test, absolute_deadlines) {
+    uint32_t slot;
+    uint32_t prev = 0;
+    int i;
+
+    CHECK_ZERO(sps30_timer_init(&timer, INTERVAL_US,
+                                sps30_timer_now_us() + INTERVAL_US));
+    for (i = 0; i < 20; ++i) {
+        CHECK_ZERO(sps30_timer_wait(&timer, &slot));
+        CHECK_TRUE(sps30_timer_now_us() >= sps30_timer_slot_us(&timer, slot));
+        if (i)
+            CHECK_TRUE(slot > prev);
+        prev = slot;
+        /* the work between the waits does not shift the slots */
+        usleep(INTERVAL_US / 4);
+    }
+    /* every slot was either returned or counted as skipped */
+    CHECK_EQUAL(20 + timer.skipped, slot + 1);
+    sps30_timer_destroy(&timer);
+}
+
+TEST (SPS30_Timer_Test, skipped_slots) {
+    uint32_t slot;
+    uint32_t prev;
+
+    /* a start in the past makes all slots since then due at once */
+    CHECK_ZERO(sps30_timer_init(&timer, INTERVAL_US,
+                                sps30_timer_now_us() - 10 * INTERVAL_US));
+    CHECK_ZERO(sps30_timer_wait(&timer, &slot));
+    CHECK_TRUE(slot >= 10);
+    CHECK_EQUAL(slot, timer.skipped);
+
+    /* a caller which is late by three intervals misses three slots */
+    prev = slot;
+    usleep(3 * INTERVAL_US + INTERVAL_US / 2);
+    CHECK_ZERO(sps30_timer_wait(&timer, &slot));
+    CHECK_TRUE(slot >= prev + 3);
+    CHECK_EQUAL(slot, timer.skipped + 1);
+    sps30_timer_destroy(&timer);
+}
+
+TEST (SPS30_Timer_Test, cancel) {
+    pthread_t thread;
+    uint32_t slot;
+    uint64_t start = sps30_timer_now_us();
+
+    CHECK_ZERO(sps30_timer_init(&timer, 10000000, start + 10000000));
+    CHECK_ZERO(pthread_create(&thread, NULL, cancel_later, &timer));
+    CHECK_EQUAL(-1, sps30_timer_wait(&timer, &slot));
+    CHECK_TRUE(sps30_timer_now_us() - start < 5000000);
+    pthread_join(thread, NULL);
+    /* and stays cancelled */
+    CHECK_EQUAL(-1, sps30_timer_wait(&timer, &slot));
+    sps30_timer_destroy(&timer);
+}
+
+TEST (SPS30_Timer_Test, invalid_interval) {
+    CHECK_EQUAL(-1, sps30_timer_init(&timer, 0, sps30_timer_now_us()));
+}
@@ -0,0 +1,279 @@
+#include "sensirion_shdlc.h"
+#include "sensirion_test_setup.h"
+#include "sensirion_uart_fake.h"
+#include "sps30.h"
+#include "sps30_frames.h"
+#include "sps30_frames.hpp"
+#include <string.h>
+
+/*
+ * Tests of the SPS30 driver against the fake UART HAL, checking the bytes on
+ * the wire
+ */
+
+static_assert(sps30::frames::read_measurement.len == 6, "");
+static_assert(sps30::frames::read_measurement.bytes[4] == 0xfc, "");
+static_assert(sps30::frames::wake_up.bytes[2] == 0x7d, "cmd 0x11 is stuffed");
+
+/* queue a response frame with the given data */
+static void queue_response(uint8_t cmd, uint8_t data_len, const uint8_t* data) {
+    uint8_t frame[2 + (4 + 255 + 1) * 2];
+
+    fake_uart_rx_append(frame,
+                        fake_encode_response(cmd, 0, data_len, data, frame));
+}
+
+/* a UART port for the reentrant API, independent of the fake UART HAL */
+struct test_port {
+    uint8_t rx_buf[128];
+    uint16_t rx_len;
+    uint16_t rx_pos;
+    uint8_t tx_buf[128];
+    uint16_t tx_len;
+};
+
+static int16_t test_port_tx(void* ctx, uint16_t data_len, const uint8_t* data) {
+    struct test_port* port = (struct test_port*)ctx;
+
+    memcpy(&port->tx_buf[port->tx_len], data, data_len);
+    port->tx_len += data_len;
+    return (int16_t)data_len;
+}
+
+static int16_t test_port_txv(void* ctx, uint8_t iovcnt,
+                             const struct sensirion_uart_iovec* iov) {
+    uint16_t len = 0;
+
+    for (; iovcnt; --iovcnt, ++iov)
+        len += (uint16_t)test_port_tx(ctx, iov->len, iov->data);
+    return (int16_t)len;
+}
+
+static int16_t test_port_rx_timeout(void* ctx, uint16_t max_data_len,
+                                    uint8_t* data, uint32_t timeout_us) {
+    struct test_port* port = (struct test_port*)ctx;
+    uint16_t len = port->rx_len - port->rx_pos;
+
+    if (len > max_data_len)
+        len = max_data_len;
+    memcpy(data, &port->rx_buf[port->rx_pos], len);
+    port->rx_pos += len;
+    return (int16_t)len;
+}
+
+static const struct sensirion_uart_ops test_port_ops = {
+    test_port_tx,
+    test_port_txv,
+    test_port_rx_timeout,
+};
+
+TEST_GROUP (SPS30_Mock_Test) {
+    void setup() {
+        fake_uart_reset();
+    }
+};
+
+TEST (SPS30_Mock_Test, frames_match_encoder) {
+    static const struct {
+        enum sps30_frame_id id;
+        uint8_t cmd;
+        uint8_t data_len;
+        uint8_t data[2];
+    } commands[] = {
+        {SPS30_FRAME_START_MEASUREMENT, 0x00, 2, {0x01, 0x03}},
+        {SPS30_FRAME_START_MEASUREMENT_UINT16, 0x00, 2, {0x01, 0x05}},
+        {SPS30_FRAME_STOP_MEASUREMENT, 0x01, 0, {0}},
+        {SPS30_FRAME_READ_MEASUREMENT, 0x03, 0, {0}},
+        {SPS30_FRAME_SLEEP, 0x10, 0, {0}},
+        {SPS30_FRAME_WAKE_UP, 0x11, 0, {0}},
+        {SPS30_FRAME_GET_FAN_CLEAN_INTV, 0x80, 1, {0x00}},
+        {SPS30_FRAME_START_FAN_CLEANING, 0x56, 0, {0}},
+        {SPS30_FRAME_GET_SERIAL, 0xd0, 1, {0x03}},
+        {SPS30_FRAME_READ_VERSION, 0xd1, 0, {0}},
+        {SPS30_FRAME_RESET, 0xd3, 0, {0}},
+    };
+    uint8_t frame[SENSIRION_SHDLC_MAX_TX_FRAME_SIZE];
+    uint16_t len;
+    size_t i;
+
+    CHECK_EQUAL(SPS30_FRAME_COUNT, sizeof(commands) / sizeof(commands[0]));
+    for (i = 0; i < sizeof(commands) / sizeof(commands[0]); ++i) {
+        const struct sps30_frame* expected = &sps30_frames[commands[i].id];
+
+        len = sensirion_shdlc_encode(0x00, commands[i].cmd,
+                                     commands[i].data_len, commands[i].data,
+                                     frame);
+        CHECK_EQUAL(commands[i].cmd, expected->cmd);
+        CHECK_EQUAL(len, expected->len);
+        MEMCMP_EQUAL(frame, expected->bytes, len);
+    }
+}
+
+/* the generated C table must be up to date with sps30_frames.hpp */
+template <size_t MaxLen>
+static void check_frame(enum sps30_frame_id id,
+                        const sensirion::shdlc::Frame<MaxLen>& expected) {
+    CHECK_EQUAL(expected.cmd, sps30_frames[id].cmd);
+    CHECK_EQUAL(expected.len, sps30_frames[id].len);
+    MEMCMP_EQUAL(expected.bytes, sps30_frames[id].bytes, expected.len);
+}
+
+TEST (SPS30_Mock_Test, frames_match_constexpr) {
+    using namespace sps30::frames;
+
+    check_frame(SPS30_FRAME_START_MEASUREMENT, start_measurement);
+    check_frame(SPS30_FRAME_START_MEASUREMENT_UINT16, start_measurement_uint16);
+    check_frame(SPS30_FRAME_STOP_MEASUREMENT, stop_measurement);
+    check_frame(SPS30_FRAME_READ_MEASUREMENT, read_measurement);
+    check_frame(SPS30_FRAME_SLEEP, sleep);
+    check_frame(SPS30_FRAME_WAKE_UP, wake_up);
+    check_frame(SPS30_FRAME_GET_FAN_CLEAN_INTV, get_fan_clean_interval);
+    check_frame(SPS30_FRAME_START_FAN_CLEANING, start_fan_cleaning);
+    check_frame(SPS30_FRAME_GET_SERIAL, get_serial);
+    check_frame(SPS30_FRAME_READ_VERSION, read_version);
+    check_frame(SPS30_FRAME_RESET, reset);
+}
+
+TEST (SPS30_Mock_Test, read_measurement) {
+    const uint8_t read_measurement[] = {0x7e, 0x00, 0x03, 0x00, 0xfc, 0x7e};
+    struct sps30_measurement m;
+    uint8_t data[40];
+    uint8_t i;
+
+    for (i = 0; i < 10; ++i)
+        sensirion_float_to_bytes((float)i, &data[i * 4]);
+    queue_response(0x03, sizeof(data), data);
+
+    CHECK_ZERO(sps30_read_measurement(&m));
+    CHECK_EQUAL(sizeof(read_measurement), fake_tx_len);
+    MEMCMP_EQUAL(read_measurement, fake_tx_buf, sizeof(read_measurement));
+    DOUBLES_EQUAL(2.0, m.mc_4p0, 0.0);
+    DOUBLES_EQUAL(9.0, m.typical_particle_size, 0.0);
+}
+
+/* the functions without suffix share the SHDLC default device */
+TEST (SPS30_Mock_Test, read_measurement_resync) {
+    const uint8_t noise[] = {0x00, 0x42, 0x13};
+    struct sps30_measurement m;
+    uint8_t data[40];
+    uint32_t resyncs;
+
+    memset(data, 0, sizeof(data));
+    sensirion_float_to_bytes(1.5f, &data[4]);
+    fake_uart_rx_append(noise, sizeof(noise));
+    queue_response(0x03, sizeof(data), data);
+
+    resyncs = sensirion_shdlc_rx_resync_count();
+    CHECK_ZERO(sps30_read_measurement(&m));
+    DOUBLES_EQUAL(1.5, m.mc_2p5, 0.0);
+    CHECK_EQUAL(resyncs + 1, sensirion_shdlc_rx_resync_count());
+}
+
+TEST (SPS30_Mock_Test, measurement_u16) {
+    const uint8_t start_u16[] = {0x7e, 0x00, 0x00, 0x02, 0x01,
+                                 0x05, 0xf7, 0x7e};
+    struct sps30_measurement_u16 m;
+    uint8_t data[20];
+    uint8_t i;
+
+    queue_response(0x00, 0, NULL);
+    CHECK_ZERO(sps30_start_measurement_format(SPS30_MEASUREMENT_FORMAT_UINT16));
+    CHECK_EQUAL(sizeof(start_u16), fake_tx_len);
+    MEMCMP_EQUAL(start_u16, fake_tx_buf, sizeof(start_u16));
+
+    for (i = 0; i < 10; ++i) {
+        data[i * 2] = i;
+        data[i * 2 + 1] = 0x10 + i;
+    }
+    queue_response(0x03, sizeof(data), data);
+    CHECK_ZERO(sps30_read_measurement_u16(&m));
+    CHECK_EQUAL(0x0212, m.mc_4p0);
+    CHECK_EQUAL(0x0919, m.typical_particle_size);
+
+    CHECK_EQUAL(SPS30_ERR_INVALID_FORMAT, sps30_start_measurement_format(0));
+}
+
+/* responses received by other means than the sps30_*() functions */
+TEST (SPS30_Mock_Test, decode_responses) {
+    struct sensirion_shdlc_rx_header header = {0x00, 0xd0, 0x00, 0};
+    struct sps30_version_information version;
+    struct sps30_measurement_u16 m;
+    char serial[SPS30_MAX_SERIAL_LEN];
+    uint8_t data[SPS30_MAX_SERIAL_LEN];
+
+    /* an unterminated serial number is cut short */
+    memset(data, 'A', sizeof(data));
+    header.data_len = sizeof(data);
+    CHECK_ZERO(sps30_decode_serial(&header, data, serial));
+    CHECK_EQUAL(SPS30_MAX_SERIAL_LEN - 1, strlen(serial));
+
+    header.data_len = SPS30_VERSION_LEN - 1;
+    CHECK_EQUAL(SPS30_ERR_NOT_ENOUGH_DATA,
+                sps30_decode_version(&header, data, &version));
+    header.data_len = SPS30_VERSION_LEN;
+    header.state = 0x43;
+    CHECK_EQUAL(SPS30_ERR_STATE_MASK | 0x43,
+                sps30_decode_version(&header, data, &version));
+
+    header.data_len = SPS30_MEASUREMENT_U16_LEN;
+    CHECK_EQUAL(SPS30_ERR_STATE_MASK | 0x43,
+                sps30_decode_measurement_u16(&header, data, &m));
+    CHECK_EQUAL(0x4141, m.nc_10p0);
+}
+
+TEST (SPS30_Mock_Test, wake_up) {
+    const uint8_t wake_up[] = {0xff, 0x7e, 0x00, 0x7d, 0x31, 0x00, 0xee, 0x7e};
+
+    queue_response(0x11, 0, NULL);
+    CHECK_ZERO(sps30_wake_up());
+    CHECK_EQUAL(1, fake_tx_calls);
+    CHECK_EQUAL(sizeof(wake_up), fake_tx_len);
+    MEMCMP_EQUAL(wake_up, fake_tx_buf, sizeof(wake_up));
+}
+
+TEST (SPS30_Mock_Test, read_device_info) {
+    const char serial_data[] = "ECBBEEC8D8D650F3";
+    const uint8_t version_data[] = {0x02, 0x02, 0x00, 0x07, 0x00, 0x02, 0x00};
+    struct sps30_version_information version;
+    char serial[SPS30_MAX_SERIAL_LEN];
+
+    /* both commands are sent before the first response is received */
+    queue_response(0xd0, sizeof(serial_data), (const uint8_t*)serial_data);
+    queue_response(0xd1, sizeof(version_data), version_data);
+    CHECK_ZERO(sps30_read_device_info(serial, &version));
+    CHECK_EQUAL(2, fake_tx_calls);
+    STRCMP_EQUAL(serial_data, serial);
+    CHECK_EQUAL(2, version.firmware_major);
+    CHECK_EQUAL(7, version.hardware_revision);
+}
+
+TEST (SPS30_Mock_Test, devices_are_independent) {
+    const uint8_t read_measurement[] = {0x7e, 0x00, 0x03, 0x00, 0xfc, 0x7e};
+    struct test_port ports[2];
+    struct sps30_dev devs[2];
+    struct sps30_measurement m;
+    uint8_t data[40];
+    uint8_t i;
+
+    memset(ports, 0, sizeof(ports));
+    for (i = 0; i < 2; ++i) {
+        sps30_dev_init(&devs[i], &test_port_ops, &ports[i]);
+        memset(data, 0, sizeof(data));
+        sensirion_float_to_bytes(10.0f * (i + 1), &data[4]);
+        ports[i].rx_len =
+            fake_encode_response(0x03, 0, sizeof(data), data, ports[i].rx_buf);
+    }
+
+    CHECK_ZERO(sps30_read_measurement_dev(&devs[1], &m));
+    DOUBLES_EQUAL(20.0, m.mc_2p5, 0.0);
+    CHECK_ZERO(sps30_read_measurement_dev(&devs[0], &m));
+    DOUBLES_EQUAL(10.0, m.mc_2p5, 0.0);
+
+    for (i = 0; i < 2; ++i) {
+        CHECK_EQUAL(sizeof(read_measurement), ports[i].tx_len);
+        MEMCMP_EQUAL(read_measurement, ports[i].tx_buf,
+                     sizeof(read_measurement));
+    }
+    /* the global HAL is not touched */
+    CHECK_EQUAL(0, fake_tx_calls);
+}
@@ -1,6 +1,13 @@
 #include "sensirion_test_setup.h"
 #include "sps30.h"
 
+#ifdef SPS30_TEST_SIMULATOR
+#include "sensirion_uart_linux.h"
+#include "sps30_simulator.h"
+
+static struct sps30_simulator* simulator;
+#endif
+
 // Measurement ranges according to datasheet
 #define SPS30_MIN_MC 0
 #define SPS30_MAX_MC 1000
@@ -20,6 +27,12 @@ TEST_GROUP (SPS30_Test) {
     void setup() {
         int16_t error;
 
+#ifdef SPS30_TEST_SIMULATOR
+        simulator = sps30_simulator_start(NULL);
+        CHECK_TRUE(simulator != NULL);
+        CHECK_ZERO(
+            sensirion_uart_set_port_path(0, sps30_simulator_path(simulator)));
+#endif
         error = sensirion_uart_open();
         CHECK_ZERO_TEXT(error, "sensirion_uart_open");
     }
@@ -32,6 +45,9 @@ TEST_GROUP (SPS30_Test) {
         sensirion_sleep_usec(CMD_DELAY_USEC);
         sensirion_uart_close();
         CHECK_ZERO_TEXT(error, "sensirion_uart_close");
+#ifdef SPS30_TEST_SIMULATOR
+        sps30_simulator_stop(simulator);
+#endif
     }
 };
 
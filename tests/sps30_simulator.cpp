@@ -0,0 +1,408 @@
+#include "sps30_simulator.h"
+#include "sensirion_shdlc.h"
+#include "sensirion_uart_fake.h"
+#include "sensirion_uart_pty.h"
+#include <atomic>
+#include <chrono>
+#include <fcntl.h>
+#include <mutex>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+
+#define SIM_CMD_START_MEASUREMENT 0x00
+#define SIM_CMD_STOP_MEASUREMENT 0x01
+#define SIM_CMD_READ_MEASUREMENT 0x03
+#define SIM_CMD_SLEEP 0x10
+#define SIM_CMD_WAKE_UP 0x11
+#define SIM_CMD_FAN_CLEAN_INTV 0x80
+#define SIM_CMD_START_FAN_CLEANING 0x56
+#define SIM_CMD_DEV_INFO 0xd0
+#define SIM_CMD_READ_VERSION 0xd1
+#define SIM_CMD_RESET 0xd3
+
+/* SHDLC states of the response */
+#define SIM_STATE_WRONG_LENGTH 0x01
+#define SIM_STATE_UNKNOWN_CMD 0x02
+#define SIM_STATE_ILLEGAL_PARAM 0x04
+#define SIM_STATE_NOT_ALLOWED 0x43
+
+#define SIM_DEFAULT_FAN_CLEAN_INTV (7 * 24 * 60 * 60)
+
+typedef std::chrono::steady_clock sim_clock;
+
+enum sim_mode {
+    SIM_MODE_IDLE,
+    SIM_MODE_MEASURING,
+    SIM_MODE_SLEEPING,
+};
+
+struct sps30_simulator {
+    struct sps30_simulator_config config;
+    int master;
+    int slave;
+    char path[64];
+    std::thread thread;
+    std::atomic<bool> running;
+
+    /* receive state */
+    uint8_t frame[2 * (4 + 255) + 2];
+    uint16_t frame_len;
+    bool in_frame;
+    bool escape;
+
+    /* device state */
+    enum sim_mode mode;
+    bool uart_awake;
+    uint8_t format;
+    uint32_t fan_clean_interval;
+    sim_clock::time_point measurement_start;
+    uint32_t measurements_read;
+    uint32_t rng;
+
+    std::atomic<uint32_t> command_counts[256];
+    mutable std::mutex lock;
+    struct sps30_measurement last_measurement;
+};
+
+static uint32_t sim_random(struct sps30_simulator* sim) {
+    /* xorshift32 */
+    sim->rng ^= sim->rng << 13;
+    sim->rng ^= sim->rng >> 17;
+    sim->rng ^= sim->rng << 5;
+    return sim->rng;
+}
+
+/* uniform in [0, scale) */
+static float sim_uniform(struct sps30_simulator* sim, float scale) {
+    return (float)(sim_random(sim) >> 8) / (float)(1 << 24) * scale;
+}
+
+/* concentrations grow with the particle size, like on a real sensor */
+static void sim_measure(struct sps30_simulator* sim,
+                        struct sps30_measurement* m) {
+    m->mc_1p0 = 2.0f + sim_uniform(sim, 20.0f);
+    m->mc_2p5 = m->mc_1p0 + sim_uniform(sim, 5.0f);
+    m->mc_4p0 = m->mc_2p5 + sim_uniform(sim, 2.0f);
+    m->mc_10p0 = m->mc_4p0 + sim_uniform(sim, 1.0f);
+    m->nc_0p5 = m->mc_1p0 * (6.0f + sim_uniform(sim, 2.0f));
+    m->nc_1p0 = m->nc_0p5 + sim_uniform(sim, 10.0f);
+    m->nc_2p5 = m->nc_1p0 + sim_uniform(sim, 1.0f);
+    m->nc_4p0 = m->nc_2p5 + sim_uniform(sim, 0.5f);
+    m->nc_10p0 = m->nc_4p0 + sim_uniform(sim, 0.1f);
+    m->typical_particle_size = 0.3f + sim_uniform(sim, 0.7f);
+}
+
+static uint16_t sim_round(float value) {
+    return (uint16_t)(value + 0.5f);
+}
+
+static void sim_send(struct sps30_simulator* sim, uint8_t cmd, uint8_t state,
+                     uint8_t data_len, const uint8_t* data) {
+    uint8_t frame[2 * (4 + 255 + 1) + 2];
+    uint16_t len;
+    uint16_t chunk;
+    uint16_t pos;
+
+    len = fake_encode_response(cmd, state, data_len, data, frame);
+    if (sim->config.response_delay_us)
+        usleep(sim->config.response_delay_us);
+    chunk = sim->config.tx_chunk_size ? sim->config.tx_chunk_size : len;
+    for (pos = 0; pos < len; pos = (uint16_t)(pos + chunk)) {
+        if (pos && sim->config.tx_chunk_gap_us)
+            usleep(sim->config.tx_chunk_gap_us);
+        if (write(sim->master, &frame[pos],
+                  pos + chunk > len ? len - pos : chunk) < 0)
+            return;
+    }
+}
+
+/* number of measurements completed since the measurement was started */
+static uint32_t sim_measurements_done(struct sps30_simulator* sim) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        sim_clock::now() - sim->measurement_start);
+
+    if (!sim->config.measurement_interval_us)
+        return UINT32_MAX;
+    return (uint32_t)((uint64_t)elapsed.count() /
+                      sim->config.measurement_interval_us);
+}
+
+static void sim_read_measurement(struct sps30_simulator* sim) {
+    struct sps30_measurement m;
+    uint8_t data[SPS30_MEASUREMENT_LEN];
+    const float* values = &m.mc_1p0;
+    uint8_t i;
+
+    if (sim->mode != SIM_MODE_MEASURING) {
+        sim_send(sim, SIM_CMD_READ_MEASUREMENT, SIM_STATE_NOT_ALLOWED, 0, NULL);
+        return;
+    }
+    if (sim->measurements_read >= sim_measurements_done(sim)) {
+        /* no new measurement since the last read */
+        sim_send(sim, SIM_CMD_READ_MEASUREMENT, 0, 0, NULL);
+        return;
+    }
+    ++sim->measurements_read;
+
+    sim_measure(sim, &m);
+    {
+        std::lock_guard<std::mutex> guard(sim->lock);
+        sim->last_measurement = m;
+    }
+    if (sim->format == SPS30_MEASUREMENT_FORMAT_UINT16) {
+        for (i = 0; i < 10; ++i) {
+            /* mass and number concentrations are rounded, the typical
+             * particle size is sent in nm */
+            uint16_t value = sim_round(i < 9 ? values[i] : values[i] * 1000);
+            data[2 * i] = (uint8_t)(value >> 8);
+            data[2 * i + 1] = (uint8_t)value;
+        }
+        sim_send(sim, SIM_CMD_READ_MEASUREMENT, 0, 20, data);
+    } else {
+        for (i = 0; i < 10; ++i)
+            sensirion_float_to_bytes(values[i], &data[4 * i]);
+        sim_send(sim, SIM_CMD_READ_MEASUREMENT, 0, sizeof(data), data);
+    }
+}
+
+static void sim_command(struct sps30_simulator* sim, uint8_t cmd,
+                        uint8_t data_len, const uint8_t* data) {
+    static const uint8_t version[] = {2, 2, 0, 7, 0, 2, 0};
+    const char* serial =
+        sim->config.serial ? sim->config.serial : "SIMULATED0000001";
+    static const char product_type[] = "00080000";
+    uint8_t buf[4];
+
+    if (sim->mode == SIM_MODE_SLEEPING) {
+        /* only the wake-up command is answered after waking up the UART */
+        if (cmd != SIM_CMD_WAKE_UP || !sim->uart_awake)
+            return;
+        sim->mode = SIM_MODE_IDLE;
+        sim_send(sim, cmd, 0, 0, NULL);
+        return;
+    }
+
+    switch (cmd) {
+        case SIM_CMD_START_MEASUREMENT:
+            if (data_len != 2 || data[0] != 0x01) {
+                sim_send(sim, cmd, SIM_STATE_WRONG_LENGTH, 0, NULL);
+            } else if (data[1] != SPS30_MEASUREMENT_FORMAT_FLOAT &&
+                       data[1] != SPS30_MEASUREMENT_FORMAT_UINT16) {
+                sim_send(sim, cmd, SIM_STATE_ILLEGAL_PARAM, 0, NULL);
+            } else if (sim->mode != SIM_MODE_IDLE) {
+                sim_send(sim, cmd, SIM_STATE_NOT_ALLOWED, 0, NULL);
+            } else {
+                sim->mode = SIM_MODE_MEASURING;
+                sim->format = data[1];
+                sim->measurement_start = sim_clock::now();
+                sim->measurements_read = 0;
+                sim_send(sim, cmd, 0, 0, NULL);
+            }
+            break;
+
+        case SIM_CMD_STOP_MEASUREMENT:
+            if (sim->mode != SIM_MODE_MEASURING) {
+                sim_send(sim, cmd, SIM_STATE_NOT_ALLOWED, 0, NULL);
+                break;
+            }
+            sim->mode = SIM_MODE_IDLE;
+            sim_send(sim, cmd, 0, 0, NULL);
+            break;
+
+        case SIM_CMD_READ_MEASUREMENT:
+            sim_read_measurement(sim);
+            break;
+
+        case SIM_CMD_SLEEP:
+            if (sim->mode != SIM_MODE_IDLE) {
+                sim_send(sim, cmd, SIM_STATE_NOT_ALLOWED, 0, NULL);
+                break;
+            }
+            sim_send(sim, cmd, 0, 0, NULL);
+            sim->mode = SIM_MODE_SLEEPING;
+            sim->uart_awake = false;
+            break;
+
+        case SIM_CMD_WAKE_UP:
+            sim_send(sim, cmd, 0, 0, NULL);
+            break;
+
+        case SIM_CMD_FAN_CLEAN_INTV:
+            if (data_len == 1 && data[0] == 0x00) {
+                sensirion_uint32_t_to_bytes(sim->fan_clean_interval, buf);
+                sim_send(sim, cmd, 0, sizeof(buf), buf);
+            } else if (data_len == 5 && data[0] == 0x00) {
+                sim->fan_clean_interval = ((uint32_t)data[1] << 24) |
+                                          ((uint32_t)data[2] << 16) |
+                                          ((uint32_t)data[3] << 8) | data[4];
+                sim_send(sim, cmd, 0, 0, NULL);
+            } else {
+                sim_send(sim, cmd, SIM_STATE_WRONG_LENGTH, 0, NULL);
+            }
+            break;
+
+        case SIM_CMD_START_FAN_CLEANING:
+            if (sim->mode != SIM_MODE_MEASURING) {
+                sim_send(sim, cmd, SIM_STATE_NOT_ALLOWED, 0, NULL);
+                break;
+            }
+            sim_send(sim, cmd, 0, 0, NULL);
+            break;
+
+        case SIM_CMD_DEV_INFO:
+            if (data_len == 1 && data[0] == 0x00)
+                sim_send(sim, cmd, 0, sizeof(product_type),
+                         (const uint8_t*)product_type);
+            else if (data_len == 1 && data[0] == 0x03)
+                sim_send(sim, cmd, 0, (uint8_t)(strlen(serial) + 1),
+                         (const uint8_t*)serial);
+            else
+                sim_send(sim, cmd, SIM_STATE_ILLEGAL_PARAM, 0, NULL);
+            break;
+
+        case SIM_CMD_READ_VERSION:
+            sim_send(sim, cmd, 0, sizeof(version), version);
+            break;
+
+        case SIM_CMD_RESET:
+            sim_send(sim, cmd, 0, 0, NULL);
+            sim->mode = SIM_MODE_IDLE;
+            break;
+
+        default:
+            sim_send(sim, cmd, SIM_STATE_UNKNOWN_CMD, 0, NULL);
+    }
+}
+
+/**
+ * Handle a complete, un-stuffed MOSI frame: addr, cmd, len, data, checksum.
+ * Return: false if the frame is invalid
+ */
+static bool sim_frame(struct sps30_simulator* sim) {
+    uint8_t sum = 0;
+    uint16_t i;
+
+    if (sim->frame_len < 4 || sim->frame_len != 4u + sim->frame[2])
+        return false;
+    for (i = 0; i < sim->frame_len; ++i)
+        sum += sim->frame[i];
+    if (sum != 0xff)
+        return false;
+
+    /* a sensor stays silent on frames for other addresses */
+    if (sim->frame[0] == 0x00) {
+        ++sim->command_counts[sim->frame[1]];
+        sim_command(sim, sim->frame[1], sim->frame[2], &sim->frame[3]);
+    }
+    return true;
+}
+
+static void sim_receive(struct sps30_simulator* sim, uint8_t byte) {
+    if (sim->mode == SIM_MODE_SLEEPING && !sim->uart_awake) {
+        /* the first byte only wakes up the UART, e.g. the 0xFF wake byte */
+        sim->uart_awake = true;
+        return;
+    }
+
+    if (byte == 0x7e) {
+        /* after garbage, the stop byte is taken as the start of a frame */
+        sim->in_frame = !(sim->in_frame && sim->frame_len && sim_frame(sim));
+        sim->frame_len = 0;
+        sim->escape = false;
+        return;
+    }
+    if (!sim->in_frame)
+        return;
+    if (byte == 0x7d) {
+        sim->escape = true;
+        return;
+    }
+    if (sim->escape) {
+        byte ^= 0x20;
+        sim->escape = false;
+    }
+    if (sim->frame_len < sizeof(sim->frame))
+        sim->frame[sim->frame_len++] = byte;
+}
+
+static void sim_run(struct sps30_simulator* sim) {
+    struct pollfd pfd;
+    uint8_t buf[256];
+    ssize_t len;
+    ssize_t i;
+
+    pfd.fd = sim->master;
+    pfd.events = POLLIN;
+    while (sim->running) {
+        if (poll(&pfd, 1, 10) <= 0)
+            continue;
+        len = read(sim->master, buf, sizeof(buf));
+        for (i = 0; i < len; ++i)
+            sim_receive(sim, buf[i]);
+    }
+}
+
+struct sps30_simulator*
+sps30_simulator_start(const struct sps30_simulator_config* config) {
+    struct sps30_simulator* sim = new sps30_simulator();
+    struct termios options;
+
+    if (config) {
+        sim->config = *config;
+    } else {
+        memset(&sim->config, 0, sizeof(sim->config));
+        sim->config.measurement_interval_us = 1000000;
+    }
+    sim->rng = sim->config.seed ? sim->config.seed : 1;
+    sim->mode = SIM_MODE_IDLE;
+    sim->format = SPS30_MEASUREMENT_FORMAT_FLOAT;
+    sim->fan_clean_interval = SIM_DEFAULT_FAN_CLEAN_INTV;
+    for (auto& count : sim->command_counts)
+        count = 0;
+
+    sim->master = pty_open(sim->path, sizeof(sim->path));
+    if (sim->master < 0) {
+        delete sim;
+        return NULL;
+    }
+
+    /* keep the slave open so the master never sees a hang-up while the HAL
+     * reopens the port, and make it raw until the HAL configures it */
+    sim->slave = open(sim->path, O_RDWR | O_NOCTTY);
+    if (sim->slave >= 0 && !tcgetattr(sim->slave, &options)) {
+        cfmakeraw(&options);
+        tcsetattr(sim->slave, TCSANOW, &options);
+    }
+
+    sim->running = true;
+    sim->thread = std::thread(sim_run, sim);
+    return sim;
+}
+
+void sps30_simulator_stop(struct sps30_simulator* sim) {
+    sim->running = false;
+    sim->thread.join();
+    if (sim->slave >= 0)
+        close(sim->slave);
+    close(sim->master);
+    delete sim;
+}
+
+const char* sps30_simulator_path(const struct sps30_simulator* sim) {
+    return sim->path;
+}
+
+uint32_t sps30_simulator_command_count(const struct sps30_simulator* sim,
+                                       uint8_t cmd) {
+    return sim->command_counts[cmd];
+}
+
+void sps30_simulator_last_measurement(const struct sps30_simulator* sim,
+                                      struct sps30_measurement* measurement) {
+    std::lock_guard<std::mutex> guard(sim->lock);
+    *measurement = sim->last_measurement;
+}
@@ -0,0 +1,50 @@
+/*
+ * SPS30 simulator on a pseudo terminal: point the Linux UART HAL at
+ * sps30_simulator_path() and talk to it like to a sensor
+ */
+#ifndef SPS30_SIMULATOR_H
+#define SPS30_SIMULATOR_H
+
+#include "sensirion_arch_config.h"
+#include "sps30.h"
+
+/**
+ * @response_delay_us:  time between receiving a command and responding
+ * @measurement_interval_us: time between two new measurements, 1s on a real
+ *                      sensor
+ * @tx_chunk_size:      respond in chunks of this many bytes, 0 for the whole
+ *                      frame at once
+ * @tx_chunk_gap_us:    pause between two chunks
+ * @seed:               seed of the synthetic particle data
+ * @serial:             serial number, NULL for "SIMULATED0000001"
+ */
+struct sps30_simulator_config {
+    uint32_t response_delay_us;
+    uint32_t measurement_interval_us;
+    uint16_t tx_chunk_size;
+    uint32_t tx_chunk_gap_us;
+    uint32_t seed;
+    const char* serial;
+};
+
+struct sps30_simulator;
+
+/* start a simulator with the given or, if NULL, the default configuration */
+struct sps30_simulator*
+sps30_simulator_start(const struct sps30_simulator_config* config);
+
+/* stop the simulator and close the pseudo terminal */
+void sps30_simulator_stop(struct sps30_simulator* sim);
+
+/* device path of the slave side */
+const char* sps30_simulator_path(const struct sps30_simulator* sim);
+
+/* number of valid frames received with the given command */
+uint32_t sps30_simulator_command_count(const struct sps30_simulator* sim,
+                                       uint8_t cmd);
+
+/* the measurement sent last, in float format */
+void sps30_simulator_last_measurement(const struct sps30_simulator* sim,
+                                      struct sps30_measurement* measurement);
+
+#endif /* SPS30_SIMULATOR_H */